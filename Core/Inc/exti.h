@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    exti.h
+  * @brief   外部中断 (EXTI) 驱动头文件 - 边沿中断 + 定时器消抖按键
+  ******************************************************************************
+  * EXTI_Attach() 把任意引脚映射到同号的 EXTI 线 (AFIO_EXTICR 选择端口),
+  * 边沿到来时在中断中调用回调。
+  *
+  * 按键 (Button_*) 建立在 EXTI 之上: 边沿中断只屏蔽该线并启动 TIM1,
+  * 消抖时间到后由 TIM1 中断采样引脚, 把按下/释放/长按事件放入队列,
+  * 主循环用 Button_GetEvent() 取出。没有按键活动时 TIM1 停止,
+  * 空闲时不占用 CPU。
+  ******************************************************************************
+  */
+
+#ifndef __EXTI_H
+#define __EXTI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+
+/* 最多同时使用的按键数 */
+#define BUTTON_MAX              4
+
+/* 消抖时间 (ms): 边沿之后等待此时间再采样 */
+#define BUTTON_DEBOUNCE_MS      20
+
+/* 长按时间 (ms): 按住超过此时间产生一次 BUTTON_LONG_PRESS */
+#define BUTTON_LONG_MS          1000
+
+/* 事件队列深度 (必须是2的幂) */
+#define BUTTON_QUEUE_SIZE       16
+
+/* EXTI 和 TIM1 中断优先级: 两者必须相同, 互相不能抢占 */
+#define EXTI_IRQ_PRIORITY       8
+
+/* 触发边沿 */
+typedef enum
+{
+    EXTI_EDGE_RISING = 1,   /* 上升沿 */
+    EXTI_EDGE_FALLING = 2,  /* 下降沿 */
+    EXTI_EDGE_BOTH = 3      /* 双边沿 */
+} EXTI_Edge_t;
+
+/* 边沿回调 (在中断中调用), 参数为触发的引脚 (GPIO_PIN_x) */
+typedef void (*EXTI_Callback_t)(uint16_t GPIO_Pin);
+
+/* 按键事件类型 */
+typedef enum
+{
+    BUTTON_PRESS = 0,       /* 按下 (消抖后) */
+    BUTTON_RELEASE,         /* 释放 (消抖后) */
+    BUTTON_LONG_PRESS       /* 按住超过 BUTTON_LONG_MS */
+} Button_EventType_t;
+
+/* 按键事件 */
+typedef struct
+{
+    uint8_t id;                 /* Button_Add() 返回的编号 */
+    Button_EventType_t type;
+} Button_Event_t;
+
+/* 函数原型: EXTI */
+ErrorStatus EXTI_Attach(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, EXTI_Edge_t edge, EXTI_Callback_t callback);
+void EXTI_Detach(uint16_t GPIO_Pin);
+void EXTI_Enable(uint16_t GPIO_Pin);
+void EXTI_Disable(uint16_t GPIO_Pin);
+
+/* 函数原型: 按键 */
+int8_t Button_Add(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint8_t active_low);
+uint8_t Button_GetEvent(Button_Event_t *event);
+uint8_t Button_IsPressed(uint8_t id);
+uint32_t Button_Dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EXTI_H */
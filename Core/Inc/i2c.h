@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    i2c.h
+  * @brief   I2C 主机驱动头文件 - 事务队列 + 中断/DMA 数据传输
+  ******************************************************************************
+  */
+
+#ifndef __I2C_H
+#define __I2C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+
+/* I2C 速率 */
+#define I2C_SPEED_STANDARD  100000  /* 标准模式 100kHz */
+#define I2C_SPEED_FAST      400000  /* 快速模式 400kHz */
+
+/* 每条总线的事务队列深度 */
+#define I2C_QUEUE_SIZE      8
+
+/* 数据阶段长度 >= 此值时使用 DMA, 否则中断逐字节收发 (DMA 接收要求至少2字节) */
+#define I2C_DMA_THRESHOLD   4
+
+/* 单个事务超时 (ms), 由 I2C_Watchdog() 检查 */
+#define I2C_TIMEOUT_MS      10
+
+/* 等待上一事务 STOP 发出的最长时间 (us), 超时以 I2C_ERR_BUS 结束 */
+#define I2C_STOP_TIMEOUT_US 100
+
+/* 事务状态 */
+typedef enum
+{
+    I2C_OK = 0,         /* 成功 */
+    I2C_PENDING,        /* 排队中或正在传输 */
+    I2C_ERR_NACK,       /* 从机无应答 */
+    I2C_ERR_BUS,        /* 总线错误 (非法 START/STOP) */
+    I2C_ERR_ARLO,       /* 仲裁丢失 */
+    I2C_ERR_OVR,        /* 上溢/下溢 */
+    I2C_ERR_TIMEOUT     /* 超时, 总线在下次 I2C_Watchdog() 中复位 */
+} I2C_Status_t;
+
+typedef struct I2C_Transfer I2C_Transfer_t;
+
+/* 完成回调, 在中断上下文中调用 */
+typedef void (*I2C_Callback_t)(I2C_Transfer_t *xfer);
+
+/* I2C 事务: 只写 (rx_len = 0), 只读 (tx_len = 0), 或先写后读 (重复起始条件)
+ * 事务结构体和数据缓冲区由调用者提供, 在完成前必须保持有效 */
+struct I2C_Transfer
+{
+    uint8_t addr;                   /* 7位从机地址 */
+    const uint8_t *tx_buf;          /* 写数据 */
+    uint16_t tx_len;
+    uint8_t *rx_buf;                /* 读数据 */
+    uint16_t rx_len;
+    I2C_Callback_t callback;        /* 完成回调, 可为 NULL */
+    void *user;                     /* 回调使用的用户数据 */
+    volatile I2C_Status_t status;   /* 由驱动更新 */
+};
+
+/* 函数原型 */
+void I2C_Init(I2C_TypeDef *I2Cx, uint32_t speed);
+uint8_t I2C_IsInit(I2C_TypeDef *I2Cx);
+ErrorStatus I2C_Submit(I2C_TypeDef *I2Cx, I2C_Transfer_t *xfer);
+I2C_Status_t I2C_Wait(I2C_Transfer_t *xfer);
+uint8_t I2C_IsIdle(I2C_TypeDef *I2Cx);
+void I2C_Watchdog(void);
+void I2C_Recover(I2C_TypeDef *I2Cx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __I2C_H */
@@ -1,7 +1,11 @@
 /**
   ******************************************************************************
   * @file    lcd1602.h
-  * @brief   LCD1602 字符显示屏驱动 (4位并口模式)
+  * @brief   HD44780 字符显示屏驱动 (4位模式, 并口或 I2C 转接板)
+  ******************************************************************************
+  * 驱动以显示屏句柄 (LCD_Handle_t) 为单位工作, 支持 16x2, 16x4, 20x4, 40x2 等尺寸。
+  * 多块并口显示屏共用 RS/RW/D4-D7, 各自使用独立的 EN 引脚。
+  * LCD1602_* 接口操作默认显示屏 (PB8-PB14, LCD_ROWS x LCD_COLS), 与旧版本兼容。
   ******************************************************************************
   */
 
@@ -14,7 +18,8 @@ extern "C" {
 
 #include "stm32f1xx.h"
 
-/* LCD1602 引脚配置 (可根据实际硬件修改) */
+/* LCD1602 引脚配置 (可根据实际硬件修改)
+ * RS/RW/D4-D7 为所有并口显示屏共用, LCD_EN 为默认显示屏的使能引脚 */
 #define LCD_RS_PORT     GPIOB
 #define LCD_RS_PIN      GPIO_PIN_12
 
@@ -36,6 +41,47 @@ extern "C" {
 #define LCD_D7_PORT     GPIOB
 #define LCD_D7_PIN      GPIO_PIN_11
 
+/* D4-D7 位于同一端口且引脚号连续 (如 PB8-PB11) 时为1, 编译期常量:
+ * 为1时用一次 BSRR 写入同时输出4根数据线, 否则逐个引脚写入 */
+#define LCD_DATA_CONTIGUOUS ((LCD_D5_PORT == LCD_D4_PORT) &&            \
+                             (LCD_D6_PORT == LCD_D4_PORT) &&            \
+                             (LCD_D7_PORT == LCD_D4_PORT) &&            \
+                             (LCD_D5_PIN == (LCD_D4_PIN << 1)) &&       \
+                             (LCD_D6_PIN == (LCD_D4_PIN << 2)) &&       \
+                             (LCD_D7_PIN == (LCD_D4_PIN << 3)))
+
+/* 上电后控制器就绪所需时间 (ms), 从 Delay_Init() 起算 */
+#define LCD_POWERUP_MS      50
+
+/* 忙标志查询: 1 = 初始化完成后默认查询 BF (需要 RW 引脚已连接) */
+#define LCD_USE_BUSY_FLAG   0
+
+/* 忙标志最大查询次数 (每次约 2us+, 需覆盖清屏的 1.52ms), 超时后回退到固定延时 */
+#define LCD_BUSY_POLL_MAX   1000
+
+/* 后台异步刷新: TIM4 每个节拍输出一个半字节, 队列长度须为2的幂 */
+#define LCD_ASYNC_TICK_US       20
+#define LCD_ASYNC_QUEUE_SIZE    64
+
+/* 后台异步刷新最多同时服务的显示屏数量 */
+#define LCD_MAX_DISPLAYS        4
+
+/* 字形缓存: 使用 CGRAM 槽位 LCD_GLYPH_FIRST_SLOT-7, 更低的槽位留给 LCD1602_CreateChar();
+ * 在缓存槽位上调用 CreateChar() 会固定该槽位, 之后缓存不再使用它 (1-7) */
+#define LCD_GLYPH_FIRST_SLOT    2
+
+/* 所有槽位都在屏幕上使用中时返回的替代字符 (0xFF = 全黑方块) */
+#define LCD_GLYPH_FALLBACK      ((char)0xFF)
+
+/* 默认显示屏尺寸 (LCD1602_* 接口) */
+#define LCD_ROWS        2
+#define LCD_COLS        16
+
+/* 单块显示屏的最大尺寸 (帧缓冲按此分配 RAM): 20x4 和 40x2 均为 80 个字符 */
+#define LCD_MAX_ROWS    4
+#define LCD_MAX_COLS    40
+#define LCD_MAX_CELLS   80
+
 /* LCD1602 命令 */
 #define LCD_CMD_CLEAR           0x01  /* 清屏 */
 #define LCD_CMD_HOME            0x02  /* 光标回home */
@@ -46,8 +92,110 @@ extern "C" {
 #define LCD_CMD_CURSOR_BLINK    0x0F  /* 显示开，光标闪烁 */
 #define LCD_CMD_FUNCTION_SET    0x28  /* 4位接口，2行，5x7点阵 */
 
-/* 函数原型 */
+typedef struct LCD_Handle LCD_Handle_t;
+
+/* 传输层: 负责把半字节/字节送到 LCD, 驱动其余部分与接线方式无关 */
+typedef struct
+{
+    void (*init)(LCD_Handle_t *lcd);                             /* 配置引脚或总线 */
+    void (*write_nibble)(LCD_Handle_t *lcd, uint8_t nibble);     /* 初始化序列: 单个半字节, RS = 0 */
+    void (*write)(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs); /* 连续写入, 每字节满足执行时间 */
+    uint8_t busy_flag;                                           /* 1 = 支持忙标志查询 */
+} LCD_Transport_t;
+
+/* 默认传输层: 并口 (支持忙标志和 TIM4 后台刷新) */
+extern const LCD_Transport_t LCD_TransportGPIO;
+
+/* 异步状态机 */
+typedef enum
+{
+    LCD_ASYNC_IDLE = 0,     /* 取下一项, 输出高4位并拉高 EN */
+    LCD_ASYNC_LOW,          /* EN 下降沿锁存高4位, 输出低4位并拉高 EN */
+    LCD_ASYNC_LATCH,        /* EN 下降沿锁存低4位, 开始等待执行时间 */
+    LCD_ASYNC_WAIT          /* 等待 LCD 执行命令 */
+} LCD_AsyncState_t;
+
+/* 显示屏句柄: 前半部分由应用配置 (见 LCD_HANDLE_GPIO), 其余由驱动维护 */
+struct LCD_Handle
+{
+    /* 配置 */
+    uint8_t rows;                           /* 行数 (1-4) */
+    uint8_t cols;                           /* 列数, rows x cols 不超过 LCD_MAX_CELLS */
+    const LCD_Transport_t *transport;
+    GPIO_TypeDef *en_port;                  /* 并口: EN 引脚 */
+    uint16_t en_pin;
+    I2C_TypeDef *i2c;                       /* I2C 转接板: 总线, 地址, 背光位 */
+    uint8_t i2c_addr;
+    uint8_t backlight;
+
+    /* 驱动状态 */
+    uint8_t init_step;                      /* 分步初始化进度, 0 = 未初始化 */
+    uint64_t init_due;                      /* 下一步的时间 (Delay_GetMicros) */
+    uint8_t busy_mode;                      /* 1 = 写入后查询忙标志 */
+    uint8_t ddram_addr;                     /* 软件跟踪的 DDRAM 地址 */
+    uint8_t cgram_mode;                     /* 1 = 地址计数器当前指向 CGRAM */
+    uint8_t fb_invalid;                     /* 1 = LCD 内容未知, 下次刷新全部重写 */
+    char fb[LCD_MAX_CELLS];                 /* 应用写入的目标内容 */
+    char shadow[LCD_MAX_CELLS];             /* LCD 上实际显示的内容 */
+
+    const uint8_t *glyph_key[8 - LCD_GLYPH_FIRST_SLOT];
+    uint32_t glyph_used[8 - LCD_GLYPH_FIRST_SLOT];
+    uint8_t glyph_pinned;                   /* 位 i = 缓存槽位 i 已被 CreateChar() 占用 */
+    uint32_t glyph_clock;
+    uint32_t glyph_uploads;
+
+    volatile uint16_t async_queue[LCD_ASYNC_QUEUE_SIZE];
+    volatile uint16_t async_head;           /* 仅应用写 */
+    volatile uint16_t async_tail;           /* 仅中断写 */
+    volatile LCD_AsyncState_t async_state;
+    uint16_t async_item;
+    uint16_t async_wait;
+};
+
+/* 并口显示屏句柄初始化, 如 LCD_Handle_t lcd2 = LCD_HANDLE_GPIO(4, 20, GPIOA, GPIO_PIN_8); */
+#define LCD_HANDLE_GPIO(r, c, port, pin) \
+    { .rows = (r), .cols = (c), .transport = &LCD_TransportGPIO, .en_port = (port), .en_pin = (pin) }
+
+/* 句柄接口: 任意显示屏 */
+void LCD_Init(LCD_Handle_t *lcd);
+void LCD_InitStart(LCD_Handle_t *lcd);
+uint32_t LCD_InitStep(LCD_Handle_t *lcd);
+void LCD_Clear(LCD_Handle_t *lcd);
+void LCD_SetCursor(LCD_Handle_t *lcd, uint8_t row, uint8_t col);
+void LCD_Print(LCD_Handle_t *lcd, const char *str);
+void LCD_PrintChar(LCD_Handle_t *lcd, char ch);
+void LCD_Printf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, ...);
+void LCD_CreateChar(LCD_Handle_t *lcd, uint8_t location, const uint8_t charmap[8]);
+void LCD_DisplayOn(LCD_Handle_t *lcd);
+void LCD_DisplayOff(LCD_Handle_t *lcd);
+void LCD_SetBusyFlagMode(LCD_Handle_t *lcd, uint8_t enable);
+uint8_t LCD_GetBusyFlagMode(LCD_Handle_t *lcd);
+
+void LCD_FB_Clear(LCD_Handle_t *lcd);
+void LCD_FB_PutChar(LCD_Handle_t *lcd, uint8_t row, uint8_t col, char ch);
+void LCD_FB_Print(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *str);
+void LCD_FB_Printf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, ...);
+void LCD_FB_Invalidate(LCD_Handle_t *lcd);
+uint16_t LCD_FB_Flush(LCD_Handle_t *lcd);
+uint16_t LCD_FB_FlushAsync(LCD_Handle_t *lcd);
+
+char LCD_Glyph(LCD_Handle_t *lcd, const uint8_t glyph[8]);
+void LCD_GlyphReset(LCD_Handle_t *lcd);
+uint32_t LCD_GlyphUploads(LCD_Handle_t *lcd);
+
+void LCD_AsyncInit(LCD_Handle_t *lcd);
+ErrorStatus LCD_AsyncClear(LCD_Handle_t *lcd);
+ErrorStatus LCD_AsyncSetCursor(LCD_Handle_t *lcd, uint8_t row, uint8_t col);
+ErrorStatus LCD_AsyncPrint(LCD_Handle_t *lcd, const char *str);
+uint16_t LCD_AsyncFree(LCD_Handle_t *lcd);
+uint8_t LCD_AsyncBusy(LCD_Handle_t *lcd);
+
+/* 函数原型: 默认显示屏 */
+LCD_Handle_t *LCD1602_Handle(void);
+void LCD1602_SetTransport(const LCD_Transport_t *transport);
 void LCD1602_Init(void);
+void LCD1602_InitStart(void);
+uint32_t LCD1602_InitStep(void);
 void LCD1602_Clear(void);
 void LCD1602_SetCursor(uint8_t row, uint8_t col);
 void LCD1602_Print(const char *str);
@@ -56,10 +204,33 @@ void LCD1602_Printf(uint8_t row, uint8_t col, const char *format, ...);
 void LCD1602_CreateChar(uint8_t location, uint8_t charmap[8]);
 void LCD1602_DisplayOn(void);
 void LCD1602_DisplayOff(void);
+void LCD1602_SetBusyFlagMode(uint8_t enable);
+uint8_t LCD1602_GetBusyFlagMode(void);
+
+/* 帧缓冲: 先写 RAM, 再由 LCD1602_FB_Flush() 只发送有变化的字符 */
+void LCD1602_FB_Clear(void);
+void LCD1602_FB_PutChar(uint8_t row, uint8_t col, char ch);
+void LCD1602_FB_Print(uint8_t row, uint8_t col, const char *str);
+void LCD1602_FB_Printf(uint8_t row, uint8_t col, const char *format, ...);
+void LCD1602_FB_Invalidate(void);
+uint16_t LCD1602_FB_Flush(void);
+uint16_t LCD1602_FB_FlushAsync(void);
+
+/* CGRAM 字形缓存: 任意数量的字形按 LRU 映射到 8 个槽位 */
+char LCD1602_Glyph(const uint8_t glyph[8]);
+void LCD1602_GlyphReset(void);
+uint32_t LCD1602_GlyphUploads(void);
+
+/* 后台异步写入: 应用只负责入队, TIM4 中断按 LCD 时序逐个半字节发送 (仅并口传输层) */
+void LCD1602_AsyncInit(void);
+ErrorStatus LCD1602_AsyncClear(void);
+ErrorStatus LCD1602_AsyncSetCursor(uint8_t row, uint8_t col);
+ErrorStatus LCD1602_AsyncPrint(const char *str);
+uint16_t LCD1602_AsyncFree(void);
+uint8_t LCD1602_AsyncBusy(void);
 
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* __LCD1602_H */
-
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    lcd_pcf8574.h
+  * @brief   LCD1602 I2C 转接板 (PCF8574) 传输层
+  ******************************************************************************
+  */
+
+#ifndef __LCD_PCF8574_H
+#define __LCD_PCF8574_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "lcd1602.h"
+#include "i2c.h"
+
+/* 默认 I2C 地址: PCF8574T = 0x27, PCF8574AT = 0x3F (A0-A2 全部悬空) */
+#define LCD_PCF8574_ADDR        0x27
+
+/* 总线速率: 400kHz 时相邻两个字节的锁存间隔约 45us, 大于 LCD 的 37us 执行时间 */
+#define LCD_PCF8574_SPEED       I2C_SPEED_FAST
+
+/* 一次 I2C 传输最多携带的字符数 (每字符 4 字节), 更长的字符串分多次传输 */
+#define LCD_PCF8574_BURST_CHARS 20
+
+/* 转接板引脚映射: P0 = RS, P1 = RW, P2 = EN, P3 = 背光, P4-P7 = D4-D7 */
+#define LCD_PCF8574_RS          0x01
+#define LCD_PCF8574_RW          0x02
+#define LCD_PCF8574_EN          0x04
+#define LCD_PCF8574_BL          0x08
+
+/* I2C 转接板传输层 (不支持忙标志和 TIM4 后台刷新) */
+extern const LCD_Transport_t LCD_TransportPCF8574;
+
+/* 转接板显示屏句柄初始化, 如 LCD_Handle_t lcd2 = LCD_HANDLE_PCF8574(4, 20, I2C1, 0x26); */
+#define LCD_HANDLE_PCF8574(r, c, bus, addr) \
+    { .rows = (r), .cols = (c), .transport = &LCD_TransportPCF8574, \
+      .i2c = (bus), .i2c_addr = (addr), .backlight = LCD_PCF8574_BL }
+
+/* 函数原型 */
+void LCD_PCF8574_Config(I2C_TypeDef *I2Cx, uint8_t addr);
+void LCD_PCF8574_SetBacklight(uint8_t on);
+void LCD_PCF8574_Backlight(LCD_Handle_t *lcd, uint8_t on);
+I2C_Status_t LCD_PCF8574_GetStatus(void);
+uint32_t LCD_PCF8574_GetLastWriteUs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCD_PCF8574_H */
@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * @file    lcd_widget.h
+  * @brief   LCD1602 图形控件 - 条形图, 迷你折线图, 大号数字
+  ******************************************************************************
+  * 控件只写入 LCD1602 帧缓冲, 由 LCD1602_FB_Flush() / LCD1602_FB_FlushAsync()
+  * 统一刷新: 数值变化时只有受影响的字符会发送到 LCD。
+  * 自定义字符通过字形缓存 (LCD1602_Glyph) 分配, 缓存使用 CGRAM 的
+  * 8 - LCD_GLYPH_FIRST_SLOT 个槽位 (默认 6 个),
+  * 同屏使用的不同字形超过槽位数时多出的字符显示为 LCD_GLYPH_FALLBACK。
+  * 各控件同屏占用的槽位: 条形图 1 个 (部分格变化时短暂占 2 个),
+  * 迷你折线图 3 个, 大号数字 3 个; 任意两种控件组合都不超过 6 个。
+  * 默认绘制到 LCD1602_Handle(), 多块显示屏时用 Widget_SetTarget() 切换。
+  ******************************************************************************
+  */
+
+#ifndef __LCD_WIDGET_H
+#define __LCD_WIDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "lcd1602.h"
+
+/* 迷你折线图: 5 级高度 (每级 2 像素, 0 级为空格, 最高级为整格),
+   只需 3 个自定义字符, 与条形图或大号数字同屏时不超出字形缓存 */
+#define WIDGET_SPARK_LEVELS     5
+
+/* 大号数字: 每个数字占 3 列 x 2 行, 数字间空 1 列 */
+#define WIDGET_BIG_WIDTH        3
+
+/* 迷你折线图状态 */
+typedef struct
+{
+    uint8_t row;
+    uint8_t col;
+    uint8_t width;                  /* 显示宽度 (字符数), 每个字符一个采样 */
+    uint8_t count;                  /* 已有采样数 */
+    uint8_t level[LCD_MAX_COLS];    /* 采样高度 (0 ~ WIDGET_SPARK_LEVELS-1), 最新在末尾 */
+} Widget_Spark_t;
+
+/* 函数原型 */
+void Widget_SetTarget(LCD_Handle_t *lcd);
+void Widget_Bar(uint8_t row, uint8_t col, uint8_t width, uint32_t value, uint32_t max);
+void Widget_SparkInit(Widget_Spark_t *spark, uint8_t row, uint8_t col, uint8_t width);
+void Widget_SparkPush(Widget_Spark_t *spark, uint32_t value, uint32_t max);
+void Widget_BigNumber(uint8_t row, uint8_t col, uint32_t value, uint8_t digits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCD_WIDGET_H */
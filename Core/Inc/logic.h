@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file    logic.h
+  * @brief   逻辑分析仪驱动头文件 - 定时器触发 DMA 并行采集 GPIO 端口
+  ******************************************************************************
+  * 定时器每个更新事件发出一次 DMA 请求, DMA 把 GPIOx->IDR 的 16 位
+  * 读入 RAM 环形缓冲区, 采样过程不需要 CPU 参与。
+  *
+  * 触发: EXTI 引脚边沿 (或 Logic_Trigger() 软件触发) 记下当前 DMA 位置,
+  * 之后 DMA 半满/全满中断检查触发后样本是否已够, 够了就停止定时器。
+  * 停止位置最多滞后半个缓冲区, 因此 pre + post 不能超过 LOGIC_SAMPLES / 2。
+  *
+  * 导出: Logic_ExportVCD() 通过 UART 输出 VCD 文本, 主机端用
+  * tools/logic_vcd.py 保存为 .vcd 文件, 可用 GTKWave / PulseView 打开。
+  ******************************************************************************
+  */
+
+#ifndef __LOGIC_H
+#define __LOGIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "exti.h"
+
+/* 采样定时器: 2 = TIM2 + DMA1 通道2, 3 = TIM3 + DMA1 通道3
+ * (TIM1/TIM4 的更新请求在通道5/7, 已被 I2C DMA 占用)
+ * 采集期间该定时器不能再用于舵机 (TIM2) 或电机 (TIM3) PWM */
+#define LOGIC_TIMER             2
+
+/* 缓冲区样本数 (每样本 16 位), 默认 4096 = 8KB RAM, 最大 65534 且为偶数 */
+#define LOGIC_SAMPLES           4096
+
+/* 最高采样率 = 定时器时钟 / LOGIC_MIN_DIV (72MHz / 8 = 9MHz)
+ * 实际可持续速率受总线负载影响, 见 docs/PERIPHERAL_GUIDE.md */
+#define LOGIC_MIN_DIV           8
+
+/* 触发引脚在被采集的端口上时, 在触发位置之前最多向前搜索多少个样本
+ * 找到真实边沿 (补偿 EXTI 中断延迟) */
+#define LOGIC_TRIG_SEARCH       64
+
+/* 采集状态 */
+typedef enum
+{
+    LOGIC_IDLE = 0,         /* 未启动 */
+    LOGIC_ARMED,            /* 正在采样, 等待触发 */
+    LOGIC_TRIGGERED,        /* 已触发, 采集触发后样本 */
+    LOGIC_DONE              /* 采集完成, 数据可读 */
+} Logic_State_t;
+
+/* 采集结果 */
+typedef struct
+{
+    GPIO_TypeDef *port;     /* 被采集的端口 */
+    uint16_t mask;          /* 导出的通道 (GPIO_PIN_x 位掩码) */
+    uint32_t rate;          /* 实际采样率 (Hz) */
+    uint16_t count;         /* 有效样本数 */
+    uint16_t trigger;       /* 触发样本序号 (0 ~ count) */
+    uint32_t written;       /* 从启动到停止 DMA 共写入的样本数 */
+} Logic_Capture_t;
+
+/* 函数原型 */
+uint32_t Logic_Init(GPIO_TypeDef *GPIOx, uint16_t mask, uint32_t rate);
+ErrorStatus Logic_Arm(uint16_t pre, uint16_t post,
+                      GPIO_TypeDef *trig_port, uint16_t trig_pin, EXTI_Edge_t edge);
+void Logic_Trigger(void);
+void Logic_Abort(void);
+Logic_State_t Logic_GetState(void);
+const Logic_Capture_t *Logic_GetCapture(void);
+uint16_t Logic_GetSample(uint16_t index);
+void Logic_ExportVCD(USART_TypeDef *USARTx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOGIC_H */
@@ -37,6 +37,9 @@ void PWM_Init(TIM_TypeDef *TIMx, uint32_t frequency);
 void PWM_SetDutyCycle(TIM_TypeDef *TIMx, PWM_Channel_t channel, float duty_cycle);
 void PWM_Start(TIM_TypeDef *TIMx, PWM_Channel_t channel);
 void PWM_Stop(TIM_TypeDef *TIMx, PWM_Channel_t channel);
+uint32_t PWM_GetTimerClock(TIM_TypeDef *TIMx);
+uint32_t PWM_SetCountRate(TIM_TypeDef *TIMx, uint32_t rate);
+uint32_t PWM_SetTimebase(TIM_TypeDef *TIMx, uint32_t frequency);
 
 /* 电机控制函数 */
 void Motor_Init(void);
@@ -7,23 +7,31 @@
 
 #include "adc.h"
 #include "gpio.h"
+#include "bitband.h"
+#include "delay.h"
+#include "profile.h"
 
-/* ADC 寄存器位定义 */
-#define ADC_CR2_ADON        (1 << 0)   /* ADC 使能 */
-#define ADC_CR2_CAL         (1 << 3)   /* ADC 校准 */
-#define ADC_CR2_RSTCAL      (1 << 4)   /* 复位校准 */
-#define ADC_CR2_SWSTART     (1 << 22)  /* 软件启动转换 */
-#define ADC_SR_EOC          (1 << 1)   /* 转换结束标志 */
+/* ADC 寄存器位序号 (通过位带别名单独读写) */
+#define ADC_CR2_ADON_BIT    0    /* ADC 使能 */
+#define ADC_CR2_CAL_BIT     3    /* ADC 校准 */
+#define ADC_CR2_RSTCAL_BIT  4    /* 复位校准 */
+#define ADC_CR2_SWSTART_BIT 22   /* 软件启动转换 */
+#define ADC_SR_EOC_BIT      1    /* 转换结束标志 */
+
+/* PA0-PA7 模拟输入 (编译期计算的 CRL 掩码, 一次写入) */
+static const GPIO_PortConfig_t adc_pins =
+    GPIO_PORT_CONFIG(GPIOA, GPIO_CR_MASK(0x00FF),
+                     GPIO_CR_VALUE(0x00FF, GPIO_MODE_INPUT, GPIO_CNF_INPUT_ANALOG));
 
 /**
   * @brief  初始化 ADC
-  * @note   配置 ADC1, 使用软件触发, 单次转换模式
+  * @note   配置 ADC1, 使用软件触发, 单次转换模式; 须在 Delay_Init() 之后调用
   * @retval None
   */
 void ADC_Init(void)
 {
     /* 使能时钟 */
-    RCC->APB2ENR |= (1 << 9);   /* ADC1 时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;   /* ADC1 时钟 */
     RCC->APB2ENR |= (1 << 2);   /* GPIOA 时钟 */
     
     /* 配置 ADC 时钟分频 PCLK2/6 = 72MHz/6 = 12MHz */
@@ -32,14 +40,7 @@ void ADC_Init(void)
     
     /* 配置 GPIO 为模拟输入 
      * PA0-PA7 对应 ADC1_IN0 到 ADC1_IN7 */
-    GPIO_Init(GPIOA, GPIO_PIN_0, GPIO_MODE_INPUT, 0);  /* 模拟输入 CNF=00 */
-    GPIO_Init(GPIOA, GPIO_PIN_1, GPIO_MODE_INPUT, 0);
-    GPIO_Init(GPIOA, GPIO_PIN_2, GPIO_MODE_INPUT, 0);
-    GPIO_Init(GPIOA, GPIO_PIN_3, GPIO_MODE_INPUT, 0);
-    GPIO_Init(GPIOA, GPIO_PIN_4, GPIO_MODE_INPUT, 0);
-    GPIO_Init(GPIOA, GPIO_PIN_5, GPIO_MODE_INPUT, 0);
-    GPIO_Init(GPIOA, GPIO_PIN_6, GPIO_MODE_INPUT, 0);
-    GPIO_Init(GPIOA, GPIO_PIN_7, GPIO_MODE_INPUT, 0);
+    GPIO_InitPort(&adc_pins);
     
     /* ADC 配置 */
     /* CR1: 独立模式 */
@@ -56,17 +57,17 @@ void ADC_Init(void)
     ADC1->SMPR1 = 0x00FFFFFF;
     
     /* 使能 ADC */
-    ADC1->CR2 |= ADC_CR2_ADON;
+    BITBAND_PERI(ADC1->CR2, ADC_CR2_ADON_BIT) = 1;
     
-    /* 延时等待稳定 */
-    for(volatile uint32_t i = 0; i < 10000; i++);
+    /* 上电稳定时间 tSTAB 最长 1us, 校准前还需至少 2 个 ADC 时钟 */
+    Delay_Us(2);
     
     /* 校准 ADC */
-    ADC1->CR2 |= ADC_CR2_RSTCAL;           /* 复位校准 */
-    while(ADC1->CR2 & ADC_CR2_RSTCAL);     /* 等待复位完成 */
+    BITBAND_PERI(ADC1->CR2, ADC_CR2_RSTCAL_BIT) = 1;        /* 复位校准 */
+    while(BITBAND_PERI(ADC1->CR2, ADC_CR2_RSTCAL_BIT));     /* 等待复位完成 */
     
-    ADC1->CR2 |= ADC_CR2_CAL;              /* 开始校准 */
-    while(ADC1->CR2 & ADC_CR2_CAL);        /* 等待校准完成 */
+    BITBAND_PERI(ADC1->CR2, ADC_CR2_CAL_BIT) = 1;           /* 开始校准 */
+    while(BITBAND_PERI(ADC1->CR2, ADC_CR2_CAL_BIT));        /* 等待校准完成 */
 }
 
 /**
@@ -76,14 +77,16 @@ void ADC_Init(void)
   */
 uint16_t ADC_Read(uint8_t channel)
 {
+    PROFILE_SCOPE(PROFILE_ZONE_ADC_READ);
+    
     /* 设置转换通道 */
     ADC1->SQR3 = channel;
     
-    /* 启动转换 */
-    ADC1->CR2 |= ADC_CR2_SWSTART;
+    /* 启动转换 (位带写入, 地址为常量, 单条 STR) */
+    BITBAND_PERI(ADC1->CR2, ADC_CR2_SWSTART_BIT) = 1;
     
-    /* 等待转换完成 */
-    while(!(ADC1->SR & ADC_SR_EOC));
+    /* 等待转换完成 (位带读取直接得到 0/1, 不需要掩码) */
+    while(!BITBAND_PERI(ADC1->SR, ADC_SR_EOC_BIT));
     
     /* 读取转换结果 */
     return ADC1->DR;
@@ -0,0 +1,420 @@
+/**
+  ******************************************************************************
+  * @file    exti.c
+  * @brief   外部中断 (EXTI) 驱动实现 - 边沿中断 + 定时器消抖按键
+  ******************************************************************************
+  */
+
+#include "exti.h"
+#include "gpio.h"
+#include "bitband.h"
+#include "pwm.h"
+#include "monitor.h"
+#include <stddef.h>
+
+#if (BUTTON_QUEUE_SIZE & (BUTTON_QUEUE_SIZE - 1)) != 0 || BUTTON_QUEUE_SIZE > 128
+#error "BUTTON_QUEUE_SIZE must be a power of 2, at most 128"
+#endif
+
+/* TIM 寄存器位定义 */
+#define TIM_CR1_CEN_BIT     0          /* 计数器使能 (位带访问) */
+#define TIM_DIER_UIE        (1 << 0)   /* 更新中断使能 */
+#define TIM_SR_UIF          (1 << 0)   /* 更新中断标志 */
+
+/* 每条 EXTI 线的配置 */
+typedef struct
+{
+    GPIO_TypeDef *port;
+    EXTI_Callback_t callback;
+} EXTI_Line_t;
+
+/* 按键状态 */
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint8_t line;               /* 引脚序号 = EXTI 线号 */
+    uint8_t active_low;         /* 1 = 按下时为低电平 (上拉输入) */
+    volatile uint8_t pressed;   /* 消抖后的稳定状态 */
+    uint16_t debounce;          /* 剩余消抖时间 (ms), 0 = 未在消抖 */
+    uint16_t held;              /* 按下持续时间 (ms), 到 BUTTON_LONG_MS 后停止计数 */
+} Button_t;
+
+static EXTI_Line_t exti_line[16];
+
+static Button_t button[BUTTON_MAX];
+static uint8_t button_count = 0;
+static uint8_t button_of_line[16];
+
+/* 事件队列: TIM1 中断写入, 主循环读取 */
+static volatile Button_Event_t button_queue[BUTTON_QUEUE_SIZE];
+static volatile uint8_t button_head = 0;    /* 仅中断写 */
+static volatile uint8_t button_tail = 0;    /* 仅主循环写 */
+static volatile uint32_t button_dropped = 0;
+
+/* 私有函数声明 */
+static uint32_t EXTI_PortIndex(GPIO_TypeDef *GPIOx);
+static IRQn_Type EXTI_IRQn(uint8_t line);
+static void EXTI_Dispatch(uint32_t lines);
+static void Button_TimerInit(void);
+static void Button_Edge(uint16_t GPIO_Pin);
+static void Button_Push(uint8_t id, Button_EventType_t type);
+
+/**
+  * @brief  把引脚连接到 EXTI 线并使能边沿中断
+  * @param  GPIOx: GPIO 端口 (引脚须已配置为输入)
+  * @param  GPIO_Pin: 单个引脚 (GPIO_PIN_0 ~ GPIO_PIN_15)
+  * @param  edge: 触发边沿
+  * @param  callback: 边沿回调 (在中断中调用)
+  * @note   EXTI 线号等于引脚序号, 不同端口的同号引脚 (如 PA3 和 PB3) 不能同时使用
+  * @retval SUCCESS = 已连接, ERROR = 引脚无效或该线已被占用
+  *
+  * 示例: EXTI_Attach(GPIOB, GPIO_PIN_5, EXTI_EDGE_FALLING, OnPulse);
+  */
+ErrorStatus EXTI_Attach(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, EXTI_Edge_t edge, EXTI_Callback_t callback)
+{
+    uint8_t line;
+    uint32_t shift;
+    IRQn_Type irq;
+
+    if(GPIO_Pin == 0 || (GPIO_Pin & (GPIO_Pin - 1)) != 0 || callback == NULL)
+        return ERROR;
+
+    line = (uint8_t)__builtin_ctz(GPIO_Pin);
+    if(exti_line[line].callback != NULL)
+        return ERROR;
+
+    RCC->APB2ENR |= RCC_APB2ENR_AFIOEN;
+
+    /* 配置期间屏蔽该线 */
+    BITBAND_PERI(EXTI->IMR, line) = 0;
+
+    /* AFIO_EXTICRx: 每条线 4 位, 选择端口 (0 = GPIOA, 1 = GPIOB, ...) */
+    shift = (line & 3) * 4;
+    AFIO->EXTICR[line >> 2] = (AFIO->EXTICR[line >> 2] & ~(0xFUL << shift)) |
+                              (EXTI_PortIndex(GPIOx) << shift);
+
+    BITBAND_PERI(EXTI->RTSR, line) = (edge & EXTI_EDGE_RISING) ? 1 : 0;
+    BITBAND_PERI(EXTI->FTSR, line) = (edge & EXTI_EDGE_FALLING) ? 1 : 0;
+
+    exti_line[line].port = GPIOx;
+    exti_line[line].callback = callback;
+
+    /* 清除配置前残留的挂起标志 */
+    EXTI->PR = GPIO_Pin;
+
+    irq = EXTI_IRQn(line);
+    NVIC_SetPriority(irq, EXTI_IRQ_PRIORITY);
+    NVIC_EnableIRQ(irq);
+
+    BITBAND_PERI(EXTI->IMR, line) = 1;
+
+    return SUCCESS;
+}
+
+/**
+  * @brief  断开引脚与 EXTI 线的连接
+  * @param  GPIO_Pin: 单个引脚
+  * @retval None
+  */
+void EXTI_Detach(uint16_t GPIO_Pin)
+{
+    uint8_t line;
+
+    if(GPIO_Pin == 0)
+        return;
+
+    line = (uint8_t)__builtin_ctz(GPIO_Pin);
+
+    BITBAND_PERI(EXTI->IMR, line) = 0;
+    BITBAND_PERI(EXTI->RTSR, line) = 0;
+    BITBAND_PERI(EXTI->FTSR, line) = 0;
+    EXTI->PR = GPIO_Pin;
+
+    exti_line[line].callback = NULL;
+}
+
+/**
+  * @brief  使能 EXTI 线中断 (EXTI_Attach() 后默认使能)
+  * @param  GPIO_Pin: 单个引脚
+  * @retval None
+  */
+void EXTI_Enable(uint16_t GPIO_Pin)
+{
+    if(GPIO_Pin == 0)
+        return;
+
+    /* 先清除屏蔽期间挂起的边沿 */
+    EXTI->PR = GPIO_Pin;
+    BITBAND_PERI(EXTI->IMR, __builtin_ctz(GPIO_Pin)) = 1;
+}
+
+/**
+  * @brief  屏蔽 EXTI 线中断
+  * @param  GPIO_Pin: 单个引脚
+  * @retval None
+  */
+void EXTI_Disable(uint16_t GPIO_Pin)
+{
+    if(GPIO_Pin == 0)
+        return;
+
+    BITBAND_PERI(EXTI->IMR, __builtin_ctz(GPIO_Pin)) = 0;
+}
+
+/**
+  * @brief  添加一个按键 (配置为上拉/下拉输入, 双边沿中断)
+  * @param  GPIOx: GPIO 端口
+  * @param  GPIO_Pin: 单个引脚
+  * @param  active_low: 1 = 按键接地 (内部上拉, 按下为低), 0 = 按键接 VCC (内部下拉)
+  * @note   第一次调用时初始化 TIM1 作为消抖定时器
+  * @retval 按键编号 (0 ~ BUTTON_MAX-1), -1 = 按键数已满或 EXTI 线已被占用
+  *
+  * 示例:
+  *   int8_t key = Button_Add(GPIOA, GPIO_PIN_0, 1);
+  *   Button_Event_t ev;
+  *   while(Button_GetEvent(&ev)) { if(ev.id == key && ev.type == BUTTON_PRESS) ... }
+  */
+int8_t Button_Add(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint8_t active_low)
+{
+    Button_t *b;
+    uint8_t line, id;
+
+    if(button_count >= BUTTON_MAX || GPIO_Pin == 0 || (GPIO_Pin & (GPIO_Pin - 1)) != 0)
+        return -1;
+
+    line = (uint8_t)__builtin_ctz(GPIO_Pin);
+    if(exti_line[line].callback != NULL)
+        return -1;
+
+    /* 使能端口时钟, 配置上拉/下拉输入 (ODR 选择上拉或下拉) */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN << EXTI_PortIndex(GPIOx);
+    GPIO_Init(GPIOx, GPIO_Pin, GPIO_MODE_INPUT, GPIO_CNF_INPUT_PUPD);
+    GPIO_WritePin(GPIOx, GPIO_Pin, active_low ? GPIO_PIN_SET : GPIO_PIN_RESET);
+
+    if(button_count == 0)
+        Button_TimerInit();
+
+    id = button_count;
+    b = &button[id];
+    b->port = GPIOx;
+    b->line = line;
+    b->active_low = active_low ? 1 : 0;
+    b->debounce = 0;
+    b->held = BUTTON_LONG_MS;   /* 启动时已按下的按键不产生长按 */
+    b->pressed = GPIO_PIN_IN(GPIOx, line) ^ b->active_low;
+    button_of_line[line] = id;
+
+    /* 先计入按键数再使能中断, TIM1 中断才会处理它的消抖 */
+    button_count = id + 1;
+    EXTI_Attach(GPIOx, GPIO_Pin, EXTI_EDGE_BOTH, Button_Edge);
+
+    return (int8_t)id;
+}
+
+/**
+  * @brief  取出一个按键事件
+  * @param  event: 事件输出
+  * @retval 1 = 取到事件, 0 = 队列为空
+  */
+uint8_t Button_GetEvent(Button_Event_t *event)
+{
+    uint8_t tail = button_tail;
+
+    if(tail == button_head)
+        return 0;
+
+    event->id = button_queue[tail & (BUTTON_QUEUE_SIZE - 1)].id;
+    event->type = button_queue[tail & (BUTTON_QUEUE_SIZE - 1)].type;
+    button_tail = tail + 1;
+
+    return 1;
+}
+
+/**
+  * @brief  查询按键消抖后的当前状态
+  * @param  id: 按键编号
+  * @retval 1 = 按下, 0 = 释放
+  */
+uint8_t Button_IsPressed(uint8_t id)
+{
+    if(id >= button_count)
+        return 0;
+
+    return button[id].pressed;
+}
+
+/**
+  * @brief  获取因队列已满而丢弃的事件数
+  * @retval 丢弃的事件数
+  */
+uint32_t Button_Dropped(void)
+{
+    return button_dropped;
+}
+
+/**
+  * @brief  EXTI 中断: 线 0-4 各自独立, 5-9 和 10-15 共用
+  * @retval None
+  */
+void EXTI0_IRQHandler(void)     { EXTI_Dispatch(0x0001); }
+void EXTI1_IRQHandler(void)     { EXTI_Dispatch(0x0002); }
+void EXTI2_IRQHandler(void)     { EXTI_Dispatch(0x0004); }
+void EXTI3_IRQHandler(void)     { EXTI_Dispatch(0x0008); }
+void EXTI4_IRQHandler(void)     { EXTI_Dispatch(0x0010); }
+void EXTI9_5_IRQHandler(void)   { EXTI_Dispatch(0x03E0); }
+void EXTI15_10_IRQHandler(void) { EXTI_Dispatch(0xFC00); }
+
+/**
+  * @brief  TIM1 更新中断: 1ms 消抖/长按计时
+  * @note   只在有按键正在消抖或等待长按时运行, 全部空闲后停止
+  * @retval None
+  */
+void TIM1_UP_IRQHandler(void)
+{
+    Button_t *b;
+    uint8_t i, pressed, active = 0;
+
+    MONITOR_ISR_ENTRY(MONITOR_SRC_BUTTON, Monitor_TimerLatency(TIM1));
+
+    TIM1->SR = ~TIM_SR_UIF;
+
+    for(i = 0; i < button_count; i++)
+    {
+        b = &button[i];
+
+        if(b->debounce != 0)
+        {
+            active = 1;
+            if(--b->debounce != 0)
+                continue;
+
+            /* 先清挂起标志再采样: 采样之后的边沿会重新挂起, 解除屏蔽后立即进入中断 */
+            EXTI->PR = 1UL << b->line;
+            pressed = GPIO_PIN_IN(b->port, b->line) ^ b->active_low;
+
+            if(pressed != b->pressed)
+            {
+                b->pressed = pressed;
+                b->held = 0;
+                Button_Push(i, pressed ? BUTTON_PRESS : BUTTON_RELEASE);
+            }
+
+            BITBAND_PERI(EXTI->IMR, b->line) = 1;
+        }
+
+        /* 长按计时 */
+        if(b->pressed && b->held < BUTTON_LONG_MS)
+        {
+            active = 1;
+            if(++b->held == BUTTON_LONG_MS)
+                Button_Push(i, BUTTON_LONG_PRESS);
+        }
+    }
+
+    if(!active)
+        BITBAND_PERI(TIM1->CR1, TIM_CR1_CEN_BIT) = 0;
+}
+
+/**
+  * @brief  处理挂起的 EXTI 线
+  * @param  lines: 该中断向量负责的线
+  * @retval None
+  */
+static void EXTI_Dispatch(uint32_t lines)
+{
+    uint32_t pending = EXTI->PR & EXTI->IMR & lines;
+    uint8_t line;
+
+    /* 写 1 清除 */
+    EXTI->PR = pending;
+
+    while(pending)
+    {
+        line = (uint8_t)__builtin_ctz(pending);
+        pending &= pending - 1;
+
+        if(exti_line[line].callback != NULL)
+            exti_line[line].callback((uint16_t)(1U << line));
+    }
+}
+
+/**
+  * @brief  按键边沿: 屏蔽该线并开始消抖计时 (中断中只做这两件事)
+  * @param  GPIO_Pin: 触发的引脚
+  * @retval None
+  */
+static void Button_Edge(uint16_t GPIO_Pin)
+{
+    uint8_t line = (uint8_t)__builtin_ctz(GPIO_Pin);
+
+    /* 抖动期间的边沿不再进入中断 */
+    BITBAND_PERI(EXTI->IMR, line) = 0;
+
+    button[button_of_line[line]].debounce = BUTTON_DEBOUNCE_MS;
+    BITBAND_PERI(TIM1->CR1, TIM_CR1_CEN_BIT) = 1;
+}
+
+/**
+  * @brief  初始化 TIM1: 1ms 更新中断, 初始为停止状态
+  * @retval None
+  */
+static void Button_TimerInit(void)
+{
+    RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+
+    /* 计数频率 1MHz, 时钟切换后由 PWM 驱动重新计算 PSC */
+    TIM1->CR1 = 0;
+    PWM_SetCountRate(TIM1, 1000000);
+    TIM1->ARR = 1000 - 1;
+    TIM1->RCR = 0;
+    TIM1->CNT = 0;
+    TIM1->SR = 0;
+    TIM1->DIER = TIM_DIER_UIE;
+
+    NVIC_SetPriority(TIM1_UP_IRQn, EXTI_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TIM1_UP_IRQn);
+}
+
+/**
+  * @brief  事件入队 (仅在 TIM1 中断中调用)
+  * @param  id: 按键编号
+  * @param  type: 事件类型
+  * @retval None
+  */
+static void Button_Push(uint8_t id, Button_EventType_t type)
+{
+    uint8_t head = button_head;
+
+    if((uint8_t)(head - button_tail) >= BUTTON_QUEUE_SIZE)
+    {
+        button_dropped++;
+        return;
+    }
+
+    button_queue[head & (BUTTON_QUEUE_SIZE - 1)].id = id;
+    button_queue[head & (BUTTON_QUEUE_SIZE - 1)].type = type;
+    button_head = head + 1;
+}
+
+/**
+  * @brief  端口序号 (GPIOA = 0, GPIOB = 1, ...)
+  * @param  GPIOx: GPIO 端口
+  * @retval 端口序号
+  */
+static uint32_t EXTI_PortIndex(GPIO_TypeDef *GPIOx)
+{
+    return ((uint32_t)GPIOx - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE);
+}
+
+/**
+  * @brief  EXTI 线对应的中断号
+  * @param  line: 线号 (0-15)
+  * @retval 中断号
+  */
+static IRQn_Type EXTI_IRQn(uint8_t line)
+{
+    if(line < 5)
+        return (IRQn_Type)(EXTI0_IRQn + line);
+
+    return (line < 10) ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
@@ -0,0 +1,837 @@
+/**
+  ******************************************************************************
+  * @file    i2c.c
+  * @brief   I2C 主机驱动实现 - 事务队列 + 中断/DMA 数据传输
+  ******************************************************************************
+  * 引脚:
+  *   I2C1: PB6 (SCL), PB7 (SDA)   DMA1 通道6 (TX) / 通道7 (RX)
+  *   I2C2: PB10 (SCL), PB11 (SDA) DMA1 通道4 (TX) / 通道5 (RX)
+  *         注意 PB10/PB11 与 LCD1602 的 D6/D7 冲突
+  *
+  * 每条总线维护一个事务队列, I2C_Submit() 只负责入队后立即返回,
+  * 事件中断按状态机推进 START -> 地址 -> 数据 -> (重复起始 -> 读) -> STOP,
+  * 一个事务完成后在中断中调用回调并启动下一个事务。
+  *
+  * 出错或超时时只关闭外设并标记总线待恢复, 手动输出时钟的总线恢复
+  * (约 115us) 在线程上下文的 I2C_Watchdog()/I2C_Recover() 中开中断执行,
+  * 不会在中断或关中断期间阻塞 SysTick 等其他中断; 恢复前队列暂停。
+  ******************************************************************************
+  */
+
+#include "i2c.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "delay.h"
+#include "clock.h"
+#include "ramfunc.h"
+#include <stddef.h>
+
+/* I2C 寄存器位定义 */
+#define I2C_CR1_PE          (1 << 0)   /* 外设使能 */
+#define I2C_CR1_START       (1 << 8)   /* 产生起始条件 */
+#define I2C_CR1_STOP        (1 << 9)   /* 产生停止条件 */
+#define I2C_CR1_ACK         (1 << 10)  /* 应答使能 */
+#define I2C_CR1_POS         (1 << 11)  /* ACK 作用于下一个字节 */
+#define I2C_CR1_SWRST       (1 << 15)  /* 软件复位 */
+#define I2C_CR2_ITERREN     (1 << 8)   /* 错误中断使能 */
+#define I2C_CR2_ITEVTEN     (1 << 9)   /* 事件中断使能 */
+#define I2C_CR2_ITBUFEN     (1 << 10)  /* 缓冲区中断使能 (TXE/RXNE) */
+#define I2C_CR2_DMAEN       (1 << 11)  /* DMA 请求使能 */
+#define I2C_CR2_LAST        (1 << 12)  /* DMA 最后一次传输后 NACK */
+#define I2C_SR1_SB          (1 << 0)   /* 起始条件已发送 */
+#define I2C_SR1_ADDR        (1 << 1)   /* 地址已发送 */
+#define I2C_SR1_BTF         (1 << 2)   /* 字节传输完成 */
+#define I2C_SR1_RXNE        (1 << 6)   /* 接收寄存器非空 */
+#define I2C_SR1_TXE         (1 << 7)   /* 发送寄存器空 */
+#define I2C_SR1_BERR        (1 << 8)   /* 总线错误 */
+#define I2C_SR1_ARLO        (1 << 9)   /* 仲裁丢失 */
+#define I2C_SR1_AF          (1 << 10)  /* 应答失败 */
+#define I2C_SR1_OVR         (1 << 11)  /* 上溢/下溢 */
+#define I2C_SR1_TIMEOUT     (1 << 14)  /* SCL 超时 */
+#define I2C_SR1_ERRORS      (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | \
+                             I2C_SR1_OVR | I2C_SR1_TIMEOUT)
+#define I2C_CCR_FS          (1 << 15)  /* 快速模式 */
+
+/* DMA 寄存器位定义 */
+#define DMA_CCR_EN          (1 << 0)   /* 通道使能 */
+#define DMA_CCR_TCIE        (1 << 1)   /* 传输完成中断 */
+#define DMA_CCR_DIR         (1 << 4)   /* 1 = 存储器到外设 */
+#define DMA_CCR_MINC        (1 << 7)   /* 存储器地址递增 */
+#define DMA_CCR_PL_HIGH     (2 << 12)  /* 通道优先级: 高 */
+
+/* 传输阶段 */
+typedef enum
+{
+    I2C_PHASE_IDLE = 0,
+    I2C_PHASE_TX,
+    I2C_PHASE_RX
+} I2C_Phase_t;
+
+/* 总线状态 */
+typedef struct
+{
+    I2C_TypeDef *I2Cx;
+    DMA_Channel_TypeDef *dma_tx;
+    DMA_Channel_TypeDef *dma_rx;
+    uint8_t dma_tx_ch;                      /* DMA 通道号 (1-7), 用于清除标志 */
+    uint8_t dma_rx_ch;
+    IRQn_Type ev_irq;
+    IRQn_Type er_irq;
+    IRQn_Type dma_rx_irq;
+    GPIO_TypeDef *port;
+    uint16_t scl_pin;
+    uint16_t sda_pin;
+    uint32_t speed;
+
+    I2C_Transfer_t *queue[I2C_QUEUE_SIZE];  /* 等待中的事务 (queue[tail] 为当前事务) */
+    uint8_t head;
+    uint8_t tail;
+    uint8_t count;
+
+    I2C_Transfer_t *cur;                    /* 当前事务, NULL = 空闲 */
+    I2C_Phase_t phase;
+    uint16_t index;                         /* 当前阶段已传输字节数 */
+    uint8_t dma;                            /* 当前阶段是否使用 DMA */
+    uint32_t start_tick;                    /* 事务开始时间 (ms) */
+    volatile uint8_t recover;               /* 1 = 等待 I2C_Service() 恢复总线 */
+    uint8_t init;                           /* 1 = 已调用 I2C_Init() */
+} I2C_Bus_t;
+
+static I2C_Bus_t i2c_bus[2] =
+{
+    { I2C1, DMA1_Channel6, DMA1_Channel7, 6, 7,
+      I2C1_EV_IRQn, I2C1_ER_IRQn, DMA1_Channel7_IRQn, GPIOB, GPIO_PIN_6, GPIO_PIN_7, I2C_SPEED_STANDARD },
+    { I2C2, DMA1_Channel4, DMA1_Channel5, 4, 5,
+      I2C2_EV_IRQn, I2C2_ER_IRQn, DMA1_Channel5_IRQn, GPIOB, GPIO_PIN_10, GPIO_PIN_11, I2C_SPEED_STANDARD }
+};
+
+static Clock_Notifier_t i2c_clock_notifier;
+
+/* 私有函数声明 */
+static I2C_Bus_t *I2C_GetBus(I2C_TypeDef *I2Cx);
+static void I2C_HwInit(I2C_Bus_t *bus);
+static void I2C_BusReset(I2C_Bus_t *bus);
+static void I2C_Service(I2C_Bus_t *bus);
+static void I2C_StartNext(I2C_Bus_t *bus);
+static void I2C_StartPhase(I2C_Bus_t *bus, I2C_Phase_t phase);
+static void I2C_DMAStart(I2C_Bus_t *bus, DMA_Channel_TypeDef *ch, uint8_t ch_num,
+                         const uint8_t *buf, uint16_t len, uint32_t ccr);
+static void I2C_Complete(I2C_Bus_t *bus, I2C_Status_t status);
+static void I2C_Abort(I2C_Bus_t *bus, I2C_Status_t status);
+static void I2C_EV_Handler(I2C_Bus_t *bus);
+static void I2C_ER_Handler(I2C_Bus_t *bus);
+static void I2C_DMA_RX_Handler(I2C_Bus_t *bus);
+static void I2C_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg);
+
+/**
+  * @brief  初始化 I2C 主机
+  * @param  I2Cx: I2C1 或 I2C2
+  * @param  speed: 总线速率, I2C_SPEED_STANDARD 或 I2C_SPEED_FAST
+  * @note   会清空事务队列并复位外设; 多个驱动共用总线时用 I2C_IsInit() 判断
+  * @retval None
+  *
+  * 示例: I2C_Init(I2C1, I2C_SPEED_FAST); // 400kHz
+  */
+void I2C_Init(I2C_TypeDef *I2Cx, uint32_t speed)
+{
+    I2C_Bus_t *bus = I2C_GetBus(I2Cx);
+
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPBEN;
+    RCC->APB1ENR |= (I2Cx == I2C1) ? RCC_APB1ENR_I2C1EN : RCC_APB1ENR_I2C2EN;
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    bus->speed = speed;
+    bus->head = 0;
+    bus->tail = 0;
+    bus->count = 0;
+    bus->cur = NULL;
+    bus->phase = I2C_PHASE_IDLE;
+    bus->recover = 0;
+
+    /* SCL/SDA: 复用开漏输出 */
+    GPIO_Init(bus->port, bus->scl_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_OD);
+    GPIO_Init(bus->port, bus->sda_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_OD);
+
+    I2C_HwInit(bus);
+
+    if(i2c_clock_notifier.callback == NULL)
+        Clock_Register(&i2c_clock_notifier, I2C_ClockChanged, NULL);
+
+    /* 单/双字节接收对时序敏感, 事件中断使用最高优先级 */
+    NVIC_SetPriority(bus->ev_irq, 0);
+    NVIC_SetPriority(bus->er_irq, 0);
+    NVIC_EnableIRQ(bus->ev_irq);
+    NVIC_EnableIRQ(bus->er_irq);
+    NVIC_EnableIRQ(bus->dma_rx_irq);
+
+    bus->init = 1;
+}
+
+/**
+  * @brief  查询总线是否已初始化
+  * @param  I2Cx: I2C1 或 I2C2
+  * @retval 1 = 已调用 I2C_Init(), 0 = 未初始化
+  */
+uint8_t I2C_IsInit(I2C_TypeDef *I2Cx)
+{
+    return I2C_GetBus(I2Cx)->init;
+}
+
+/**
+  * @brief  提交一个事务到总线队列
+  * @param  I2Cx: I2C1 或 I2C2
+  * @param  xfer: 事务 (完成前结构体和缓冲区必须保持有效)
+  * @note   可在中断 (包括完成回调) 中调用
+  * @retval SUCCESS = 已入队, ERROR = 队列已满或事务为空
+  */
+ErrorStatus I2C_Submit(I2C_TypeDef *I2Cx, I2C_Transfer_t *xfer)
+{
+    I2C_Bus_t *bus = I2C_GetBus(I2Cx);
+    uint32_t primask;
+
+    if(xfer->tx_len == 0 && xfer->rx_len == 0)
+        return ERROR;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if(bus->count >= I2C_QUEUE_SIZE)
+    {
+        __set_PRIMASK(primask);
+        return ERROR;
+    }
+
+    xfer->status = I2C_PENDING;
+    bus->queue[bus->head] = xfer;
+    bus->head = (bus->head + 1) % I2C_QUEUE_SIZE;
+    bus->count++;
+
+    if(bus->cur == NULL)
+    {
+        I2C_StartNext(bus);
+    }
+
+    __set_PRIMASK(primask);
+
+    return SUCCESS;
+}
+
+/**
+  * @brief  阻塞等待事务完成
+  * @param  xfer: 已提交的事务
+  * @retval 事务最终状态
+  */
+I2C_Status_t I2C_Wait(I2C_Transfer_t *xfer)
+{
+    while(xfer->status == I2C_PENDING)
+    {
+        I2C_Watchdog();
+    }
+
+    return xfer->status;
+}
+
+/**
+  * @brief  查询总线是否空闲
+  * @param  I2Cx: I2C1 或 I2C2
+  * @retval 1 = 空闲 (队列为空), 0 = 忙
+  */
+uint8_t I2C_IsIdle(I2C_TypeDef *I2Cx)
+{
+    return I2C_GetBus(I2Cx)->cur == NULL;
+}
+
+/**
+  * @brief  检查事务超时, 超时则以 I2C_ERR_TIMEOUT 结束该事务; 恢复待恢复的总线
+  * @note   需在主循环或调度器任务中周期调用 (间隔不大于 I2C_TIMEOUT_MS);
+  *         在中断中或关中断时调用只检查超时, 总线恢复留到下次线程上下文调用
+  * @retval None
+  */
+void I2C_Watchdog(void)
+{
+    uint32_t primask;
+    uint8_t i;
+
+    for(i = 0; i < 2; i++)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        if(i2c_bus[i].cur != NULL &&
+           (GetTick() - i2c_bus[i].start_tick) > I2C_TIMEOUT_MS)
+        {
+            I2C_Abort(&i2c_bus[i], I2C_ERR_TIMEOUT);
+        }
+
+        __set_PRIMASK(primask);
+
+        I2C_Service(&i2c_bus[i]);
+    }
+}
+
+/**
+  * @brief  总线恢复: 释放被从机拉低的 SDA 并复位外设
+  * @param  I2Cx: I2C1 或 I2C2
+  * @note   若有正在进行的事务, 以 I2C_ERR_BUS 结束它; 恢复后继续处理队列.
+  *         在线程上下文中立即恢复, 在中断中只做标记, 由 I2C_Watchdog() 完成
+  * @retval None
+  */
+void I2C_Recover(I2C_TypeDef *I2Cx)
+{
+    I2C_Bus_t *bus = I2C_GetBus(I2Cx);
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if(bus->cur != NULL)
+    {
+        I2C_Abort(bus, I2C_ERR_BUS);
+    }
+    else
+    {
+        bus->I2Cx->CR1 = 0;
+        bus->recover = 1;
+    }
+
+    __set_PRIMASK(primask);
+
+    I2C_Service(bus);
+}
+
+/**
+  * @brief  I2C1 事件中断
+  * @retval None
+  */
+RAMFUNC void I2C1_EV_IRQHandler(void)
+{
+    I2C_EV_Handler(&i2c_bus[0]);
+}
+
+/**
+  * @brief  I2C1 错误中断
+  * @retval None
+  */
+void I2C1_ER_IRQHandler(void)
+{
+    I2C_ER_Handler(&i2c_bus[0]);
+}
+
+/**
+  * @brief  I2C2 事件中断
+  * @retval None
+  */
+RAMFUNC void I2C2_EV_IRQHandler(void)
+{
+    I2C_EV_Handler(&i2c_bus[1]);
+}
+
+/**
+  * @brief  I2C2 错误中断
+  * @retval None
+  */
+void I2C2_ER_IRQHandler(void)
+{
+    I2C_ER_Handler(&i2c_bus[1]);
+}
+
+/**
+  * @brief  DMA1 通道7 中断 (I2C1 接收完成)
+  * @retval None
+  */
+void DMA1_Channel7_IRQHandler(void)
+{
+    I2C_DMA_RX_Handler(&i2c_bus[0]);
+}
+
+/**
+  * @brief  DMA1 通道5 中断 (I2C2 接收完成)
+  * @retval None
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+    I2C_DMA_RX_Handler(&i2c_bus[1]);
+}
+
+/**
+  * @brief  获取总线状态
+  * @param  I2Cx: I2C1 或 I2C2
+  * @retval 总线状态指针
+  */
+static I2C_Bus_t *I2C_GetBus(I2C_TypeDef *I2Cx)
+{
+    return (I2Cx == I2C2) ? &i2c_bus[1] : &i2c_bus[0];
+}
+
+/**
+  * @brief  配置 I2C 外设寄存器 (时钟, 速率, 中断)
+  * @param  bus: 总线
+  * @retval None
+  */
+static void I2C_HwInit(I2C_Bus_t *bus)
+{
+    I2C_TypeDef *I2Cx = bus->I2Cx;
+    Clock_Freq_t freq;
+    uint32_t pclk1;
+    uint32_t freq_mhz;
+    uint32_t ccr;
+
+    /* 标准模式要求 PCLK1 >= 2MHz, 快速模式 >= 4MHz */
+    Clock_GetFreq(&freq);
+    pclk1 = freq.pclk1;
+    freq_mhz = pclk1 / 1000000;
+
+    /* 软件复位, 清除可能卡住的 BUSY 状态 */
+    I2Cx->CR1 = I2C_CR1_SWRST;
+    I2Cx->CR1 = 0;
+
+    I2Cx->CR2 = freq_mhz | I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+
+    if(bus->speed > I2C_SPEED_STANDARD)
+    {
+        /* 快速模式, Tlow/Thigh = 2: CCR = PCLK1 / (3 x 速率) */
+        ccr = pclk1 / (bus->speed * 3);
+        if(ccr < 1)
+            ccr = 1;
+        I2Cx->CCR = I2C_CCR_FS | ccr;
+        I2Cx->TRISE = freq_mhz * 300 / 1000 + 1;  /* 最大上升时间 300ns */
+    }
+    else
+    {
+        /* 标准模式: CCR = PCLK1 / (2 x 速率) */
+        ccr = pclk1 / (bus->speed * 2);
+        if(ccr < 4)
+            ccr = 4;
+        I2Cx->CCR = ccr;
+        I2Cx->TRISE = freq_mhz + 1;               /* 最大上升时间 1000ns */
+    }
+
+    I2Cx->CR1 = I2C_CR1_PE;
+}
+
+/**
+  * @brief  复位总线: 手动输出时钟释放 SDA, 产生 STOP, 再重新初始化外设
+  * @param  bus: 总线
+  * @note   从机在字节中间被打断时会一直拉低 SDA, 最多9个时钟即可让它移出剩余位.
+  *         最长约 115us, 只在 I2C_Service() 中开中断调用
+  * @retval None
+  */
+static void I2C_BusReset(I2C_Bus_t *bus)
+{
+    uint8_t i;
+
+    bus->dma_tx->CCR = 0;
+    bus->dma_rx->CCR = 0;
+    bus->I2Cx->CR1 = 0;
+
+    /* 切换为普通开漏输出, 由软件控制 SCL/SDA */
+    GPIO_WritePin(bus->port, bus->scl_pin | bus->sda_pin, GPIO_PIN_SET);
+    GPIO_Init(bus->port, bus->scl_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_OD);
+    GPIO_Init(bus->port, bus->sda_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_OD);
+    Delay_Us(5);
+
+    for(i = 0; i < 9 && GPIO_ReadPin(bus->port, bus->sda_pin) == GPIO_PIN_RESET; i++)
+    {
+        GPIO_WritePin(bus->port, bus->scl_pin, GPIO_PIN_RESET);
+        Delay_Us(5);
+        GPIO_WritePin(bus->port, bus->scl_pin, GPIO_PIN_SET);
+        Delay_Us(5);
+    }
+
+    /* STOP: SCL 高电平期间 SDA 由低变高 */
+    GPIO_WritePin(bus->port, bus->scl_pin, GPIO_PIN_RESET);
+    Delay_Us(5);
+    GPIO_WritePin(bus->port, bus->sda_pin, GPIO_PIN_RESET);
+    Delay_Us(5);
+    GPIO_WritePin(bus->port, bus->scl_pin, GPIO_PIN_SET);
+    Delay_Us(5);
+    GPIO_WritePin(bus->port, bus->sda_pin, GPIO_PIN_SET);
+    Delay_Us(5);
+
+    /* 恢复复用开漏输出并重新初始化外设 */
+    GPIO_Init(bus->port, bus->scl_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_OD);
+    GPIO_Init(bus->port, bus->sda_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_OD);
+    I2C_HwInit(bus);
+}
+
+/**
+  * @brief  在线程上下文中恢复已标记的总线, 然后继续处理队列
+  * @param  bus: 总线
+  * @note   在中断中或关中断时直接返回, 等下次调用
+  * @retval None
+  */
+static void I2C_Service(I2C_Bus_t *bus)
+{
+    uint32_t primask;
+
+    if(!bus->recover || __get_IPSR() != 0 || __get_PRIMASK() != 0)
+        return;
+
+    /* 恢复期间 cur 为 NULL 且队列暂停, 不会有 I2C 中断访问总线 */
+    I2C_BusReset(bus);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    bus->recover = 0;
+    if(bus->cur == NULL)
+        I2C_StartNext(bus);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  启动队列中的下一个事务 (调用者已屏蔽中断或处于中断中)
+  * @param  bus: 总线
+  * @retval None
+  */
+RAMFUNC static void I2C_StartNext(I2C_Bus_t *bus)
+{
+    uint32_t start;
+    uint32_t timeout;
+
+    /* 总线待恢复时队列暂停, 由 I2C_Service() 重新启动 */
+    if(bus->count == 0 || bus->recover)
+    {
+        bus->cur = NULL;
+        bus->phase = I2C_PHASE_IDLE;
+        return;
+    }
+
+    bus->cur = bus->queue[bus->tail];
+    bus->start_tick = GetTick();
+
+    /* 上一事务的 STOP 还未发出时不能设置 START, 硬件发出后自动清零 (约一个位时间);
+       从机一直拉低 SCL 时 STOP 发不出去, 超时后以总线错误结束 */
+    start = Delay_GetCycles();
+    timeout = (SystemCoreClock / 1000000) * I2C_STOP_TIMEOUT_US;
+    while(bus->I2Cx->CR1 & I2C_CR1_STOP)
+    {
+        if(Delay_ElapsedCycles(start) > timeout)
+        {
+            I2C_Abort(bus, I2C_ERR_BUS);
+            return;
+        }
+    }
+
+    I2C_StartPhase(bus, (bus->cur->tx_len != 0) ? I2C_PHASE_TX : I2C_PHASE_RX);
+}
+
+/**
+  * @brief  开始写或读阶段: 产生 (重复) 起始条件
+  * @param  bus: 总线
+  * @param  phase: I2C_PHASE_TX 或 I2C_PHASE_RX
+  * @retval None
+  */
+RAMFUNC static void I2C_StartPhase(I2C_Bus_t *bus, I2C_Phase_t phase)
+{
+    I2C_TypeDef *I2Cx = bus->I2Cx;
+    uint16_t len = (phase == I2C_PHASE_TX) ? bus->cur->tx_len : bus->cur->rx_len;
+
+    bus->phase = phase;
+    bus->index = 0;
+    bus->dma = (len >= I2C_DMA_THRESHOLD) ? 1 : 0;
+
+    /* 中断方式需要 TXE/RXNE 中断, DMA 方式由 DMA 响应 */
+    if(bus->dma)
+        I2Cx->CR2 &= ~I2C_CR2_ITBUFEN;
+    else
+        I2Cx->CR2 |= I2C_CR2_ITBUFEN;
+
+    I2Cx->CR1 &= ~I2C_CR1_POS;
+    I2Cx->CR1 |= I2C_CR1_ACK | I2C_CR1_START;
+}
+
+/**
+  * @brief  启动 DMA 数据阶段
+  * @param  bus: 总线
+  * @param  ch: DMA 通道
+  * @param  ch_num: 通道号 (1-7)
+  * @param  buf: 数据缓冲区
+  * @param  len: 字节数
+  * @param  ccr: 附加的通道配置 (方向, 中断)
+  * @retval None
+  */
+RAMFUNC static void I2C_DMAStart(I2C_Bus_t *bus, DMA_Channel_TypeDef *ch, uint8_t ch_num,
+                                 const uint8_t *buf, uint16_t len, uint32_t ccr)
+{
+    ch->CCR = 0;
+    DMA1->IFCR = 0xFUL << ((ch_num - 1) * 4);
+    ch->CPAR = (uint32_t)&bus->I2Cx->DR;
+    ch->CMAR = (uint32_t)buf;
+    ch->CNDTR = len;
+    ch->CCR = ccr | DMA_CCR_MINC | DMA_CCR_PL_HIGH | DMA_CCR_EN;
+
+    bus->I2Cx->CR2 |= I2C_CR2_DMAEN;
+}
+
+/**
+  * @brief  结束当前事务: 更新状态, 调用回调, 启动下一个事务
+  * @param  bus: 总线
+  * @param  status: 事务结果
+  * @retval None
+  */
+RAMFUNC static void I2C_Complete(I2C_Bus_t *bus, I2C_Status_t status)
+{
+    I2C_Transfer_t *xfer = bus->cur;
+
+    bus->dma_tx->CCR = 0;
+    bus->dma_rx->CCR = 0;
+    bus->I2Cx->CR2 &= ~(I2C_CR2_ITBUFEN | I2C_CR2_DMAEN | I2C_CR2_LAST);
+    bus->I2Cx->CR1 &= ~I2C_CR1_POS;
+
+    bus->tail = (bus->tail + 1) % I2C_QUEUE_SIZE;
+    bus->count--;
+    bus->cur = NULL;
+    bus->phase = I2C_PHASE_IDLE;
+
+    xfer->status = status;
+    if(xfer->callback != NULL)
+    {
+        xfer->callback(xfer);
+    }
+
+    /* 回调中可能已提交并启动了新事务 */
+    if(bus->cur == NULL)
+    {
+        I2C_StartNext(bus);
+    }
+}
+
+/**
+  * @brief  中止当前事务: 关闭外设, 标记总线待恢复, 以指定状态结束
+  * @param  bus: 总线
+  * @param  status: 错误状态
+  * @note   可在中断和关中断时调用, 不等待; 总线恢复见 I2C_Service()
+  * @retval None
+  */
+RAMFUNC static void I2C_Abort(I2C_Bus_t *bus, I2C_Status_t status)
+{
+    bus->dma_tx->CCR = 0;
+    bus->dma_rx->CCR = 0;
+    bus->I2Cx->CR1 = 0;
+    bus->recover = 1;
+
+    I2C_Complete(bus, status);
+}
+
+/**
+  * @brief  事件中断处理: 主机状态机
+  * @param  bus: 总线
+  * @retval None
+  */
+RAMFUNC static void I2C_EV_Handler(I2C_Bus_t *bus)
+{
+    I2C_TypeDef *I2Cx = bus->I2Cx;
+    I2C_Transfer_t *xfer = bus->cur;
+    uint32_t sr1 = I2Cx->SR1;
+    uint16_t remaining;
+
+    if(xfer == NULL)
+    {
+        /* 无事务时的残留事件: 读 SR2 清除 */
+        (void)I2Cx->SR2;
+        return;
+    }
+
+    /* 起始条件已发送: 写从机地址 (读 SR1 + 写 DR 清除 SB) */
+    if(sr1 & I2C_SR1_SB)
+    {
+        I2Cx->DR = (uint32_t)(xfer->addr << 1) | ((bus->phase == I2C_PHASE_RX) ? 1 : 0);
+        return;
+    }
+
+    /* 地址已应答: 按阶段和长度准备数据传输, 读 SR2 清除 ADDR */
+    if(sr1 & I2C_SR1_ADDR)
+    {
+        if(bus->phase == I2C_PHASE_TX)
+        {
+            if(bus->dma)
+                I2C_DMAStart(bus, bus->dma_tx, bus->dma_tx_ch, xfer->tx_buf, xfer->tx_len, DMA_CCR_DIR);
+        }
+        else if(bus->dma)
+        {
+            /* DMA 接收: 最后一个字节后硬件自动 NACK, 完成中断中发 STOP */
+            I2Cx->CR2 |= I2C_CR2_LAST;
+            I2C_DMAStart(bus, bus->dma_rx, bus->dma_rx_ch, xfer->rx_buf, xfer->rx_len, DMA_CCR_TCIE);
+        }
+        else if(xfer->rx_len == 1)
+        {
+            /* 单字节: 清除 ADDR 前关闭 ACK, 清除后立即 STOP */
+            I2Cx->CR1 &= ~I2C_CR1_ACK;
+            (void)I2Cx->SR2;
+            I2Cx->CR1 |= I2C_CR1_STOP;
+            return;
+        }
+        else if(xfer->rx_len == 2)
+        {
+            /* 两字节: POS 使 NACK 作用于第二个字节, 等待 BTF 后一次读出 */
+            I2Cx->CR1 &= ~I2C_CR1_ACK;
+            I2Cx->CR1 |= I2C_CR1_POS;
+            I2Cx->CR2 &= ~I2C_CR2_ITBUFEN;
+        }
+        else if(xfer->rx_len == 3)
+        {
+            /* 三字节: 全部由 BTF 处理 */
+            I2Cx->CR2 &= ~I2C_CR2_ITBUFEN;
+        }
+
+        (void)I2Cx->SR2;
+        return;
+    }
+
+    if(bus->phase == I2C_PHASE_TX)
+    {
+        if((sr1 & I2C_SR1_TXE) && !bus->dma && bus->index < xfer->tx_len)
+        {
+            I2Cx->DR = xfer->tx_buf[bus->index++];
+
+            /* 最后一个字节已写入: 改为等待 BTF */
+            if(bus->index == xfer->tx_len)
+                I2Cx->CR2 &= ~I2C_CR2_ITBUFEN;
+            return;
+        }
+
+        if(sr1 & I2C_SR1_BTF)
+        {
+            /* DMA 方式下 BTF 只在全部字节写入后才有意义 */
+            if(bus->dma && bus->dma_tx->CNDTR != 0)
+                return;
+
+            if(xfer->rx_len != 0)
+            {
+                /* 先写后读: 重复起始条件 (同时清除 BTF) */
+                I2C_StartPhase(bus, I2C_PHASE_RX);
+            }
+            else
+            {
+                I2Cx->CR1 |= I2C_CR1_STOP;
+                I2C_Complete(bus, I2C_OK);
+            }
+        }
+        return;
+    }
+
+    /* 接收阶段: DMA 方式在 DMA 完成中断中结束 */
+    if(bus->dma)
+        return;
+
+    remaining = xfer->rx_len - bus->index;
+
+    if((sr1 & I2C_SR1_RXNE) && (remaining > 3 || xfer->rx_len == 1))
+    {
+        xfer->rx_buf[bus->index++] = (uint8_t)I2Cx->DR;
+
+        if(xfer->rx_len == 1)
+        {
+            I2C_Complete(bus, I2C_OK);
+        }
+        else if(remaining - 1 == 3)
+        {
+            /* 最后3个字节改由 BTF 处理, 以便在正确时刻关闭 ACK */
+            I2Cx->CR2 &= ~I2C_CR2_ITBUFEN;
+        }
+        return;
+    }
+
+    if(sr1 & I2C_SR1_BTF)
+    {
+        if(remaining == 3)
+        {
+            /* DR = N-2, 移位寄存器 = N-1: 关闭 ACK 使最后一个字节收到 NACK */
+            I2Cx->CR1 &= ~I2C_CR1_ACK;
+            xfer->rx_buf[bus->index++] = (uint8_t)I2Cx->DR;
+        }
+        else if(remaining == 2)
+        {
+            /* DR = N-1, 移位寄存器 = N: 先 STOP 再读出最后两个字节 */
+            I2Cx->CR1 |= I2C_CR1_STOP;
+            xfer->rx_buf[bus->index++] = (uint8_t)I2Cx->DR;
+            xfer->rx_buf[bus->index++] = (uint8_t)I2Cx->DR;
+            I2C_Complete(bus, I2C_OK);
+        }
+    }
+}
+
+/**
+  * @brief  错误中断处理
+  * @param  bus: 总线
+  * @retval None
+  */
+static void I2C_ER_Handler(I2C_Bus_t *bus)
+{
+    I2C_TypeDef *I2Cx = bus->I2Cx;
+    uint32_t sr1 = I2Cx->SR1;
+
+    /* 错误标志写0清除 */
+    I2Cx->SR1 = ~(sr1 & I2C_SR1_ERRORS);
+
+    if(bus->cur == NULL)
+        return;
+
+    if(sr1 & (I2C_SR1_BERR | I2C_SR1_TIMEOUT))
+    {
+        I2C_Abort(bus, I2C_ERR_BUS);
+    }
+    else if(sr1 & I2C_SR1_ARLO)
+    {
+        /* 仲裁丢失后硬件已转为从机模式, 复位后重新开始 */
+        I2C_Abort(bus, I2C_ERR_ARLO);
+    }
+    else if(sr1 & I2C_SR1_AF)
+    {
+        /* 从机无应答: 释放总线 */
+        I2Cx->CR1 |= I2C_CR1_STOP;
+        I2C_Complete(bus, I2C_ERR_NACK);
+    }
+    else if(sr1 & I2C_SR1_OVR)
+    {
+        I2Cx->CR1 |= I2C_CR1_STOP;
+        I2C_Complete(bus, I2C_ERR_OVR);
+    }
+}
+
+/**
+  * @brief  DMA 接收完成中断处理
+  * @param  bus: 总线
+  * @retval None
+  */
+static void I2C_DMA_RX_Handler(I2C_Bus_t *bus)
+{
+    DMA1->IFCR = 0xFUL << ((bus->dma_rx_ch - 1) * 4);
+
+    if(bus->cur == NULL || bus->phase != I2C_PHASE_RX)
+        return;
+
+    bus->I2Cx->CR1 |= I2C_CR1_STOP;
+    I2C_Complete(bus, I2C_OK);
+}
+
+/**
+  * @brief  时钟切换后按新的 PCLK1 重新配置已初始化的总线
+  * @param  event: CLOCK_EVENT_PRE 或 CLOCK_EVENT_POST
+  * @param  freq: 时钟树
+  * @param  arg: 未使用
+  * @note   进行中的事务以 I2C_ERR_BUS 结束, 总线恢复后队列中其余事务照常执行
+  * @retval None
+  */
+static void I2C_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg)
+{
+    uint8_t i;
+
+    if(event != CLOCK_EVENT_POST)
+        return;
+
+    for(i = 0; i < 2; i++)
+    {
+        if((RCC->APB1ENR & ((i == 0) ? RCC_APB1ENR_I2C1EN : RCC_APB1ENR_I2C2EN)) == 0)
+            continue;
+
+        /* 待恢复的总线在恢复时按新时钟初始化 */
+        if(i2c_bus[i].cur != NULL)
+            I2C_Abort(&i2c_bus[i], I2C_ERR_BUS);
+        else if(!i2c_bus[i].recover)
+            I2C_HwInit(&i2c_bus[i]);
+    }
+}
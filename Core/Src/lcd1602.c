@@ -1,251 +1,1569 @@
 /**
   ******************************************************************************
   * @file    lcd1602.c
-  * @brief   LCD1602 字符显示屏驱动实现
+  * @brief   HD44780 字符显示屏驱动实现
   ******************************************************************************
   */
 
 #include "lcd1602.h"
 #include "gpio.h"
 #include "delay.h"
+#include "bitband.h"
+#include "pwm.h"
+#include "profile.h"
+#include "monitor.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
+
+#if (LCD_ASYNC_QUEUE_SIZE & (LCD_ASYNC_QUEUE_SIZE - 1)) != 0
+#error "LCD_ASYNC_QUEUE_SIZE must be a power of 2"
+#endif
+
+#if LCD_ROWS * LCD_COLS > LCD_MAX_CELLS
+#error "LCD_ROWS x LCD_COLS exceeds LCD_MAX_CELLS"
+#endif
+
+/* TIM 寄存器位定义 */
+#define TIM_CR1_CEN_BIT     0          /* 计数器使能 (位带访问) */
+#define TIM_DIER_UIE        (1 << 0)   /* 更新中断使能 */
+#define TIM_SR_UIF          (1 << 0)   /* 更新中断标志 */
+
+/* 异步队列项: bit0-7 为数据, bit8 为 RS, bit9 表示长执行时间命令 (清屏/回home) */
+#define LCD_ASYNC_RS        0x100
+#define LCD_ASYNC_LONG      0x200
+
+/* 命令执行时间对应的节拍数 (与同步写入的固定延时一致) */
+#define LCD_ASYNC_TICKS(us) (((us) + LCD_ASYNC_TICK_US - 1) / LCD_ASYNC_TICK_US)
+
+/* HD44780 使能时序 (ns): EN 高电平 >= 450, EN 周期 >= 1000, EN 上升后 360 内数据有效 */
+#define LCD_T_PW_NS         450
+#define LCD_T_CYCLE_NS      1000
+
+/* D4-D7 方向切换 (编译期计算的 CRL/CRH 掩码, 仅 LCD_DATA_CONTIGUOUS 时使用) */
+#define LCD_DATA_PINS       (LCD_D4_PIN | LCD_D5_PIN | LCD_D6_PIN | LCD_D7_PIN)
+
+static const GPIO_PortConfig_t lcd_data_output =
+    GPIO_PORT_CONFIG(LCD_D4_PORT, GPIO_CR_MASK(LCD_DATA_PINS),
+                     GPIO_CR_VALUE(LCD_DATA_PINS, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP));
+static const GPIO_PortConfig_t lcd_data_input =
+    GPIO_PORT_CONFIG(LCD_D4_PORT, GPIO_CR_MASK(LCD_DATA_PINS),
+                     GPIO_CR_VALUE(LCD_DATA_PINS, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING));
+
+/* 字形缓存槽位数 */
+#define LCD_GLYPH_SLOTS     (8 - LCD_GLYPH_FIRST_SLOT)
+
+/* 默认显示屏 (LCD1602_* 接口) */
+static LCD_Handle_t lcd_default = LCD_HANDLE_GPIO(LCD_ROWS, LCD_COLS, LCD_EN_PORT, LCD_EN_PIN);
+
+/* 后台刷新: TIM4 中断轮流服务已注册的并口显示屏 */
+static LCD_Handle_t *volatile lcd_async_list[LCD_MAX_DISPLAYS];
+static volatile uint8_t lcd_async_count = 0;
+static uint8_t lcd_async_next = 0;                  /* 轮询起点 */
+static LCD_Handle_t *lcd_async_owner = NULL;        /* 正在使用共用数据线的显示屏 */
 
 /* 私有函数声明 */
-static void LCD_WriteNibble(uint8_t nibble);
-static void LCD_WriteByte(uint8_t data, uint8_t rs);
-static void LCD_WriteCommand(uint8_t cmd);
-static void LCD_WriteData(uint8_t data);
-static void LCD_Enable(void);
+static void LCD_PutNibble(uint8_t nibble);
+static void LCD_WriteNibble(LCD_Handle_t *lcd, uint8_t nibble);
+static void LCD_WriteByte(LCD_Handle_t *lcd, uint8_t data, uint8_t rs);
+static void LCD_WriteBuffer(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs);
+static void LCD_WriteCommand(LCD_Handle_t *lcd, uint8_t cmd);
+static void LCD_WriteData(LCD_Handle_t *lcd, uint8_t data);
+static void LCD_Enable(LCD_Handle_t *lcd);
+static void LCD_SetDataInput(uint8_t input);
+static uint8_t LCD_WaitReady(LCD_Handle_t *lcd);
+static uint8_t LCD_Address(LCD_Handle_t *lcd, uint8_t row, uint8_t col);
+static void LCD_AsyncPush(LCD_Handle_t *lcd, uint16_t item);
+static void LCD_AsyncKick(void);
+static uint8_t LCD_AsyncEngineBusy(void);
+static uint16_t LCD_FB_Update(LCD_Handle_t *lcd, uint8_t async);
+static void LCD_VPrintf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, va_list args);
+static void LCD_FB_VPrintf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, va_list args);
+static void LCD_Track(LCD_Handle_t *lcd, uint8_t byte, uint8_t rs);
+static void LCD_WriteCGRAM(LCD_Handle_t *lcd, uint8_t location, const uint8_t *charmap);
+static uint8_t LCD_GlyphVisible(LCD_Handle_t *lcd, uint8_t slot);
+static void LCD_GPIO_Init(LCD_Handle_t *lcd);
+static void LCD_GPIO_WriteNibble(LCD_Handle_t *lcd, uint8_t nibble);
+static void LCD_GPIO_Write(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs);
+
+/* 分步初始化进度 (LCD_Handle_t.init_step) */
+#define LCD_INIT_NONE       0   /* 未初始化 */
+#define LCD_INIT_WAKE1      1   /* 上电等待后发送第1个 0x3 */
+#define LCD_INIT_WAKE2      2
+#define LCD_INIT_WAKE3      3
+#define LCD_INIT_4BIT       4   /* 切换到4位接口 */
+#define LCD_INIT_CONFIG     5   /* 功能设置, 显示开, 清屏 */
+#define LCD_INIT_ENTRY      6   /* 清屏完成后设置输入模式 */
+#define LCD_INIT_DONE       7
+
+/* 并口传输层 */
+const LCD_Transport_t LCD_TransportGPIO =
+{
+    LCD_GPIO_Init,
+    LCD_GPIO_WriteNibble,
+    LCD_GPIO_Write,
+    1
+};
 
 /**
-  * @brief  初始化 LCD1602
+  * @brief  初始化显示屏 (阻塞, 直到初始化序列完成)
+  * @param  lcd: 显示屏句柄 (已配置尺寸, 传输层和 EN 引脚/I2C 地址)
+  * @note   多块并口显示屏共用数据线时, 应在启动时依次初始化全部显示屏,
+  *         避免未初始化显示屏的 EN 引脚悬空; 不想等待时改用
+  *         LCD_InitStart() + LCD_InitStep()
   * @retval None
+  *
+  * 示例:
+  *   LCD_Handle_t lcd2 = LCD_HANDLE_GPIO(4, 20, GPIOA, GPIO_PIN_8);
+  *   LCD_Init(&lcd2);
   */
-void LCD1602_Init(void)
+void LCD_Init(LCD_Handle_t *lcd)
 {
-    /* 使能 GPIOB 时钟 */
-    RCC->APB2ENR |= RCC_APB2ENR_IOPBEN;
+    uint32_t wait;
     
-    /* 配置 GPIO 为输出 */
-    GPIO_Init(LCD_RS_PORT, LCD_RS_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
-    GPIO_Init(LCD_RW_PORT, LCD_RW_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
-    GPIO_Init(LCD_EN_PORT, LCD_EN_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
-    GPIO_Init(LCD_D4_PORT, LCD_D4_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
-    GPIO_Init(LCD_D5_PORT, LCD_D5_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
-    GPIO_Init(LCD_D6_PORT, LCD_D6_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
-    GPIO_Init(LCD_D7_PORT, LCD_D7_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+    LCD_InitStart(lcd);
     
-    /* 初始化引脚状态 */
-    GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN, GPIO_PIN_RESET);
-    GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_RESET);
-    GPIO_WritePin(LCD_EN_PORT, LCD_EN_PIN, GPIO_PIN_RESET);
+    while((wait = LCD_InitStep(lcd)) != 0)
+    {
+        /* 长等待时睡眠, 短等待忙等 */
+        if(wait >= 1000)
+            Delay_Ms(wait / 1000);
+        else
+            Delay_Us(wait);
+    }
+}
+
+/**
+  * @brief  开始分步初始化: 配置引脚或总线后立即返回
+  * @param  lcd: 显示屏句柄
+  * @note   上电等待 (LCD_POWERUP_MS) 从 Delay_Init() 起算, 启动时在这之后
+  *         初始化的其他外设与 LCD 上电并行; 之后反复调用 LCD_InitStep()
+  * @retval None
+  */
+void LCD_InitStart(LCD_Handle_t *lcd)
+{
+    uint64_t powerup = (uint64_t)LCD_POWERUP_MS * 1000;
+    uint64_t now;
     
-    /* 延时等待 LCD 上电稳定 */
-    Delay_Ms(50);
+    /* 尺寸超出帧缓冲时截断 */
+    if(lcd->rows > LCD_MAX_ROWS)
+        lcd->rows = LCD_MAX_ROWS;
+    if(lcd->cols > LCD_MAX_COLS)
+        lcd->cols = LCD_MAX_COLS;
+    if(lcd->rows * lcd->cols > LCD_MAX_CELLS)
+        lcd->rows = LCD_MAX_CELLS / lcd->cols;
     
-    /* 初始化序列 (4位模式) */
-    LCD_WriteNibble(0x03);
-    Delay_Ms(5);
-    LCD_WriteNibble(0x03);
-    Delay_Us(150);
-    LCD_WriteNibble(0x03);
-    Delay_Us(150);
-    LCD_WriteNibble(0x02);  /* 设置为4位模式 */
-    Delay_Us(150);
+    /* 配置引脚或总线 */
+    lcd->transport->init(lcd);
     
-    /* 功能设置: 4位接口, 2行, 5x7点阵 */
-    LCD_WriteCommand(LCD_CMD_FUNCTION_SET);
+    /* 初始化序列期间忙标志不可用, 使用固定延时 */
+    lcd->busy_mode = 0;
+    lcd->ddram_addr = 0;
+    lcd->cgram_mode = 0;
     
-    /* 显示设置: 显示开, 无光标 */
-    LCD_WriteCommand(LCD_CMD_DISPLAY_ON);
+    now = Delay_GetMicros();
+    lcd->init_due = (now < powerup) ? powerup : now;
+    lcd->init_step = LCD_INIT_WAKE1;
+}
+
+/**
+  * @brief  执行已到时间的下一步初始化, 不等待
+  * @param  lcd: 显示屏句柄 (未开始初始化时先调用 LCD_InitStart())
+  * @note   每步之间的等待由调用者安排 (如调度器任务或软件定时器);
+  *         完成前帧缓冲刷新不发送任何数据, 其他 LCD 函数不要调用
+  * @retval 距下一步的微秒数, 0 = 初始化已完成
+  *
+  * 示例: 每 1ms 调用一次, 返回 0 后开始刷新
+  *   if(LCD_InitStep(&lcd2) == 0) { ... }
+  */
+uint32_t LCD_InitStep(LCD_Handle_t *lcd)
+{
+    uint64_t now;
+    uint32_t wait;
+    
+    if(lcd->init_step == LCD_INIT_NONE)
+        LCD_InitStart(lcd);
+    if(lcd->init_step == LCD_INIT_DONE)
+        return 0;
     
-    /* 清屏 */
-    LCD1602_Clear();
+    now = Delay_GetMicros();
+    if(now < lcd->init_due)
+        return (uint32_t)(lcd->init_due - now);
+    
+    /* 初始化序列 (4位模式) */
+    switch(lcd->init_step)
+    {
+        case LCD_INIT_WAKE1:
+            LCD_WriteNibble(lcd, 0x03);
+            wait = 5000;
+            break;
+        
+        case LCD_INIT_WAKE2:
+        case LCD_INIT_WAKE3:
+            LCD_WriteNibble(lcd, 0x03);
+            wait = 150;
+            break;
+        
+        case LCD_INIT_4BIT:
+            LCD_WriteNibble(lcd, 0x02);  /* 设置为4位模式 */
+            wait = 150;
+            break;
+        
+        case LCD_INIT_CONFIG:
+            /* 功能设置: 4位接口, 2行, 5x7点阵 (20x4 的控制器同样按2行寻址) */
+            LCD_WriteCommand(lcd, LCD_CMD_FUNCTION_SET);
+            
+            /* 显示设置: 显示开, 无光标 */
+            LCD_WriteCommand(lcd, LCD_CMD_DISPLAY_ON);
+            
+            /* CGRAM 内容未知, 字形缓存清空, 手动字符失效 */
+            LCD_GlyphReset(lcd);
+            lcd->glyph_pinned = 0;
+            
+            /* 清屏 (同时同步帧缓冲), 清屏时间由下一步的等待保证 */
+            memset(lcd->fb, ' ', sizeof(lcd->fb));
+            memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+            lcd->fb_invalid = 0;
+            LCD_WriteCommand(lcd, LCD_CMD_CLEAR);
+            wait = 2000;
+            break;
+        
+        default:
+            /* 输入模式: 光标右移 */
+            LCD_WriteCommand(lcd, LCD_CMD_ENTRY_MODE);
+            
+            lcd->busy_mode = (LCD_USE_BUSY_FLAG && lcd->transport->busy_flag) ? 1 : 0;
+            lcd->init_step = LCD_INIT_DONE;
+            return 0;
+    }
     
-    /* 输入模式: 光标右移 */
-    LCD_WriteCommand(LCD_CMD_ENTRY_MODE);
+    lcd->init_step++;
+    lcd->init_due = Delay_GetMicros() + wait;
     
-    Delay_Ms(10);
+    return wait;
 }
 
 /**
   * @brief  清屏
+  * @param  lcd: 显示屏句柄
   * @retval None
   */
-void LCD1602_Clear(void)
+void LCD_Clear(LCD_Handle_t *lcd)
 {
-    LCD_WriteCommand(LCD_CMD_CLEAR);
-    Delay_Ms(2);
+    LCD_WriteCommand(lcd, LCD_CMD_CLEAR);
+    
+    /* 忙标志模式下 LCD_WriteByte 已等待清屏完成 */
+    if(!lcd->busy_mode)
+    {
+        Delay_Ms(2);
+    }
+    
+    /* 清屏后 LCD 上全是空格 */
+    memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+    lcd->fb_invalid = 0;
 }
 
 /**
   * @brief  设置光标位置
-  * @param  row: 行号 (0-1)
-  * @param  col: 列号 (0-15)
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号 (0 ~ rows-1)
+  * @param  col: 列号 (0 ~ cols-1)
   * @retval None
   */
-void LCD1602_SetCursor(uint8_t row, uint8_t col)
+void LCD_SetCursor(LCD_Handle_t *lcd, uint8_t row, uint8_t col)
 {
-    uint8_t address;
-    
-    if(row == 0)
-        address = 0x00 + col;  /* 第一行地址: 0x00-0x0F */
-    else
-        address = 0x40 + col;  /* 第二行地址: 0x40-0x4F */
-    
-    LCD_WriteCommand(0x80 | address);  /* 设置 DDRAM 地址 */
+    LCD_WriteCommand(lcd, 0x80 | LCD_Address(lcd, row, col));  /* 设置 DDRAM 地址 */
 }
 
 /**
   * @brief  打印字符串
+  * @param  lcd: 显示屏句柄
   * @param  str: 字符串
   * @retval None
   */
-void LCD1602_Print(const char *str)
+void LCD_Print(LCD_Handle_t *lcd, const char *str)
 {
-    while(*str)
-    {
-        LCD_WriteData(*str++);
-    }
+    /* 整串交给传输层, I2C 传输层可合并为一次总线传输 */
+    LCD_WriteBuffer(lcd, (const uint8_t *)str, strlen(str), 1);
 }
 
 /**
   * @brief  打印单个字符
+  * @param  lcd: 显示屏句柄
   * @param  ch: 字符
   * @retval None
   */
-void LCD1602_PrintChar(char ch)
+void LCD_PrintChar(LCD_Handle_t *lcd, char ch)
 {
-    LCD_WriteData(ch);
+    LCD_WriteData(lcd, ch);
 }
 
 /**
   * @brief  格式化打印 (类似 printf)
+  * @param  lcd: 显示屏句柄
   * @param  row: 行号
   * @param  col: 列号
   * @param  format: 格式化字符串
   * @retval None
   */
-void LCD1602_Printf(uint8_t row, uint8_t col, const char *format, ...)
+void LCD_Printf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, ...)
 {
-    char buffer[17];  /* LCD1602 每行最多16个字符 */
     va_list args;
     
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LCD_VPrintf(lcd, row, col, format, args);
     va_end(args);
-    
-    LCD1602_SetCursor(row, col);
-    LCD1602_Print(buffer);
 }
 
 /**
   * @brief  创建自定义字符
+  * @param  lcd: 显示屏句柄
   * @param  location: 字符位置 (0-7)
   * @param  charmap: 字符点阵数据 (8字节)
+  * @note   0 - LCD_GLYPH_FIRST_SLOT-1 为手动槽位; 更高的槽位从字形缓存中移除并固定,
+  *         直到重新初始化, LCD_Glyph() 不会再覆盖它
   * @retval None
   */
-void LCD1602_CreateChar(uint8_t location, uint8_t charmap[8])
+void LCD_CreateChar(LCD_Handle_t *lcd, uint8_t location, const uint8_t charmap[8])
 {
-    uint8_t i;
-    
     location &= 0x07;  /* 限制在 0-7 */
-    LCD_WriteCommand(0x40 | (location << 3));
     
-    for(i = 0; i < 8; i++)
+    /* 槽位被手动覆盖: 从字形缓存中移除, 不再参与分配 */
+    if(location >= LCD_GLYPH_FIRST_SLOT)
     {
-        LCD_WriteData(charmap[i]);
+        lcd->glyph_key[location - LCD_GLYPH_FIRST_SLOT] = NULL;
+        lcd->glyph_pinned |= (uint8_t)(1 << (location - LCD_GLYPH_FIRST_SLOT));
     }
     
-    LCD_WriteCommand(LCD_CMD_HOME);
+    LCD_WriteCGRAM(lcd, location, charmap);
 }
 
 /**
   * @brief  打开显示
+  * @param  lcd: 显示屏句柄
   * @retval None
   */
-void LCD1602_DisplayOn(void)
+void LCD_DisplayOn(LCD_Handle_t *lcd)
 {
-    LCD_WriteCommand(LCD_CMD_DISPLAY_ON);
+    LCD_WriteCommand(lcd, LCD_CMD_DISPLAY_ON);
 }
 
 /**
   * @brief  关闭显示
+  * @param  lcd: 显示屏句柄
   * @retval None
   */
-void LCD1602_DisplayOff(void)
+void LCD_DisplayOff(LCD_Handle_t *lcd)
 {
-    LCD_WriteCommand(LCD_CMD_DISPLAY_OFF);
+    LCD_WriteCommand(lcd, LCD_CMD_DISPLAY_OFF);
 }
 
 /**
-  * @brief  写4位数据
-  * @param  nibble: 4位数据
+  * @brief  设置忙标志查询模式
+  * @param  lcd: 显示屏句柄
+  * @param  enable: 1 = 查询 BF (需要 RW 引脚已连接), 0 = 固定延时
+  * @note   查询超时时自动回退到固定延时, 可用 LCD_GetBusyFlagMode() 检查;
+  *         传输层不支持忙标志时保持固定延时
   * @retval None
   */
-static void LCD_WriteNibble(uint8_t nibble)
+void LCD_SetBusyFlagMode(LCD_Handle_t *lcd, uint8_t enable)
 {
-    GPIO_WritePin(LCD_D4_PORT, LCD_D4_PIN, (nibble & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-    GPIO_WritePin(LCD_D5_PORT, LCD_D5_PIN, (nibble & 0x02) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-    GPIO_WritePin(LCD_D6_PORT, LCD_D6_PIN, (nibble & 0x04) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-    GPIO_WritePin(LCD_D7_PORT, LCD_D7_PIN, (nibble & 0x08) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    lcd->busy_mode = (enable && lcd->transport->busy_flag) ? 1 : 0;
+}
+
+/**
+  * @brief  获取当前忙标志查询模式
+  * @param  lcd: 显示屏句柄
+  * @retval 1 = 查询 BF, 0 = 固定延时
+  */
+uint8_t LCD_GetBusyFlagMode(LCD_Handle_t *lcd)
+{
+    return lcd->busy_mode;
+}
+
+/**
+  * @brief  清空帧缓冲 (不立即刷新)
+  * @param  lcd: 显示屏句柄
+  * @retval None
+  */
+void LCD_FB_Clear(LCD_Handle_t *lcd)
+{
+    memset(lcd->fb, ' ', sizeof(lcd->fb));
+}
+
+/**
+  * @brief  向帧缓冲写入单个字符
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号 (0 ~ rows-1)
+  * @param  col: 列号 (0 ~ cols-1)
+  * @param  ch: 字符 (0-7 为自定义字符)
+  * @retval None
+  */
+void LCD_FB_PutChar(LCD_Handle_t *lcd, uint8_t row, uint8_t col, char ch)
+{
+    if(row < lcd->rows && col < lcd->cols)
+    {
+        lcd->fb[row * lcd->cols + col] = ch;
+    }
+}
+
+/**
+  * @brief  向帧缓冲写入字符串, 超出行尾的部分被截断
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号
+  * @param  col: 起始列号
+  * @param  str: 字符串
+  * @retval None
+  */
+void LCD_FB_Print(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *str)
+{
+    if(row >= lcd->rows)
+        return;
     
-    LCD_Enable();
+    while(*str && col < lcd->cols)
+    {
+        lcd->fb[row * lcd->cols + col++] = *str++;
+    }
 }
 
 /**
-  * @brief  写8位数据
-  * @param  data: 8位数据
-  * @param  rs: RS引脚电平 (0=命令, 1=数据)
+  * @brief  格式化写入帧缓冲 (类似 printf)
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号
+  * @param  col: 列号
+  * @param  format: 格式化字符串
   * @retval None
   */
-static void LCD_WriteByte(uint8_t data, uint8_t rs)
+void LCD_FB_Printf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, ...)
 {
-    /* 设置 RS 引脚 */
-    GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN, rs ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    va_list args;
     
-    /* RW = 0 (写模式) */
-    GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_RESET);
+    va_start(args, format);
+    LCD_FB_VPrintf(lcd, row, col, format, args);
+    va_end(args);
+}
+
+/**
+  * @brief  标记 LCD 内容未知, 下次刷新时全部重写
+  * @param  lcd: 显示屏句柄
+  * @note   绕过帧缓冲直接调用 LCD_Print 等函数后需调用此函数
+  * @retval None
+  */
+void LCD_FB_Invalidate(LCD_Handle_t *lcd)
+{
+    lcd->fb_invalid = 1;
+}
+
+/**
+  * @brief  把帧缓冲中变化的字符刷新到 LCD
+  * @param  lcd: 显示屏句柄
+  * @note   连续变化的字符合并为一段, 每段只发送一次 SetCursor,
+  *         之后依靠 LCD 地址自动加一连续写入
+  * @retval 相比整屏重写 (每行 1 个 SetCursor + cols 个字符) 节省的字节数
+  */
+uint16_t LCD_FB_Flush(LCD_Handle_t *lcd)
+{
+    return LCD_FB_Update(lcd, 0);
+}
+
+/**
+  * @brief  把帧缓冲中变化的字符放入异步队列, 由 TIM4 中断在后台发送
+  * @param  lcd: 显示屏句柄
+  * @note   队列空间不足时只入队一部分, 其余字符保持"变化"状态,
+  *         下次调用时继续; 须先调用 LCD_AsyncInit()
+  *         非并口传输层时退化为同步刷新
+  * @retval 相比整屏重写节省的字节数
+  */
+uint16_t LCD_FB_FlushAsync(LCD_Handle_t *lcd)
+{
+    return LCD_FB_Update(lcd, lcd->transport == &LCD_TransportGPIO);
+}
+
+/**
+  * @brief  获取字形对应的字符码, 字形不在 CGRAM 中时上传 (淘汰最久未用的槽位)
+  * @param  lcd: 显示屏句柄 (每块显示屏有独立的 CGRAM 和字形缓存)
+  * @param  glyph: 字形点阵 (8字节), 按地址识别, 须为静态或全局数组
+  * @note   返回 8-15 (CGRAM 在 8-15 有镜像), 可直接放入字符串;
+  *         帧缓冲或屏幕上仍在显示的槽位不会被淘汰, 全部占用时返回 LCD_GLYPH_FALLBACK,
+  *         刷新后旧字形从屏幕上消失, 下一帧即可分配到槽位
+  * @retval 字符码
+  */
+char LCD_Glyph(LCD_Handle_t *lcd, const uint8_t glyph[8])
+{
+    uint8_t i, victim = LCD_GLYPH_SLOTS;
+    
+    lcd->glyph_clock++;
+    
+    /* 已在 CGRAM 中: 只更新使用时间 */
+    for(i = 0; i < LCD_GLYPH_SLOTS; i++)
+    {
+        if(lcd->glyph_key[i] == glyph)
+        {
+            lcd->glyph_used[i] = lcd->glyph_clock;
+            return (char)(8 + LCD_GLYPH_FIRST_SLOT + i);
+        }
+    }
+    
+    /* 选择空槽位, 否则选最久未用的槽位; 固定的和仍在屏幕上的槽位都跳过
+       (空槽位上也可能还显示着 LCD_GlyphReset() 之前的字形) */
+    for(i = 0; i < LCD_GLYPH_SLOTS; i++)
+    {
+        if(lcd->glyph_pinned & (1 << i))
+            continue;
     
-    /* 写高4位 */
-    LCD_WriteNibble(data >> 4);
+        if(LCD_GlyphVisible(lcd, LCD_GLYPH_FIRST_SLOT + i))
+            continue;
     
-    /* 写低4位 */
-    LCD_WriteNibble(data & 0x0F);
+        if(lcd->glyph_key[i] == NULL)
+        {
+            victim = i;
+            break;
+        }
     
-    Delay_Us(50);
+        if(victim == LCD_GLYPH_SLOTS || lcd->glyph_used[i] < lcd->glyph_used[victim])
+            victim = i;
+    }
+    
+    if(victim == LCD_GLYPH_SLOTS)
+        return LCD_GLYPH_FALLBACK;
+    
+    LCD_WriteCGRAM(lcd, LCD_GLYPH_FIRST_SLOT + victim, glyph);
+    lcd->glyph_key[victim] = glyph;
+    lcd->glyph_used[victim] = lcd->glyph_clock;
+    lcd->glyph_uploads++;
+    
+    return (char)(8 + LCD_GLYPH_FIRST_SLOT + victim);
 }
 
 /**
-  * @brief  写命令
-  * @param  cmd: 命令字节
+  * @brief  清空字形缓存 (所有槽位视为空闲, 下次使用时重新上传)
+  * @param  lcd: 显示屏句柄
+  * @note   CreateChar() 固定的槽位保持固定
   * @retval None
   */
-static void LCD_WriteCommand(uint8_t cmd)
+void LCD_GlyphReset(LCD_Handle_t *lcd)
 {
-    LCD_WriteByte(cmd, 0);
+    memset(lcd->glyph_key, 0, sizeof(lcd->glyph_key));
 }
 
 /**
-  * @brief  写数据
-  * @param  data: 数据字节
+  * @brief  获取字形上传次数 (用于确认缓存命中情况)
+  * @param  lcd: 显示屏句柄
+  * @retval 累计上传到 CGRAM 的次数
+  */
+uint32_t LCD_GlyphUploads(LCD_Handle_t *lcd)
+{
+    return lcd->glyph_uploads;
+}
+
+/**
+  * @brief  把显示屏加入后台异步刷新 (TIM4 更新中断)
+  * @param  lcd: 显示屏句柄
+  * @note   须在 LCD_Init() 之后调用; 只支持并口传输层, 最多 LCD_MAX_DISPLAYS 块;
+  *         多块显示屏的发送在中断中交错进行, 一块等待执行时间时发送另一块的数据
   * @retval None
   */
-static void LCD_WriteData(uint8_t data)
+void LCD_AsyncInit(LCD_Handle_t *lcd)
+{
+    uint8_t i;
+    
+    if(lcd->transport != &LCD_TransportGPIO)
+        return;
+    
+    lcd->async_head = 0;
+    lcd->async_tail = 0;
+    lcd->async_state = LCD_ASYNC_IDLE;
+    
+    for(i = 0; i < lcd_async_count; i++)
+    {
+        if(lcd_async_list[i] == lcd)
+            return;
+    }
+    
+    if(lcd_async_count >= LCD_MAX_DISPLAYS)
+        return;
+    
+    if(lcd_async_count == 0)
+    {
+        /* 使能 TIM4 时钟 */
+        RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
+    
+        /* 计数频率 1MHz, 时钟切换后由 PWM 驱动重新计算 PSC */
+        TIM4->CR1 = 0;
+        PWM_SetCountRate(TIM4, 1000000);
+        TIM4->ARR = LCD_ASYNC_TICK_US - 1;
+        TIM4->CNT = 0;
+        TIM4->SR = 0;
+        TIM4->DIER = TIM_DIER_UIE;
+    
+        NVIC_EnableIRQ(TIM4_IRQn);
+    }
+    
+    /* 先写入列表再增加计数, 中断只会看到完整的项 */
+    lcd_async_list[lcd_async_count] = lcd;
+    lcd_async_count++;
+}
+
+/**
+  * @brief  异步清屏
+  * @param  lcd: 显示屏句柄
+  * @retval SUCCESS = 已入队, ERROR = 队列已满
+  */
+ErrorStatus LCD_AsyncClear(LCD_Handle_t *lcd)
 {
-    LCD_WriteByte(data, 1);
+    if(LCD_AsyncFree(lcd) < 1)
+        return ERROR;
+    
+    LCD_AsyncPush(lcd, LCD_CMD_CLEAR | LCD_ASYNC_LONG);
+    LCD_AsyncKick();
+    
+    memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+    lcd->fb_invalid = 0;
+    
+    return SUCCESS;
 }
 
 /**
-  * @brief  使能脉冲
+  * @brief  异步设置光标位置
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号
+  * @param  col: 列号
+  * @retval SUCCESS = 已入队, ERROR = 队列已满
+  */
+ErrorStatus LCD_AsyncSetCursor(LCD_Handle_t *lcd, uint8_t row, uint8_t col)
+{
+    if(LCD_AsyncFree(lcd) < 1)
+        return ERROR;
+    
+    LCD_AsyncPush(lcd, 0x80 | LCD_Address(lcd, row, col));
+    LCD_AsyncKick();
+    
+    return SUCCESS;
+}
+
+/**
+  * @brief  异步打印字符串 (整串入队或整串放弃)
+  * @param  lcd: 显示屏句柄
+  * @param  str: 字符串
+  * @note   直接写 LCD, 与帧缓冲混用时需调用 LCD_FB_Invalidate()
+  * @retval SUCCESS = 已入队, ERROR = 队列空间不足
+  */
+ErrorStatus LCD_AsyncPrint(LCD_Handle_t *lcd, const char *str)
+{
+    if(LCD_AsyncFree(lcd) < strlen(str))
+        return ERROR;
+    
+    while(*str)
+    {
+        LCD_AsyncPush(lcd, LCD_ASYNC_RS | (uint8_t)*str++);
+    }
+    LCD_AsyncKick();
+    
+    return SUCCESS;
+}
+
+/**
+  * @brief  获取异步队列剩余空间
+  * @param  lcd: 显示屏句柄
+  * @note   后台刷新直接驱动并口引脚, 其他传输层时始终为0 (入队函数返回 ERROR)
+  * @retval 还可入队的字节数
+  */
+uint16_t LCD_AsyncFree(LCD_Handle_t *lcd)
+{
+    if(lcd->transport != &LCD_TransportGPIO)
+        return 0;
+    
+    return LCD_ASYNC_QUEUE_SIZE - (uint16_t)(lcd->async_head - lcd->async_tail);
+}
+
+/**
+  * @brief  查询后台是否仍在向该显示屏发送
+  * @param  lcd: 显示屏句柄
+  * @retval 1 = 队列非空或正在发送, 0 = 空闲
+  */
+uint8_t LCD_AsyncBusy(LCD_Handle_t *lcd)
+{
+    return (lcd->async_head != lcd->async_tail) || (lcd->async_state != LCD_ASYNC_IDLE);
+}
+
+/**
+  * @brief  获取默认显示屏句柄 (LCD1602_* 接口操作的显示屏)
+  * @retval 句柄指针
+  */
+LCD_Handle_t *LCD1602_Handle(void)
+{
+    return &lcd_default;
+}
+
+/**
+  * @brief  选择默认显示屏的传输层 (须在 LCD1602_Init() 之前调用)
+  * @param  transport: 传输层, 如 &LCD_TransportGPIO 或 &LCD_TransportPCF8574
+  * @retval None
+  */
+void LCD1602_SetTransport(const LCD_Transport_t *transport)
+{
+    lcd_default.transport = transport;
+}
+
+/**
+  * @brief  初始化 LCD1602
+  * @retval None
+  */
+void LCD1602_Init(void)
+{
+    LCD_Init(&lcd_default);
+}
+
+/**
+  * @brief  开始分步初始化 LCD1602, 立即返回
+  * @retval None
+  */
+void LCD1602_InitStart(void)
+{
+    LCD_InitStart(&lcd_default);
+}
+
+/**
+  * @brief  执行已到时间的下一步初始化, 不等待
+  * @retval 距下一步的微秒数, 0 = 初始化已完成
+  */
+uint32_t LCD1602_InitStep(void)
+{
+    return LCD_InitStep(&lcd_default);
+}
+
+/**
+  * @brief  清屏
+  * @retval None
+  */
+void LCD1602_Clear(void)
+{
+    LCD_Clear(&lcd_default);
+}
+
+/**
+  * @brief  设置光标位置
+  * @param  row: 行号 (0-1)
+  * @param  col: 列号 (0-15)
+  * @retval None
+  */
+void LCD1602_SetCursor(uint8_t row, uint8_t col)
+{
+    LCD_SetCursor(&lcd_default, row, col);
+}
+
+/**
+  * @brief  打印字符串
+  * @param  str: 字符串
   * @retval None
   */
-static void LCD_Enable(void)
+void LCD1602_Print(const char *str)
 {
-    GPIO_WritePin(LCD_EN_PORT, LCD_EN_PIN, GPIO_PIN_SET);
-    Delay_Us(1);
-    GPIO_WritePin(LCD_EN_PORT, LCD_EN_PIN, GPIO_PIN_RESET);
-    Delay_Us(1);
+    LCD_Print(&lcd_default, str);
 }
 
+/**
+  * @brief  打印单个字符
+  * @param  ch: 字符
+  * @retval None
+  */
+void LCD1602_PrintChar(char ch)
+{
+    LCD_PrintChar(&lcd_default, ch);
+}
+
+/**
+  * @brief  格式化打印 (类似 printf)
+  * @param  row: 行号
+  * @param  col: 列号
+  * @param  format: 格式化字符串
+  * @retval None
+  */
+void LCD1602_Printf(uint8_t row, uint8_t col, const char *format, ...)
+{
+    va_list args;
+    PROFILE_SCOPE(PROFILE_ZONE_LCD_PRINTF);
+    
+    va_start(args, format);
+    LCD_VPrintf(&lcd_default, row, col, format, args);
+    va_end(args);
+}
+
+/**
+  * @brief  创建自定义字符
+  * @param  location: 字符位置 (0-7)
+  * @param  charmap: 字符点阵数据 (8字节)
+  * @retval None
+  */
+void LCD1602_CreateChar(uint8_t location, uint8_t charmap[8])
+{
+    LCD_CreateChar(&lcd_default, location, charmap);
+}
+
+/**
+  * @brief  打开显示
+  * @retval None
+  */
+void LCD1602_DisplayOn(void)
+{
+    LCD_DisplayOn(&lcd_default);
+}
+
+/**
+  * @brief  关闭显示
+  * @retval None
+  */
+void LCD1602_DisplayOff(void)
+{
+    LCD_DisplayOff(&lcd_default);
+}
+
+/**
+  * @brief  设置忙标志查询模式
+  * @param  enable: 1 = 查询 BF (需要 RW 引脚已连接), 0 = 固定延时
+  * @retval None
+  */
+void LCD1602_SetBusyFlagMode(uint8_t enable)
+{
+    LCD_SetBusyFlagMode(&lcd_default, enable);
+}
+
+/**
+  * @brief  获取当前忙标志查询模式
+  * @retval 1 = 查询 BF, 0 = 固定延时
+  */
+uint8_t LCD1602_GetBusyFlagMode(void)
+{
+    return LCD_GetBusyFlagMode(&lcd_default);
+}
+
+/**
+  * @brief  清空帧缓冲 (不立即刷新)
+  * @retval None
+  */
+void LCD1602_FB_Clear(void)
+{
+    LCD_FB_Clear(&lcd_default);
+}
+
+/**
+  * @brief  向帧缓冲写入单个字符
+  * @param  row: 行号 (0 ~ LCD_ROWS-1)
+  * @param  col: 列号 (0 ~ LCD_COLS-1)
+  * @param  ch: 字符 (0-7 为自定义字符)
+  * @retval None
+  */
+void LCD1602_FB_PutChar(uint8_t row, uint8_t col, char ch)
+{
+    LCD_FB_PutChar(&lcd_default, row, col, ch);
+}
+
+/**
+  * @brief  向帧缓冲写入字符串, 超出行尾的部分被截断
+  * @param  row: 行号
+  * @param  col: 起始列号
+  * @param  str: 字符串
+  * @retval None
+  */
+void LCD1602_FB_Print(uint8_t row, uint8_t col, const char *str)
+{
+    LCD_FB_Print(&lcd_default, row, col, str);
+}
+
+/**
+  * @brief  格式化写入帧缓冲 (类似 printf)
+  * @param  row: 行号
+  * @param  col: 列号
+  * @param  format: 格式化字符串
+  * @retval None
+  */
+void LCD1602_FB_Printf(uint8_t row, uint8_t col, const char *format, ...)
+{
+    va_list args;
+    
+    va_start(args, format);
+    LCD_FB_VPrintf(&lcd_default, row, col, format, args);
+    va_end(args);
+}
+
+/**
+  * @brief  标记 LCD 内容未知, 下次刷新时全部重写
+  * @retval None
+  */
+void LCD1602_FB_Invalidate(void)
+{
+    LCD_FB_Invalidate(&lcd_default);
+}
+
+/**
+  * @brief  把帧缓冲中变化的字符刷新到 LCD
+  * @retval 相比整屏重写节省的字节数
+  */
+uint16_t LCD1602_FB_Flush(void)
+{
+    return LCD_FB_Flush(&lcd_default);
+}
+
+/**
+  * @brief  把帧缓冲中变化的字符放入异步队列, 由 TIM4 中断在后台发送
+  * @retval 相比整屏重写节省的字节数
+  */
+uint16_t LCD1602_FB_FlushAsync(void)
+{
+    return LCD_FB_FlushAsync(&lcd_default);
+}
+
+/**
+  * @brief  获取字形对应的字符码 (见 LCD_Glyph)
+  * @param  glyph: 字形点阵 (8字节)
+  * @retval 字符码
+  *
+  * 示例: LCD1602_FB_PutChar(0, 15, LCD1602_Glyph(heart));
+  */
+char LCD1602_Glyph(const uint8_t glyph[8])
+{
+    return LCD_Glyph(&lcd_default, glyph);
+}
+
+/**
+  * @brief  清空字形缓存
+  * @retval None
+  */
+void LCD1602_GlyphReset(void)
+{
+    LCD_GlyphReset(&lcd_default);
+}
+
+/**
+  * @brief  获取字形上传次数
+  * @retval 累计上传到 CGRAM 的次数
+  */
+uint32_t LCD1602_GlyphUploads(void)
+{
+    return LCD_GlyphUploads(&lcd_default);
+}
+
+/**
+  * @brief  初始化后台异步刷新 (TIM4 更新中断)
+  * @note   须在 LCD1602_Init() 之后调用; 队列为空时定时器自动停止
+  * @retval None
+  */
+void LCD1602_AsyncInit(void)
+{
+    LCD_AsyncInit(&lcd_default);
+}
+
+/**
+  * @brief  异步清屏
+  * @retval SUCCESS = 已入队, ERROR = 队列已满
+  */
+ErrorStatus LCD1602_AsyncClear(void)
+{
+    return LCD_AsyncClear(&lcd_default);
+}
+
+/**
+  * @brief  异步设置光标位置
+  * @param  row: 行号
+  * @param  col: 列号
+  * @retval SUCCESS = 已入队, ERROR = 队列已满
+  */
+ErrorStatus LCD1602_AsyncSetCursor(uint8_t row, uint8_t col)
+{
+    return LCD_AsyncSetCursor(&lcd_default, row, col);
+}
+
+/**
+  * @brief  异步打印字符串 (整串入队或整串放弃)
+  * @param  str: 字符串
+  * @retval SUCCESS = 已入队, ERROR = 队列空间不足
+  */
+ErrorStatus LCD1602_AsyncPrint(const char *str)
+{
+    return LCD_AsyncPrint(&lcd_default, str);
+}
+
+/**
+  * @brief  获取异步队列剩余空间
+  * @retval 还可入队的字节数
+  */
+uint16_t LCD1602_AsyncFree(void)
+{
+    return LCD_AsyncFree(&lcd_default);
+}
+
+/**
+  * @brief  查询后台是否仍在发送
+  * @retval 1 = 队列非空或正在发送, 0 = 空闲
+  */
+uint8_t LCD1602_AsyncBusy(void)
+{
+    return LCD_AsyncBusy(&lcd_default);
+}
+
+/**
+  * @brief  TIM4 中断: 异步刷新状态机, 每个节拍在共用数据线上输出一个半字节
+  * @note   EN 在下一个节拍开始时拉低 (下降沿锁存数据), 中断内没有任何忙等待;
+  *         所有显示屏的执行时间同时计时, 数据线空闲时轮流服务有数据的显示屏
+  * @retval None
+  */
+void TIM4_IRQHandler(void)
+{
+    LCD_Handle_t *lcd;
+    uint8_t i, n, count = lcd_async_count;
+    uint16_t item;
+    
+    MONITOR_ISR_ENTRY(MONITOR_SRC_LCD, Monitor_TimerLatency(TIM4));
+    
+    TIM4->SR = ~TIM_SR_UIF;
+    
+    /* 执行时间计时 */
+    for(i = 0; i < count; i++)
+    {
+        lcd = lcd_async_list[i];
+        if(lcd->async_state == LCD_ASYNC_WAIT && --lcd->async_wait == 0)
+            lcd->async_state = LCD_ASYNC_IDLE;
+    }
+    
+    /* 数据线被占用: 先完成该显示屏当前字节 */
+    lcd = lcd_async_owner;
+    if(lcd != NULL)
+    {
+        GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_RESET);
+    
+        if(lcd->async_state == LCD_ASYNC_LOW)
+        {
+            /* 高4位已锁存, 输出低4位 */
+            LCD_PutNibble(lcd->async_item & 0x0F);
+            GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_SET);
+            lcd->async_state = LCD_ASYNC_LATCH;
+            return;
+        }
+    
+        /* 低4位已锁存, 释放数据线 */
+        lcd->async_wait = (lcd->async_item & LCD_ASYNC_LONG) ?
+                          LCD_ASYNC_TICKS(2000) : LCD_ASYNC_TICKS(50);
+        lcd->async_state = LCD_ASYNC_WAIT;
+        lcd_async_owner = NULL;
+    }
+    
+    /* 数据线空闲: 从上次之后的显示屏开始轮询, 取下一项并输出高4位 */
+    for(n = 0; n < count; n++)
+    {
+        i = lcd_async_next;
+        lcd_async_next = (i + 1 < count) ? i + 1 : 0;
+        lcd = lcd_async_list[i];
+    
+        if(lcd->async_state != LCD_ASYNC_IDLE || lcd->async_tail == lcd->async_head)
+            continue;
+    
+        item = lcd->async_queue[lcd->async_tail & (LCD_ASYNC_QUEUE_SIZE - 1)];
+        lcd->async_tail++;
+        lcd->async_item = item;
+    
+        GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN, (item & LCD_ASYNC_RS) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+        LCD_PutNibble((item >> 4) & 0x0F);
+        GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_SET);
+        lcd->async_state = LCD_ASYNC_LOW;
+        lcd_async_owner = lcd;
+        return;
+    }
+    
+    /* 没有可发送的数据: 全部显示屏空闲时停止定时器 */
+    for(i = 0; i < count; i++)
+    {
+        if(LCD_AsyncBusy(lcd_async_list[i]))
+            return;
+    }
+    BITBAND_PERI(TIM4->CR1, TIM_CR1_CEN_BIT) = 0;
+}
+
+/**
+  * @brief  格式化打印 (va_list 版本)
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号
+  * @param  col: 列号
+  * @param  format: 格式化字符串
+  * @param  args: 参数列表
+  * @retval None
+  */
+static void LCD_VPrintf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, va_list args)
+{
+    char buffer[LCD_MAX_COLS + 1];  /* 每行最多 LCD_MAX_COLS 个字符 */
+    
+    vsnprintf(buffer, (size_t)lcd->cols + 1, format, args);
+    
+    LCD_SetCursor(lcd, row, col);
+    LCD_Print(lcd, buffer);
+}
+
+/**
+  * @brief  格式化写入帧缓冲 (va_list 版本)
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号
+  * @param  col: 列号
+  * @param  format: 格式化字符串
+  * @param  args: 参数列表
+  * @retval None
+  */
+static void LCD_FB_VPrintf(LCD_Handle_t *lcd, uint8_t row, uint8_t col, const char *format, va_list args)
+{
+    char buffer[LCD_MAX_COLS + 1];
+    
+    vsnprintf(buffer, (size_t)lcd->cols + 1, format, args);
+    
+    LCD_FB_Print(lcd, row, col, buffer);
+}
+
+/**
+  * @brief  刷新帧缓冲 (同步或异步)
+  * @param  lcd: 显示屏句柄
+  * @param  async: 1 = 放入异步队列, 0 = 直接写 LCD
+  * @retval 相比整屏重写节省的字节数
+  */
+static uint16_t LCD_FB_Update(LCD_Handle_t *lcd, uint8_t async)
+{
+    uint16_t full = (uint16_t)(lcd->rows * (lcd->cols + 1));
+    uint16_t sent = 0;
+    uint8_t row, col, end;
+    uint8_t cursor;
+    char *fb, *shadow;
+    
+    /* 分步初始化未完成时不发送 */
+    if(lcd->init_step != LCD_INIT_DONE)
+        return 0;
+    
+    for(row = 0; row < lcd->rows; row++)
+    {
+        cursor = lcd->cols;  /* 本行光标位置未知 */
+        fb = &lcd->fb[row * lcd->cols];
+        shadow = &lcd->shadow[row * lcd->cols];
+    
+        for(col = 0; col < lcd->cols; col++)
+        {
+            if(!lcd->fb_invalid && fb[col] == shadow[col])
+                continue;
+    
+            if(!async)
+            {
+                /* 同步: 整段变化的字符一次交给传输层 */
+                for(end = col + 1; end < lcd->cols; end++)
+                {
+                    if(!lcd->fb_invalid && fb[end] == shadow[end])
+                        break;
+                }
+    
+                LCD_SetCursor(lcd, row, col);
+                LCD_WriteBuffer(lcd, (const uint8_t *)&fb[col], end - col, 1);
+                memcpy(&shadow[col], &fb[col], end - col);
+                sent += 1 + (end - col);
+                col = end;  /* end 处未变化 (或已到行尾), 跳过 */
+                continue;
+            }
+    
+            /* 队列放不下 (定位命令 +) 字符时停止, 剩余字符留到下次 */
+            if(LCD_AsyncFree(lcd) < ((cursor != col) ? 2 : 1))
+            {
+                LCD_AsyncKick();
+                return full - sent;
+            }
+    
+            /* 新的一段: 光标不在此处时才需要重新定位 */
+            if(cursor != col)
+            {
+                LCD_AsyncPush(lcd, 0x80 | LCD_Address(lcd, row, col));
+                sent++;
+            }
+    
+            LCD_AsyncPush(lcd, LCD_ASYNC_RS | (uint8_t)fb[col]);
+            shadow[col] = fb[col];
+            sent++;
+            cursor = col + 1;
+        }
+    }
+    
+    lcd->fb_invalid = 0;
+    
+    if(async)
+        LCD_AsyncKick();
+    
+    return full - sent;
+}
+
+/**
+  * @brief  计算 DDRAM 地址
+  * @param  lcd: 显示屏句柄
+  * @param  row: 行号 (0-3)
+  * @param  col: 列号
+  * @note   控制器按2行寻址 (0x00/0x40 起), 4行显示屏的第2/3行接在第0/1行之后:
+  *         16x4 为 0x00/0x40/0x10/0x50, 20x4 为 0x00/0x40/0x14/0x54
+  * @retval DDRAM 地址
+  */
+static uint8_t LCD_Address(LCD_Handle_t *lcd, uint8_t row, uint8_t col)
+{
+    return ((row & 1) ? 0x40 : 0x00) + ((row & 2) ? lcd->cols : 0) + col;
+}
+
+/**
+  * @brief  根据写入的字节更新软件跟踪的地址计数器
+  * @param  lcd: 显示屏句柄
+  * @param  byte: 命令或数据
+  * @param  rs: 0 = 命令, 1 = 数据
+  * @note   输入模式固定为地址递增; 两行模式下 0x27 之后为 0x40, 0x67 之后回到 0x00
+  * @retval None
+  */
+static void LCD_Track(LCD_Handle_t *lcd, uint8_t byte, uint8_t rs)
+{
+    if(rs)
+    {
+        if(lcd->cgram_mode)
+            return;
+    
+        if(lcd->ddram_addr == 0x27)
+            lcd->ddram_addr = 0x40;
+        else if(lcd->ddram_addr == 0x67)
+            lcd->ddram_addr = 0x00;
+        else
+            lcd->ddram_addr++;
+    }
+    else if(byte & 0x80)
+    {
+        lcd->ddram_addr = byte & 0x7F;  /* 设置 DDRAM 地址 */
+        lcd->cgram_mode = 0;
+    }
+    else if(byte & 0x40)
+    {
+        lcd->cgram_mode = 1;            /* 设置 CGRAM 地址 */
+    }
+    else if(byte == LCD_CMD_CLEAR || (byte & 0xFE) == LCD_CMD_HOME)
+    {
+        lcd->ddram_addr = 0;
+        lcd->cgram_mode = 0;
+    }
+}
+
+/**
+  * @brief  写入一个 CGRAM 槽位, 完成后恢复原来的光标位置
+  * @param  lcd: 显示屏句柄
+  * @param  location: 槽位 (0-7)
+  * @param  charmap: 字符点阵数据 (8字节)
+  * @retval None
+  */
+static void LCD_WriteCGRAM(LCD_Handle_t *lcd, uint8_t location, const uint8_t *charmap)
+{
+    uint8_t addr = lcd->ddram_addr;
+    
+    LCD_WriteCommand(lcd, 0x40 | (location << 3));
+    LCD_WriteBuffer(lcd, charmap, 8, 1);
+    LCD_WriteCommand(lcd, 0x80 | addr);
+}
+
+/**
+  * @brief  检查槽位字符是否出现在帧缓冲或屏幕上
+  * @param  lcd: 显示屏句柄
+  * @param  slot: 槽位 (0-7)
+  * @retval 1 = 仍在使用, 0 = 可以淘汰
+  */
+static uint8_t LCD_GlyphVisible(LCD_Handle_t *lcd, uint8_t slot)
+{
+    const uint8_t *fb = (const uint8_t *)lcd->fb;
+    const uint8_t *shadow = (const uint8_t *)lcd->shadow;
+    uint16_t i, cells = lcd->rows * lcd->cols;
+    
+    for(i = 0; i < cells; i++)
+    {
+        /* 字符码 0-7 和 8-15 对应同一个槽位 */
+        if((fb[i] < 16 && (fb[i] & 0x07) == slot) ||
+           (shadow[i] < 16 && (shadow[i] & 0x07) == slot))
+            return 1;
+    }
+    
+    return 0;
+}
+
+/**
+  * @brief  向异步队列写入一项 (调用者已检查剩余空间)
+  * @param  lcd: 显示屏句柄
+  * @param  item: 队列项
+  * @retval None
+  */
+static void LCD_AsyncPush(LCD_Handle_t *lcd, uint16_t item)
+{
+    LCD_Track(lcd, (uint8_t)item, (item & LCD_ASYNC_RS) ? 1 : 0);
+    
+    lcd->async_queue[lcd->async_head & (LCD_ASYNC_QUEUE_SIZE - 1)] = item;
+    lcd->async_head++;
+}
+
+/**
+  * @brief  启动异步状态机
+  * @note   每次入队后都置位 CEN: 即使中断恰好在入队前停止了定时器也不会丢项;
+  *         位带写入只改变 CEN, 不会与中断中清除 CEN 的操作互相覆盖
+  * @retval None
+  */
+static void LCD_AsyncKick(void)
+{
+    BITBAND_PERI(TIM4->CR1, TIM_CR1_CEN_BIT) = 1;
+}
+
+/**
+  * @brief  查询后台是否仍在使用共用数据线 (任意显示屏)
+  * @retval 1 = 忙, 0 = 空闲
+  */
+static uint8_t LCD_AsyncEngineBusy(void)
+{
+    uint8_t i;
+    
+    for(i = 0; i < lcd_async_count; i++)
+    {
+        if(LCD_AsyncBusy(lcd_async_list[i]))
+            return 1;
+    }
+    
+    return 0;
+}
+
+/**
+  * @brief  输出4位数据到 D4-D7 (不产生使能脉冲)
+  * @param  nibble: 4位数据
+  * @note   LCD_DATA_CONTIGUOUS 为编译期常量, 未选中的分支由编译器删除
+  * @retval None
+  */
+static void LCD_PutNibble(uint8_t nibble)
+{
+    uint32_t bits = nibble & 0x0F;
+    
+    if(LCD_DATA_CONTIGUOUS)
+    {
+        /* BSRR 高16位复位, 低16位置位: 一次写入同时改变4根数据线 */
+        LCD_D4_PORT->BSRR = ((bits ^ 0x0F) * LCD_D4_PIN << 16) | (bits * LCD_D4_PIN);
+        return;
+    }
+    
+    /* 引脚分散: 逐个写入 */
+    GPIO_WritePin(LCD_D4_PORT, LCD_D4_PIN, (nibble & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_D5_PORT, LCD_D5_PIN, (nibble & 0x02) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_D6_PORT, LCD_D6_PIN, (nibble & 0x04) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_D7_PORT, LCD_D7_PIN, (nibble & 0x08) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+/**
+  * @brief  写4位数据
+  * @param  lcd: 显示屏句柄
+  * @param  nibble: 4位数据
+  * @retval None
+  */
+static void LCD_WriteNibble(LCD_Handle_t *lcd, uint8_t nibble)
+{
+    lcd->transport->write_nibble(lcd, nibble);
+}
+
+/**
+  * @brief  写8位数据
+  * @param  lcd: 显示屏句柄
+  * @param  data: 8位数据
+  * @param  rs: RS引脚电平 (0=命令, 1=数据)
+  * @retval None
+  */
+static void LCD_WriteByte(LCD_Handle_t *lcd, uint8_t data, uint8_t rs)
+{
+    LCD_WriteBuffer(lcd, &data, 1, rs);
+}
+
+/**
+  * @brief  连续写入多个字节
+  * @param  lcd: 显示屏句柄
+  * @param  data: 数据
+  * @param  len: 字节数
+  * @param  rs: RS引脚电平 (0=命令, 1=数据)
+  * @retval None
+  */
+static void LCD_WriteBuffer(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs)
+{
+    uint16_t i;
+    
+    if(len == 0)
+        return;
+    
+    /* 并口: 等待后台发送完成, 避免与中断争用共用数据线 */
+    if(lcd->transport == &LCD_TransportGPIO)
+    {
+        while(LCD_AsyncEngineBusy())
+        {
+        }
+    }
+    
+    lcd->transport->write(lcd, data, len, rs);
+    
+    for(i = 0; i < len; i++)
+    {
+        LCD_Track(lcd, data[i], rs);
+    }
+}
+
+/**
+  * @brief  写命令
+  * @param  lcd: 显示屏句柄
+  * @param  cmd: 命令字节
+  * @retval None
+  */
+static void LCD_WriteCommand(LCD_Handle_t *lcd, uint8_t cmd)
+{
+    LCD_WriteByte(lcd, cmd, 0);
+}
+
+/**
+  * @brief  写数据
+  * @param  lcd: 显示屏句柄
+  * @param  data: 数据字节
+  * @retval None
+  */
+static void LCD_WriteData(LCD_Handle_t *lcd, uint8_t data)
+{
+    LCD_WriteByte(lcd, data, 1);
+}
+
+/**
+  * @brief  并口传输层: 配置引脚
+  * @param  lcd: 显示屏句柄
+  * @retval None
+  */
+static void LCD_GPIO_Init(LCD_Handle_t *lcd)
+{
+    /* 使能 GPIOB 时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPBEN;
+    
+    /* 配置 GPIO 为输出 (数据线为共用引脚, 重复配置不影响其他显示屏) */
+    GPIO_Init(LCD_RS_PORT, LCD_RS_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+    GPIO_Init(LCD_RW_PORT, LCD_RW_PIN, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+    GPIO_Init(lcd->en_port, lcd->en_pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+    LCD_SetDataInput(0);
+    
+    /* 初始化引脚状态 */
+    GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN, GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_RESET);
+    GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_RESET);
+}
+
+/**
+  * @brief  并口传输层: 写4位数据并产生使能脉冲
+  * @param  lcd: 显示屏句柄
+  * @param  nibble: 4位数据
+  * @retval None
+  */
+static void LCD_GPIO_WriteNibble(LCD_Handle_t *lcd, uint8_t nibble)
+{
+    LCD_PutNibble(nibble);
+    LCD_Enable(lcd);
+}
+
+/**
+  * @brief  并口传输层: 逐字节写入, 每字节后查询忙标志或固定延时
+  * @param  lcd: 显示屏句柄
+  * @param  data: 数据
+  * @param  len: 字节数
+  * @param  rs: RS引脚电平 (0=命令, 1=数据)
+  * @retval None
+  */
+static void LCD_GPIO_Write(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs)
+{
+    while(len--)
+    {
+        /* 设置 RS 引脚 (查询忙标志时被拉低, 每字节重新设置) */
+        GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN, rs ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    
+        /* RW = 0 (写模式) */
+        GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_RESET);
+    
+        /* 写高4位 */
+        LCD_GPIO_WriteNibble(lcd, *data >> 4);
+    
+        /* 写低4位 */
+        LCD_GPIO_WriteNibble(lcd, *data++ & 0x0F);
+    
+        if(lcd->busy_mode)
+        {
+            if(LCD_WaitReady(lcd))
+                continue;
+    
+            /* 查询超时 (RW 未连接或 LCD 无响应): 回退到固定延时 */
+            lcd->busy_mode = 0;
+        }
+    
+        Delay_Us(50);
+    }
+}
+
+/**
+  * @brief  使能脉冲
+  * @param  lcd: 显示屏句柄
+  * @retval None
+  */
+static void LCD_Enable(LCD_Handle_t *lcd)
+{
+    GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_SET);
+    Delay_Ns(LCD_T_PW_NS);
+    GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_RESET);
+    Delay_Ns(LCD_T_CYCLE_NS - LCD_T_PW_NS);
+}
+
+/**
+  * @brief  切换数据线 D4-D7 方向
+  * @param  input: 1 = 输入 (读忙标志时 LCD 驱动全部4根数据线), 0 = 推挽输出
+  * @note   每次查询忙标志调用两次: 数据线连续时只需一次预先算好掩码的 CRH 写入
+  * @retval None
+  */
+static void LCD_SetDataInput(uint8_t input)
+{
+    uint32_t mode = input ? GPIO_MODE_INPUT : GPIO_MODE_OUTPUT_50MHZ;
+    uint32_t cnf = input ? GPIO_CNF_INPUT_FLOATING : GPIO_CNF_OUTPUT_PP;
+    
+    if(LCD_DATA_CONTIGUOUS)
+    {
+        GPIO_InitPort(input ? &lcd_data_input : &lcd_data_output);
+        return;
+    }
+    
+    /* 引脚分散: 逐个配置 */
+    
+    GPIO_Init(LCD_D4_PORT, LCD_D4_PIN, mode, cnf);
+    GPIO_Init(LCD_D5_PORT, LCD_D5_PIN, mode, cnf);
+    GPIO_Init(LCD_D6_PORT, LCD_D6_PIN, mode, cnf);
+    GPIO_Init(LCD_D7_PORT, LCD_D7_PIN, mode, cnf);
+}
+
+/**
+  * @brief  查询忙标志直到 LCD 空闲
+  * @param  lcd: 显示屏句柄
+  * @note   BF 在 D7 上, 4位模式下每次查询需读两次 (高4位含 BF, 低4位丢弃)
+  * @retval 1 = LCD 空闲, 0 = 超过 LCD_BUSY_POLL_MAX 次仍忙
+  */
+static uint8_t LCD_WaitReady(LCD_Handle_t *lcd)
+{
+    uint16_t polls;
+    GPIO_PinState busy = GPIO_PIN_SET;
+    
+    LCD_SetDataInput(1);
+    
+    /* RS = 0, RW = 1: 读忙标志和地址 */
+    GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN, GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_SET);
+    
+    for(polls = 0; polls < LCD_BUSY_POLL_MAX && busy == GPIO_PIN_SET; polls++)
+    {
+        /* 高4位: EN 高电平期间数据有效 */
+        GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_SET);
+        Delay_Ns(LCD_T_PW_NS);
+        busy = GPIO_ReadPin(LCD_D7_PORT, LCD_D7_PIN);
+        GPIO_WritePin(lcd->en_port, lcd->en_pin, GPIO_PIN_RESET);
+        Delay_Ns(LCD_T_CYCLE_NS - LCD_T_PW_NS);
+    
+        /* 低4位: 地址计数器, 丢弃 */
+        LCD_Enable(lcd);
+    }
+    
+    GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_RESET);
+    LCD_SetDataInput(0);
+    
+    return (busy == GPIO_PIN_RESET) ? 1 : 0;
+}
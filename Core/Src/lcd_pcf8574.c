@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file    lcd_pcf8574.c
+  * @brief   LCD1602 I2C 转接板 (PCF8574) 传输层实现
+  ******************************************************************************
+  * 每个半字节需要两次端口写入 (EN 高 -> EN 低, 下降沿锁存), 一个字符 4 字节。
+  * 整个字符串的所有半字节和使能序列先在缓冲区中展开, 再用一次 I2C 传输发出,
+  * 而不是每个字符 (或每次端口写入) 一次传输: 省去了每次传输的 START/地址/STOP
+  * 以及等待中断调度的开销。
+  ******************************************************************************
+  */
+
+#include "lcd_pcf8574.h"
+#include "system_stm32f1xx.h"
+#include "delay.h"
+#include <stddef.h>
+
+/* 最近一次传输的结果和耗时 */
+static I2C_Status_t lcd_status = I2C_OK;
+static uint32_t lcd_write_us = 0;
+
+/* 展开后的端口数据 */
+static uint8_t lcd_burst[LCD_PCF8574_BURST_CHARS * 4];
+
+/* 私有函数声明 */
+static void PCF8574_Init(LCD_Handle_t *lcd);
+static void PCF8574_WriteNibble(LCD_Handle_t *lcd, uint8_t nibble);
+static void PCF8574_Write(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs);
+static void PCF8574_Send(LCD_Handle_t *lcd, const uint8_t *buf, uint16_t len);
+
+/* I2C 转接板传输层 */
+const LCD_Transport_t LCD_TransportPCF8574 =
+{
+    PCF8574_Init,
+    PCF8574_WriteNibble,
+    PCF8574_Write,
+    0
+};
+
+/**
+  * @brief  设置默认显示屏的转接板所在总线和地址 (须在 LCD1602_Init() 之前调用)
+  * @param  I2Cx: I2C1 或 I2C2
+  * @param  addr: 7位地址
+  * @note   未调用时使用 I2C1 和 LCD_PCF8574_ADDR; 其他显示屏用 LCD_HANDLE_PCF8574 配置
+  * @retval None
+  *
+  * 示例:
+  *   LCD_PCF8574_Config(I2C1, 0x3F);
+  *   LCD1602_SetTransport(&LCD_TransportPCF8574);
+  *   LCD1602_Init();
+  */
+void LCD_PCF8574_Config(I2C_TypeDef *I2Cx, uint8_t addr)
+{
+    LCD_Handle_t *lcd = LCD1602_Handle();
+
+    lcd->i2c = I2Cx;
+    lcd->i2c_addr = addr;
+    lcd->backlight = LCD_PCF8574_BL;
+}
+
+/**
+  * @brief  打开/关闭默认显示屏的背光
+  * @param  on: 1 = 打开, 0 = 关闭
+  * @retval None
+  */
+void LCD_PCF8574_SetBacklight(uint8_t on)
+{
+    LCD_PCF8574_Backlight(LCD1602_Handle(), on);
+}
+
+/**
+  * @brief  打开/关闭指定显示屏的背光
+  * @param  lcd: 使用 I2C 转接板传输层的显示屏句柄
+  * @param  on: 1 = 打开, 0 = 关闭
+  * @retval None
+  */
+void LCD_PCF8574_Backlight(LCD_Handle_t *lcd, uint8_t on)
+{
+    uint8_t port;
+
+    lcd->backlight = on ? LCD_PCF8574_BL : 0;
+
+    port = lcd->backlight;
+    PCF8574_Send(lcd, &port, 1);
+}
+
+/**
+  * @brief  获取最近一次 I2C 传输的结果
+  * @retval I2C_OK 或错误码 (如 I2C_ERR_NACK 表示地址错误或未连接)
+  */
+I2C_Status_t LCD_PCF8574_GetStatus(void)
+{
+    return lcd_status;
+}
+
+/**
+  * @brief  获取最近一次写入 (如一次 LCD1602_Print) 的总线传输时间
+  * @note   使用 DWT 周期计数器 (Delay_Init 中使能), 未调用 Delay_Init 时返回 0
+  * @retval 传输时间 (us)
+  */
+uint32_t LCD_PCF8574_GetLastWriteUs(void)
+{
+    return lcd_write_us;
+}
+
+/**
+  * @brief  初始化 I2C 总线 (尚未初始化时), 端口全部拉低 (只保留背光)
+  * @param  lcd: 显示屏句柄
+  * @note   未配置总线时使用 I2C1, LCD_PCF8574_ADDR 并打开背光;
+  *         多块转接板可共用一条总线: 已初始化的总线保持原速率和队列,
+  *         不影响已有的显示屏
+  * @retval None
+  */
+static void PCF8574_Init(LCD_Handle_t *lcd)
+{
+    uint8_t port;
+
+    if(lcd->i2c == NULL)
+    {
+        lcd->i2c = I2C1;
+        lcd->i2c_addr = LCD_PCF8574_ADDR;
+        lcd->backlight = LCD_PCF8574_BL;
+    }
+
+    port = lcd->backlight;
+    if(!I2C_IsInit(lcd->i2c))
+        I2C_Init(lcd->i2c, LCD_PCF8574_SPEED);
+    PCF8574_Send(lcd, &port, 1);
+}
+
+/**
+  * @brief  写4位数据 (初始化序列, RS = 0)
+  * @param  lcd: 显示屏句柄
+  * @param  nibble: 4位数据
+  * @retval None
+  */
+static void PCF8574_WriteNibble(LCD_Handle_t *lcd, uint8_t nibble)
+{
+    uint8_t buf[2];
+
+    buf[0] = (nibble << 4) | lcd->backlight | LCD_PCF8574_EN;
+    buf[1] = (nibble << 4) | lcd->backlight;
+    PCF8574_Send(lcd, buf, sizeof(buf));
+}
+
+/**
+  * @brief  连续写入多个字节, 每 LCD_PCF8574_BURST_CHARS 个字符一次 I2C 传输
+  * @param  lcd: 显示屏句柄
+  * @param  data: 数据
+  * @param  len: 字节数
+  * @param  rs: RS 电平 (0=命令, 1=数据)
+  * @note   同一传输中相邻字符的锁存间隔为 2 字节总线时间, 已满足执行时间,
+  *         不需要额外延时
+  * @retval None
+  */
+static void PCF8574_Write(LCD_Handle_t *lcd, const uint8_t *data, uint16_t len, uint8_t rs)
+{
+    uint8_t ctrl = lcd->backlight | (rs ? LCD_PCF8574_RS : 0);
+    uint32_t start = Delay_GetCycles();
+    uint16_t n;
+    uint8_t *p;
+
+    while(len)
+    {
+        p = lcd_burst;
+
+        for(n = 0; n < len && n < LCD_PCF8574_BURST_CHARS; n++)
+        {
+            uint8_t hi = (*data & 0xF0) | ctrl;
+            uint8_t lo = (uint8_t)(*data++ << 4) | ctrl;
+
+            *p++ = hi | LCD_PCF8574_EN;
+            *p++ = hi;
+            *p++ = lo | LCD_PCF8574_EN;
+            *p++ = lo;
+        }
+
+        len -= n;
+        PCF8574_Send(lcd, lcd_burst, p - lcd_burst);
+    }
+
+    lcd_write_us = Delay_ElapsedUs(start);
+}
+
+/**
+  * @brief  发送端口数据并等待传输完成
+  * @param  lcd: 显示屏句柄
+  * @param  buf: 端口数据
+  * @param  len: 字节数
+  * @retval None
+  */
+static void PCF8574_Send(LCD_Handle_t *lcd, const uint8_t *buf, uint16_t len)
+{
+    I2C_Transfer_t xfer = { 0 };
+
+    xfer.addr = lcd->i2c_addr;
+    xfer.tx_buf = buf;
+    xfer.tx_len = len;
+
+    if(I2C_Submit(lcd->i2c, &xfer) != SUCCESS)
+    {
+        lcd_status = I2C_ERR_BUS;
+        return;
+    }
+
+    lcd_status = I2C_Wait(&xfer);
+}
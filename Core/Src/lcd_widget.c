@@ -0,0 +1,254 @@
+/**
+  ******************************************************************************
+  * @file    lcd_widget.c
+  * @brief   LCD1602 图形控件实现
+  ******************************************************************************
+  */
+
+#include "lcd_widget.h"
+#include <string.h>
+
+/* 整格 (字符 ROM 中的全黑方块) */
+#define WIDGET_FULL         ((char)0xFF)
+
+/* 条形图: 左侧填充 1-4 列的部分格 */
+static const uint8_t widget_bar_glyph[4][8] =
+{
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 },
+    { 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 },
+    { 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C },
+    { 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E }
+};
+
+/* 迷你折线图: 底部填充 2/4/6 行 (0 行为空格, 8 行为整格) */
+static const uint8_t widget_spark_glyph[WIDGET_SPARK_LEVELS - 2][8] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F },
+    { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F },
+    { 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }
+};
+
+/* 大号数字笔画: 上横, 下横, 上下横 (竖笔画用整格) */
+static const uint8_t widget_big_glyph[3][8] =
+{
+    { 0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F },
+    { 0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x1F, 0x1F, 0x1F }
+};
+
+/* 大号数字字形: 每个数字 2 行 x 3 列, 中横画位于上半格底部
+ * ' ' = 空, 'F' = 整格, 'T' = 上横, 'B' = 下横, 'D' = 上下横 */
+static const char widget_big_font[10][2][WIDGET_BIG_WIDTH + 1] =
+{
+    { "FTF", "FBF" },   /* 0 */
+    { "TF ", "BFB" },   /* 1 */
+    { "DDF", "FBB" },   /* 2 */
+    { "DDF", "BBF" },   /* 3 */
+    { "FBF", "  F" },   /* 4 */
+    { "FDD", "BBF" },   /* 5 */
+    { "FDD", "FBF" },   /* 6 */
+    { "TTF", "  F" },   /* 7 */
+    { "FDF", "FBF" },   /* 8 */
+    { "FDF", "BBF" }    /* 9 */
+};
+
+/* 控件绘制的目标显示屏 */
+static LCD_Handle_t *widget_lcd = NULL;
+
+/* 私有函数声明 */
+static char Widget_BigCell(char stroke);
+
+/**
+  * @brief  选择控件绘制的目标显示屏
+  * @param  lcd: 显示屏句柄, NULL = 默认显示屏 (LCD1602_Handle())
+  * @note   字形缓存按显示屏独立, 切换目标后字形会上传到新目标的 CGRAM
+  * @retval None
+  */
+void Widget_SetTarget(LCD_Handle_t *lcd)
+{
+    widget_lcd = (lcd != NULL) ? lcd : LCD1602_Handle();
+}
+
+/**
+  * @brief  绘制水平条形图 (每个字符 5 个像素列)
+  * @param  row: 行号
+  * @param  col: 起始列号
+  * @param  width: 宽度 (字符数)
+  * @param  value: 当前值 (超过 max 按 max 显示)
+  * @param  max: 满量程值 (value x width x 5 不能超过 32 位)
+  * @retval None
+  *
+  * 示例: Widget_Bar(0, 4, 12, adc_value, 4095);
+  */
+void Widget_Bar(uint8_t row, uint8_t col, uint8_t width, uint32_t value, uint32_t max)
+{
+    uint32_t pixels;
+    uint8_t i, rem;
+
+    if(widget_lcd == NULL)
+        Widget_SetTarget(NULL);
+
+    if(max == 0)
+        return;
+
+    if(value > max)
+        value = max;
+
+    /* 四舍五入到像素列 */
+    pixels = (value * width * 5 + max / 2) / max;
+
+    for(i = 0; i < width; i++)
+    {
+        if(pixels >= 5)
+        {
+            LCD_FB_PutChar(widget_lcd, row, col + i, WIDGET_FULL);
+            pixels -= 5;
+        }
+        else if(pixels > 0)
+        {
+            rem = (uint8_t)pixels;
+            LCD_FB_PutChar(widget_lcd, row, col + i, LCD_Glyph(widget_lcd, widget_bar_glyph[rem - 1]));
+            pixels = 0;
+        }
+        else
+        {
+            LCD_FB_PutChar(widget_lcd, row, col + i, ' ');
+        }
+    }
+}
+
+/**
+  * @brief  初始化迷你折线图
+  * @param  spark: 折线图状态
+  * @param  row: 行号
+  * @param  col: 起始列号
+  * @param  width: 宽度 (字符数, 最大 LCD_MAX_COLS), 即显示的采样数
+  * @retval None
+  */
+void Widget_SparkInit(Widget_Spark_t *spark, uint8_t row, uint8_t col, uint8_t width)
+{
+    if(widget_lcd == NULL)
+        Widget_SetTarget(NULL);
+
+    if(width > LCD_MAX_COLS)
+        width = LCD_MAX_COLS;
+
+    spark->row = row;
+    spark->col = col;
+    spark->width = width;
+    spark->count = 0;
+
+    /* 清空显示区域 */
+    while(width--)
+    {
+        LCD_FB_PutChar(widget_lcd, row, col++, ' ');
+    }
+}
+
+/**
+  * @brief  加入一个采样并重绘 (新采样在最右侧, 旧采样左移)
+  * @param  spark: 折线图状态
+  * @param  value: 采样值 (超过 max 按 max 显示)
+  * @param  max: 满量程值 (value x (WIDGET_SPARK_LEVELS - 1) 不能超过 32 位)
+  * @retval None
+  */
+void Widget_SparkPush(Widget_Spark_t *spark, uint32_t value, uint32_t max)
+{
+    uint8_t i, level, offset;
+
+    if(widget_lcd == NULL)
+        Widget_SetTarget(NULL);
+
+    if(max == 0)
+        return;
+
+    if(value > max)
+        value = max;
+
+    /* 四舍五入到级 */
+    level = (uint8_t)((value * (WIDGET_SPARK_LEVELS - 1) + max / 2) / max);
+
+    if(spark->count < spark->width)
+    {
+        spark->level[spark->count++] = level;
+    }
+    else
+    {
+        memmove(&spark->level[0], &spark->level[1], spark->width - 1);
+        spark->level[spark->width - 1] = level;
+    }
+
+    /* 采样不足时右对齐, 左侧留空 */
+    offset = spark->width - spark->count;
+
+    for(i = 0; i < spark->count; i++)
+    {
+        level = spark->level[i];
+        if(level == 0)
+            LCD_FB_PutChar(widget_lcd, spark->row, spark->col + offset + i, ' ');
+        else if(level == WIDGET_SPARK_LEVELS - 1)
+            LCD_FB_PutChar(widget_lcd, spark->row, spark->col + offset + i, WIDGET_FULL);
+        else
+            LCD_FB_PutChar(widget_lcd, spark->row, spark->col + offset + i,
+                           LCD_Glyph(widget_lcd, widget_spark_glyph[level - 1]));
+    }
+}
+
+/**
+  * @brief  显示大号数字 (占 row 和 row+1 两行, 右对齐, 前导零不显示)
+  * @param  row: 上半部分所在行
+  * @param  col: 起始列号
+  * @param  value: 数值
+  * @param  digits: 位数, 总宽度为 digits x 4 - 1 列
+  * @retval None
+  *
+  * 示例: Widget_BigNumber(0, 0, rpm, 4);  // 4 位, 占 15 列
+  */
+void Widget_BigNumber(uint8_t row, uint8_t col, uint32_t value, uint8_t digits)
+{
+    uint8_t d, i, x, digit;
+    uint8_t blank;
+
+    if(widget_lcd == NULL)
+        Widget_SetTarget(NULL);
+
+    for(d = digits; d > 0; d--)
+    {
+        digit = value % 10;
+        value /= 10;
+
+        /* 最低位总是显示, 更高位在数值已经用完时留空 */
+        blank = (d != digits && digit == 0 && value == 0);
+        x = col + (d - 1) * (WIDGET_BIG_WIDTH + 1);
+
+        for(i = 0; i < WIDGET_BIG_WIDTH; i++)
+        {
+            LCD_FB_PutChar(widget_lcd, row, x + i, blank ? ' ' : Widget_BigCell(widget_big_font[digit][0][i]));
+            LCD_FB_PutChar(widget_lcd, row + 1, x + i, blank ? ' ' : Widget_BigCell(widget_big_font[digit][1][i]));
+        }
+
+        /* 数字间隔 */
+        if(d != digits)
+        {
+            LCD_FB_PutChar(widget_lcd, row, x + WIDGET_BIG_WIDTH, ' ');
+            LCD_FB_PutChar(widget_lcd, row + 1, x + WIDGET_BIG_WIDTH, ' ');
+        }
+    }
+}
+
+/**
+  * @brief  把字形表中的笔画转换为字符码
+  * @param  stroke: 笔画 (' ', 'F', 'T', 'B', 'D')
+  * @retval 字符码
+  */
+static char Widget_BigCell(char stroke)
+{
+    switch(stroke)
+    {
+        case 'F': return WIDGET_FULL;
+        case 'T': return LCD_Glyph(widget_lcd, widget_big_glyph[0]);
+        case 'B': return LCD_Glyph(widget_lcd, widget_big_glyph[1]);
+        case 'D': return LCD_Glyph(widget_lcd, widget_big_glyph[2]);
+        default:  return ' ';
+    }
+}
@@ -0,0 +1,475 @@
+/**
+  ******************************************************************************
+  * @file    logic.c
+  * @brief   逻辑分析仪驱动实现 - 定时器触发 DMA 并行采集 GPIO 端口
+  ******************************************************************************
+  */
+
+#include "logic.h"
+#include "gpio.h"
+#include "pwm.h"
+#include "uart.h"
+#include "bitband.h"
+#include <stddef.h>
+
+#if (LOGIC_SAMPLES & 1) != 0 || LOGIC_SAMPLES > 65534
+#error "LOGIC_SAMPLES must be even, at most 65534"
+#endif
+
+/* 采样定时器和对应的 DMA 通道 (定时器更新事件的固定映射) */
+#if LOGIC_TIMER == 2
+#define LOGIC_TIM               TIM2
+#define LOGIC_TIM_EN            RCC_APB1ENR_TIM2EN
+#define LOGIC_DMA               DMA1_Channel2
+#define LOGIC_DMA_NUM           2
+#define LOGIC_DMA_IRQn          DMA1_Channel2_IRQn
+#define Logic_DMA_IRQHandler    DMA1_Channel2_IRQHandler
+#elif LOGIC_TIMER == 3
+#define LOGIC_TIM               TIM3
+#define LOGIC_TIM_EN            RCC_APB1ENR_TIM3EN
+#define LOGIC_DMA               DMA1_Channel3
+#define LOGIC_DMA_NUM           3
+#define LOGIC_DMA_IRQn          DMA1_Channel3_IRQn
+#define Logic_DMA_IRQHandler    DMA1_Channel3_IRQHandler
+#else
+#error "LOGIC_TIMER must be 2 or 3"
+#endif
+
+/* TIM 寄存器位定义 */
+#define TIM_CR1_CEN_BIT     0          /* 计数器使能 (位带访问) */
+#define TIM_DIER_UDE_BIT    8          /* 更新 DMA 请求使能 (位带访问) */
+
+/* DMA 寄存器位定义 */
+#define DMA_CCR_EN          (1 << 0)   /* 通道使能 */
+#define DMA_CCR_TCIE        (1 << 1)   /* 传输完成中断 */
+#define DMA_CCR_HTIE        (1 << 2)   /* 传输过半中断 */
+#define DMA_CCR_TEIE        (1 << 3)   /* 传输错误中断 */
+#define DMA_CCR_CIRC        (1 << 5)   /* 循环模式 */
+#define DMA_CCR_MINC        (1 << 7)   /* 存储器地址递增 */
+#define DMA_CCR_PSIZE_16    (1 << 8)   /* 外设 16 位 */
+#define DMA_CCR_MSIZE_16    (1 << 10)  /* 存储器 16 位 */
+#define DMA_CCR_PL_VHIGH    (3 << 12)  /* 通道优先级: 最高 */
+
+/* DMA_ISR / DMA_IFCR 中本通道的标志 */
+#define LOGIC_DMA_FLAGS     (0xFUL << ((LOGIC_DMA_NUM - 1) * 4))
+#define LOGIC_DMA_TCIF      (0x2UL << ((LOGIC_DMA_NUM - 1) * 4))
+#define LOGIC_DMA_HTIF      (0x4UL << ((LOGIC_DMA_NUM - 1) * 4))
+#define LOGIC_DMA_TEIF      (0x8UL << ((LOGIC_DMA_NUM - 1) * 4))
+
+/* 采样缓冲区: DMA 循环写入 */
+static uint16_t logic_buf[LOGIC_SAMPLES];
+
+static Logic_Capture_t logic_cap;
+static volatile Logic_State_t logic_state = LOGIC_IDLE;
+
+/* 以下变量只在 DMA 中断和触发回调中修改 (两者优先级相同) */
+static volatile uint32_t logic_wraps;   /* DMA 绕回缓冲区的次数 */
+static uint32_t logic_trig_abs;         /* 触发时已写入的样本数 */
+static uint16_t logic_pre;
+static uint16_t logic_post;
+static uint16_t logic_start;            /* 结果第 0 个样本在缓冲区中的位置 */
+
+/* 触发引脚 (NULL = 仅软件触发) */
+static GPIO_TypeDef *logic_trig_port;
+static uint16_t logic_trig_pin;
+static EXTI_Edge_t logic_trig_edge;
+
+/* 私有函数声明 */
+static uint32_t Logic_Written(void);
+static void Logic_Mark(void);
+static void Logic_OnEdge(uint16_t GPIO_Pin);
+static void Logic_Stop(void);
+static uint32_t Logic_FindEdge(uint32_t trig, uint32_t first);
+
+/**
+  * @brief  初始化逻辑分析仪
+  * @param  GPIOx: 被采集的端口 (一次采集整个 IDR 的 16 位)
+  * @param  mask: 导出到 VCD 的通道 (GPIO_PIN_x 位掩码)
+  * @param  rate: 采样率 (Hz), 最高为定时器时钟 / LOGIC_MIN_DIV
+  * @note   不改变引脚配置: 输入引脚和本芯片正在驱动的输出引脚都可以采集
+  * @note   端口时钟由调用者使能
+  * @retval 实际采样率 (Hz), 0 = 采样率无效
+  *
+  * 示例: Logic_Init(GPIOB, GPIO_PIN_6 | GPIO_PIN_7, 1000000); // 1MHz 采集 I2C1
+  */
+uint32_t Logic_Init(GPIO_TypeDef *GPIOx, uint16_t mask, uint32_t rate)
+{
+    uint32_t actual;
+
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    RCC->APB1ENR |= LOGIC_TIM_EN;
+
+    Logic_Abort();
+
+    if(rate == 0 || rate > PWM_GetTimerClock(LOGIC_TIM) / LOGIC_MIN_DIV)
+        return 0;
+
+    /* 定时器只产生更新事件, 不输出 PWM */
+    LOGIC_TIM->CR1 = 0;
+    LOGIC_TIM->DIER = 0;
+    actual = PWM_SetTimebase(LOGIC_TIM, rate);
+    LOGIC_TIM->SR = 0;
+
+    logic_cap.port = GPIOx;
+    logic_cap.mask = mask;
+    logic_cap.rate = actual;
+    logic_cap.count = 0;
+    logic_cap.trigger = 0;
+    logic_cap.written = 0;
+
+    /* 与 EXTI 同优先级, 触发回调和 DMA 中断互不抢占 */
+    NVIC_SetPriority(LOGIC_DMA_IRQn, EXTI_IRQ_PRIORITY);
+    NVIC_EnableIRQ(LOGIC_DMA_IRQn);
+
+    return actual;
+}
+
+/**
+  * @brief  开始采样并等待触发
+  * @param  pre: 保留的触发前样本数
+  * @param  post: 触发后的样本数
+  * @param  trig_port: 触发引脚端口, NULL = 只用 Logic_Trigger() 软件触发
+  * @param  trig_pin: 触发引脚 (单个 GPIO_PIN_x, 须已配置为输入)
+  * @param  edge: 触发边沿
+  * @note   启动后很快触发时, 触发前样本可能少于 pre
+  * @retval SUCCESS = 已启动, ERROR = 未初始化/正在采集/参数无效/EXTI 线被占用
+  *
+  * 示例: Logic_Arm(256, 1792, GPIOB, GPIO_PIN_6, EXTI_EDGE_FALLING);
+  */
+ErrorStatus Logic_Arm(uint16_t pre, uint16_t post,
+                      GPIO_TypeDef *trig_port, uint16_t trig_pin, EXTI_Edge_t edge)
+{
+    if(logic_cap.rate == 0 || logic_state == LOGIC_ARMED || logic_state == LOGIC_TRIGGERED)
+        return ERROR;
+
+    /* 停止检查在半满/全满中断中进行, 最多滞后半个缓冲区 */
+    if((uint32_t)pre + post > LOGIC_SAMPLES / 2)
+        return ERROR;
+
+    logic_pre = pre;
+    logic_post = post;
+    logic_wraps = 0;
+    logic_trig_port = trig_port;
+    logic_trig_pin = trig_pin;
+    logic_trig_edge = edge;
+
+    /* DMA: GPIOx->IDR (16 位) -> 缓冲区, 循环模式 */
+    LOGIC_DMA->CCR = 0;
+    DMA1->IFCR = LOGIC_DMA_FLAGS;
+    LOGIC_DMA->CPAR = (uint32_t)&logic_cap.port->IDR;
+    LOGIC_DMA->CMAR = (uint32_t)logic_buf;
+    LOGIC_DMA->CNDTR = LOGIC_SAMPLES;
+    LOGIC_DMA->CCR = DMA_CCR_MSIZE_16 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC | DMA_CCR_CIRC |
+                     DMA_CCR_PL_VHIGH | DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE;
+    LOGIC_DMA->CCR |= DMA_CCR_EN;
+
+    logic_state = LOGIC_ARMED;
+
+    /* 启动定时器: 每个更新事件采集一个样本 */
+    LOGIC_TIM->CNT = 0;
+    BITBAND_PERI(LOGIC_TIM->DIER, TIM_DIER_UDE_BIT) = 1;
+    BITBAND_PERI(LOGIC_TIM->CR1, TIM_CR1_CEN_BIT) = 1;
+
+    if(trig_port != NULL && EXTI_Attach(trig_port, trig_pin, edge, Logic_OnEdge) != SUCCESS)
+    {
+        /* 线属于其他驱动 (如按键) 或引脚无效: 不能让 Logic_Abort() 释放它 */
+        logic_trig_port = NULL;
+        Logic_Abort();
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/**
+  * @brief  软件触发
+  * @note   未处于等待触发状态时无效
+  * @retval None
+  */
+void Logic_Trigger(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    Logic_Mark();
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  停止采集并丢弃数据
+  * @retval None
+  */
+void Logic_Abort(void)
+{
+    BITBAND_PERI(LOGIC_TIM->CR1, TIM_CR1_CEN_BIT) = 0;
+    BITBAND_PERI(LOGIC_TIM->DIER, TIM_DIER_UDE_BIT) = 0;
+    LOGIC_DMA->CCR = 0;
+    DMA1->IFCR = LOGIC_DMA_FLAGS;
+
+    if(logic_trig_port != NULL)
+    {
+        EXTI_Detach(logic_trig_pin);
+        logic_trig_port = NULL;
+    }
+
+    logic_state = LOGIC_IDLE;
+}
+
+/**
+  * @brief  获取采集状态
+  * @retval 状态
+  */
+Logic_State_t Logic_GetState(void)
+{
+    return logic_state;
+}
+
+/**
+  * @brief  获取采集结果 (LOGIC_DONE 后有效)
+  * @retval 结果描述
+  */
+const Logic_Capture_t *Logic_GetCapture(void)
+{
+    return &logic_cap;
+}
+
+/**
+  * @brief  读取一个样本 (LOGIC_DONE 后有效)
+  * @param  index: 样本序号 (0 ~ count - 1), 触发样本为 logic_cap.trigger
+  * @retval 端口 16 位输入值
+  */
+uint16_t Logic_GetSample(uint16_t index)
+{
+    uint32_t pos = (uint32_t)logic_start + index;
+
+    if(pos >= LOGIC_SAMPLES)
+        pos -= LOGIC_SAMPLES;
+
+    return logic_buf[pos];
+}
+
+/**
+  * @brief  通过 UART 输出 VCD 文件 (LOGIC_DONE 后有效)
+  * @param  USARTx: 输出串口
+  * @note   每个 mask 通道一个 1 位信号, 另加 TRIG 信号在触发样本处变为 1;
+  *         只输出有变化的时间点, 最后以 "$comment end $end" 结束
+  * @retval None
+  */
+void Logic_ExportVCD(USART_TypeDef *USARTx)
+{
+    const char *unit;
+    uint32_t scale;
+    uint32_t changed;
+    uint16_t sample, prev = 0;
+    uint16_t i;
+    uint8_t bit;
+    char port;
+
+    if(logic_state != LOGIC_DONE)
+        return;
+
+    /* 选择时间单位, 使每个样本至少 1 个单位 */
+    if(logic_cap.rate >= 1000000)
+    {
+        unit = "1 ns";
+        scale = 1000000000;
+    }
+    else if(logic_cap.rate >= 1000)
+    {
+        unit = "1 us";
+        scale = 1000000;
+    }
+    else
+    {
+        unit = "1 ms";
+        scale = 1000;
+    }
+
+    port = 'A' + ((uint32_t)logic_cap.port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE);
+
+    UART_SendString(USARTx, "$version STM32F103 logic capture $end\r\n");
+    UART_Printf(USARTx, "$comment rate %lu Hz, %u samples, trigger at sample %u $end\r\n",
+                logic_cap.rate, logic_cap.count, logic_cap.trigger);
+    UART_Printf(USARTx, "$timescale %s $end\r\n", unit);
+    UART_Printf(USARTx, "$scope module GPIO%c $end\r\n", port);
+
+    /* 信号标识符: 通道 n 用字符 '!' + n, TRIG 用 '~' */
+    for(bit = 0; bit < 16; bit++)
+    {
+        if(logic_cap.mask & (1 << bit))
+            UART_Printf(USARTx, "$var wire 1 %c P%c%u $end\r\n", '!' + bit, port, bit);
+    }
+    UART_SendString(USARTx, "$var wire 1 ~ TRIG $end\r\n");
+    UART_SendString(USARTx, "$upscope $end\r\n$enddefinitions $end\r\n");
+
+    for(i = 0; i < logic_cap.count; i++)
+    {
+        sample = Logic_GetSample(i);
+        changed = (i == 0) ? logic_cap.mask : (sample ^ prev) & logic_cap.mask;
+        prev = sample;
+
+        if(changed == 0 && i != 0 && i != logic_cap.trigger)
+            continue;
+
+        UART_Printf(USARTx, "#%lu\r\n", (uint32_t)((uint64_t)i * scale / logic_cap.rate));
+
+        while(changed)
+        {
+            bit = (uint8_t)__builtin_ctz(changed);
+            changed &= changed - 1;
+            UART_Printf(USARTx, "%c%c\r\n", (sample & (1 << bit)) ? '1' : '0', '!' + bit);
+        }
+
+        if(i == 0)
+            UART_Printf(USARTx, "%c~\r\n", logic_cap.trigger == 0 ? '1' : '0');
+        else if(i == logic_cap.trigger)
+            UART_SendString(USARTx, "1~\r\n");
+    }
+
+    /* 结束时间点, 让波形显示到最后一个样本 */
+    UART_Printf(USARTx, "#%lu\r\n", (uint32_t)((uint64_t)logic_cap.count * scale / logic_cap.rate));
+    UART_SendString(USARTx, "$comment end $end\r\n");
+}
+
+/**
+  * @brief  DMA 当前已写入的样本总数
+  * @note   在 DMA 中断、触发回调或关中断时调用
+  * @retval 样本数
+  */
+static uint32_t Logic_Written(void)
+{
+    uint32_t pos = LOGIC_SAMPLES - LOGIC_DMA->CNDTR;
+    uint32_t wraps = logic_wraps;
+
+    /* 已绕回但全满中断还未处理 (读 CNDTR 之后才绕回时 pos 接近末尾, 不重复计数) */
+    if((DMA1->ISR & LOGIC_DMA_TCIF) && pos < LOGIC_SAMPLES / 2)
+        wraps++;
+
+    return wraps * LOGIC_SAMPLES + pos;
+}
+
+/**
+  * @brief  记录触发位置
+  * @retval None
+  */
+static void Logic_Mark(void)
+{
+    if(logic_state != LOGIC_ARMED)
+        return;
+
+    logic_trig_abs = Logic_Written();
+    logic_state = LOGIC_TRIGGERED;
+
+    if(logic_trig_port != NULL)
+        EXTI_Disable(logic_trig_pin);
+}
+
+/**
+  * @brief  触发引脚边沿回调 (EXTI 中断中调用)
+  * @param  GPIO_Pin: 触发的引脚
+  * @retval None
+  */
+static void Logic_OnEdge(uint16_t GPIO_Pin)
+{
+    (void)GPIO_Pin;
+
+    Logic_Mark();
+}
+
+/**
+  * @brief  停止采样并计算结果窗口 (DMA 中断中调用)
+  * @retval None
+  */
+static void Logic_Stop(void)
+{
+    uint32_t end, first, start, stop, trig;
+
+    /* 先停请求再关 DMA, 之后 CNDTR 不再变化 */
+    BITBAND_PERI(LOGIC_TIM->CR1, TIM_CR1_CEN_BIT) = 0;
+    BITBAND_PERI(LOGIC_TIM->DIER, TIM_DIER_UDE_BIT) = 0;
+    LOGIC_DMA->CCR &= ~DMA_CCR_EN;
+
+    end = Logic_Written();
+    first = (end > LOGIC_SAMPLES) ? end - LOGIC_SAMPLES : 0;
+
+    trig = logic_trig_abs;
+    if(logic_trig_port == logic_cap.port)
+        trig = Logic_FindEdge(trig, first);
+
+    /* 中断被长时间阻塞时触发样本可能已被覆盖, 此时从最早的样本开始 */
+    if(trig < first)
+        trig = first;
+
+    start = (trig > first + logic_pre) ? trig - logic_pre : first;
+    stop = trig + logic_post;
+    if(stop > end)
+        stop = end;
+
+    logic_start = (uint16_t)(start % LOGIC_SAMPLES);
+    logic_cap.count = (uint16_t)(stop - start);
+    logic_cap.trigger = (uint16_t)(trig - start);
+    logic_cap.written = end;
+
+    if(logic_trig_port != NULL)
+    {
+        EXTI_Detach(logic_trig_pin);
+        logic_trig_port = NULL;
+    }
+
+    logic_state = LOGIC_DONE;
+}
+
+/**
+  * @brief  在触发位置之前查找触发引脚的真实边沿
+  * @param  trig: 中断中记录的触发位置 (绝对样本序号)
+  * @param  first: 缓冲区中最早的有效样本
+  * @note   EXTI 中断延迟使记录位置晚于边沿, 采样率高时相差若干样本
+  * @retval 边沿后第一个样本的绝对序号, 找不到时返回 trig
+  */
+static uint32_t Logic_FindEdge(uint32_t trig, uint32_t first)
+{
+    uint16_t pin = logic_trig_pin;
+    uint32_t k;
+    uint16_t now, before;
+
+    for(k = trig; k > first + 1 && trig - k < LOGIC_TRIG_SEARCH; k--)
+    {
+        now = logic_buf[(k - 1) % LOGIC_SAMPLES] & pin;
+        before = logic_buf[(k - 2) % LOGIC_SAMPLES] & pin;
+
+        if(now == before)
+            continue;
+
+        if(logic_trig_edge == EXTI_EDGE_BOTH ||
+           (logic_trig_edge == EXTI_EDGE_RISING && now != 0) ||
+           (logic_trig_edge == EXTI_EDGE_FALLING && now == 0))
+            return k - 1;
+    }
+
+    return trig;
+}
+
+/**
+  * @brief  采样 DMA 中断: 统计绕回次数, 触发后样本够了就停止
+  * @retval None
+  */
+void Logic_DMA_IRQHandler(void)
+{
+    uint32_t isr = DMA1->ISR;
+
+    if(isr & LOGIC_DMA_TEIF)
+    {
+        /* 传输错误时硬件已关闭通道 */
+        DMA1->IFCR = LOGIC_DMA_FLAGS;
+        Logic_Abort();
+        return;
+    }
+
+    /* 只清除已读到的标志, 不会漏掉新的绕回 */
+    DMA1->IFCR = isr & (LOGIC_DMA_TCIF | LOGIC_DMA_HTIF);
+    if(isr & LOGIC_DMA_TCIF)
+        logic_wraps++;
+
+    if(logic_state == LOGIC_TRIGGERED && Logic_Written() >= logic_trig_abs + logic_post)
+        Logic_Stop();
+}
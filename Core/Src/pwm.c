@@ -7,7 +7,43 @@
 
 #include "pwm.h"
 #include "gpio.h"
+#include "bitband.h"
 #include "system_stm32f1xx.h"
+#include "profile.h"
+#include "clock.h"
+#include <stddef.h>
+
+/* TIMx 寄存器位 */
+#define TIM_CR1_CEN_BIT     0   /* 计数器使能 */
+#define TIM_CR1_ARPE_BIT    7   /* 自动重装载预装载 */
+#define TIM_EGR_UG          (1 << 0)   /* 软件更新事件 (装载 PSC/ARR) */
+
+/* PWM_Init 的计数频率 */
+#define PWM_COUNT_RATE      1000000
+
+/* CCER 中通道 n 的 CCxE 位 (每通道 4 位) */
+#define TIM_CCER_CCE_BIT(n) ((n) * 4)
+
+/* 复用推挽输出引脚 (编译期计算的 CRL 掩码) */
+#define PWM_AF_CFG(pins)    GPIO_CR_VALUE(pins, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP)
+
+static const GPIO_PortConfig_t motor_pins_a =
+    GPIO_PORT_CONFIG(GPIOA, GPIO_CR_MASK(GPIO_PIN_6 | GPIO_PIN_7), PWM_AF_CFG(GPIO_PIN_6 | GPIO_PIN_7));
+static const GPIO_PortConfig_t motor_pins_b =
+    GPIO_PORT_CONFIG(GPIOB, GPIO_CR_MASK(GPIO_PIN_0 | GPIO_PIN_1), PWM_AF_CFG(GPIO_PIN_0 | GPIO_PIN_1));
+static const GPIO_PortConfig_t servo_pins =
+    GPIO_PORT_CONFIG(GPIOA, GPIO_CR_MASK(GPIO_PIN_0 | GPIO_PIN_1), PWM_AF_CFG(GPIO_PIN_0 | GPIO_PIN_1));
+
+/* 各定时器 (TIM1-TIM4) 最近的设置, 时钟切换后据此重新计算 PSC/ARR, 0 = 未设置 */
+static TIM_TypeDef * const pwm_timers[4] = { TIM1, TIM2, TIM3, TIM4 };
+static uint32_t pwm_count_rate[4];      /* PWM_SetCountRate */
+static uint32_t pwm_timebase[4];        /* PWM_SetTimebase */
+static Clock_Notifier_t pwm_clock_notifier;
+
+/* 私有函数声明 */
+static uint8_t PWM_Index(TIM_TypeDef *TIMx);
+static void PWM_Remember(TIM_TypeDef *TIMx, uint32_t count_rate, uint32_t timebase);
+static void PWM_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg);
 
 /**
   * @brief  初始化 PWM
@@ -19,27 +55,14 @@
   */
 void PWM_Init(TIM_TypeDef *TIMx, uint32_t frequency)
 {
-    uint32_t timer_clock;
-    uint16_t prescaler;
-    uint16_t period;
-    
-    /* 获取定时器时钟 */
-    if(TIMx == TIM2 || TIMx == TIM3 || TIMx == TIM4)
-    {
-        timer_clock = SystemCoreClock / 2;  /* APB1 = 36MHz */
-    }
-    else
-    {
-        timer_clock = SystemCoreClock;      /* APB2 = 72MHz */
-    }
+    uint32_t count_rate;
     
-    /* 计算预分频器和周期值 */
-    prescaler = 72 - 1;  /* 72MHz / 72 = 1MHz */
-    period = (timer_clock / (prescaler + 1) / frequency) - 1;
+    /* 1MHz 计数, ARR = 1MHz / 频率 - 1 (TIM2-TIM4 的时钟是 2 x PCLK1) */
+    count_rate = PWM_SetCountRate(TIMx, PWM_COUNT_RATE);
+    if(count_rate == 0 || frequency == 0)
+        return;
     
-    /* 配置定时器 */
-    TIMx->PSC = prescaler;
-    TIMx->ARR = period;
+    TIMx->ARR = count_rate / frequency - 1;
     
     /* PWM 模式 1 配置 */
     /* 通道 1 */
@@ -63,10 +86,10 @@ void PWM_Init(TIM_TypeDef *TIMx, uint32_t frequency)
     TIMx->CCMR2 |= (0x1 << 11);  /* 预装载使能 */
     
     /* 自动重装载预装载使能 */
-    TIMx->CR1 |= (0x1 << 7);
+    BITBAND_PERI(TIMx->CR1, TIM_CR1_ARPE_BIT) = 1;
     
     /* 启用定时器 */
-    TIMx->CR1 |= (0x1 << 0);
+    BITBAND_PERI(TIMx->CR1, TIM_CR1_CEN_BIT) = 1;
 }
 
 /**
@@ -79,6 +102,7 @@ void PWM_Init(TIM_TypeDef *TIMx, uint32_t frequency)
 void PWM_SetDutyCycle(TIM_TypeDef *TIMx, PWM_Channel_t channel, float duty_cycle)
 {
     uint16_t pulse;
+    PROFILE_SCOPE(PROFILE_ZONE_PWM_DUTY);
     
     /* 限制占空比范围 */
     if(duty_cycle > 100.0f) duty_cycle = 100.0f;
@@ -113,21 +137,11 @@ void PWM_SetDutyCycle(TIM_TypeDef *TIMx, PWM_Channel_t channel, float duty_cycle
   */
 void PWM_Start(TIM_TypeDef *TIMx, PWM_Channel_t channel)
 {
-    switch(channel)
-    {
-        case PWM_CHANNEL_1:
-            TIMx->CCER |= (0x1 << 0);  /* CC1E */
-            break;
-        case PWM_CHANNEL_2:
-            TIMx->CCER |= (0x1 << 4);  /* CC2E */
-            break;
-        case PWM_CHANNEL_3:
-            TIMx->CCER |= (0x1 << 8);  /* CC3E */
-            break;
-        case PWM_CHANNEL_4:
-            TIMx->CCER |= (0x1 << 12); /* CC4E */
-            break;
-    }
+    if(channel > PWM_CHANNEL_4)
+        return;
+    
+    /* 位带写入 CCxE: 单次总线操作, 不会与中断中的 CCER 修改冲突 */
+    BITBAND_PERI(TIMx->CCER, TIM_CCER_CCE_BIT(channel)) = 1;
 }
 
 /**
@@ -138,21 +152,87 @@ void PWM_Start(TIM_TypeDef *TIMx, PWM_Channel_t channel)
   */
 void PWM_Stop(TIM_TypeDef *TIMx, PWM_Channel_t channel)
 {
-    switch(channel)
-    {
-        case PWM_CHANNEL_1:
-            TIMx->CCER &= ~(0x1 << 0);
-            break;
-        case PWM_CHANNEL_2:
-            TIMx->CCER &= ~(0x1 << 4);
-            break;
-        case PWM_CHANNEL_3:
-            TIMx->CCER &= ~(0x1 << 8);
-            break;
-        case PWM_CHANNEL_4:
-            TIMx->CCER &= ~(0x1 << 12);
-            break;
-    }
+    if(channel > PWM_CHANNEL_4)
+        return;
+    
+    BITBAND_PERI(TIMx->CCER, TIM_CCER_CCE_BIT(channel)) = 0;
+}
+
+/**
+  * @brief  获取定时器的输入时钟
+  * @param  TIMx: 定时器 (TIM1 在 APB2, TIM2-TIM4 在 APB1)
+  * @note   APB 预分频不为 1 时, 定时器时钟是 APB 时钟的 2 倍
+  * @retval 定时器时钟 (Hz)
+  */
+uint32_t PWM_GetTimerClock(TIM_TypeDef *TIMx)
+{
+    Clock_Freq_t freq;
+    
+    Clock_GetFreq(&freq);
+    
+    return (TIMx == TIM1) ? freq.tim_apb2 : freq.tim_apb1;
+}
+
+/**
+  * @brief  设置定时器计数频率 (只改 PSC, ARR 不变)
+  * @param  TIMx: 定时器
+  * @param  rate: 计数频率 (Hz), 如 1000000 = 每 1us 计数一次
+  * @note   新 PSC 在下一次更新事件生效, 输出不会出现毛刺;
+  *         Clock_SetSysclk() 后自动按新时钟重新计算
+  * @retval 实际计数频率 (Hz), 0 = 频率为 0 或高于定时器时钟
+  *
+  * 示例: PWM_SetCountRate(TIM4, 1000000); // ARR = 周期 (us) - 1
+  */
+uint32_t PWM_SetCountRate(TIM_TypeDef *TIMx, uint32_t rate)
+{
+    uint32_t timer_clock = PWM_GetTimerClock(TIMx);
+    uint32_t prescaler;
+    
+    if(rate == 0 || rate > timer_clock)
+        return 0;
+    
+    prescaler = timer_clock / rate - 1;
+    if(prescaler > 0xFFFF)
+        prescaler = 0xFFFF;
+    
+    TIMx->PSC = prescaler;
+    PWM_Remember(TIMx, rate, 0);
+    
+    return timer_clock / (prescaler + 1);
+}
+
+/**
+  * @brief  按频率设置定时器更新周期 (PSC/ARR)
+  * @param  TIMx: 定时器
+  * @param  frequency: 更新事件频率 (Hz)
+  * @note   取尽量小的预分频, 使 ARR 分辨率最高; 计数器不会被启动;
+  *         Clock_SetSysclk() 后自动按新时钟重新计算
+  * @retval 实际频率 (Hz), 0 = 频率为 0 或过高
+  *
+  * 示例: PWM_SetTimebase(TIM2, 1000000); // 每 1us 一次更新事件
+  */
+uint32_t PWM_SetTimebase(TIM_TypeDef *TIMx, uint32_t frequency)
+{
+    uint32_t timer_clock = PWM_GetTimerClock(TIMx);
+    uint32_t ticks;
+    uint32_t prescaler;
+    uint32_t period;
+    
+    /* ARR = 0 时计数器停止, 最高为定时器时钟的一半 */
+    if(frequency == 0 || frequency > timer_clock / 2)
+        return 0;
+    
+    /* 每个更新周期的定时器时钟数, 拆成 (PSC + 1) * (ARR + 1) */
+    ticks = timer_clock / frequency;
+    prescaler = (ticks - 1) / 65536;
+    period = ticks / (prescaler + 1);
+    
+    TIMx->PSC = prescaler;
+    TIMx->ARR = period - 1;
+    TIMx->EGR = TIM_EGR_UG;
+    PWM_Remember(TIMx, 0, frequency);
+    
+    return timer_clock / ((prescaler + 1) * period);
 }
 
 /**
@@ -169,12 +249,10 @@ void Motor_Init(void)
     RCC->APB2ENR |= (0x1 << 3);  /* GPIOB */
     
     /* 配置 GPIO - PA6, PA7 (TIM3_CH1, TIM3_CH2) */
-    GPIO_Init(GPIOA, GPIO_PIN_6, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
-    GPIO_Init(GPIOA, GPIO_PIN_7, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_InitPort(&motor_pins_a);
     
     /* 配置 GPIO - PB0, PB1 (TIM3_CH3, TIM3_CH4) */
-    GPIO_Init(GPIOB, GPIO_PIN_0, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
-    GPIO_Init(GPIOB, GPIO_PIN_1, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_InitPort(&motor_pins_b);
     
     /* 初始化 PWM - 1kHz */
     PWM_Init(TIM3, 1000);
@@ -271,8 +349,7 @@ void Servo_Init(void)
     RCC->APB2ENR |= (0x1 << 2);  /* GPIOA */
     
     /* 配置 GPIO */
-    GPIO_Init(GPIOA, GPIO_PIN_0, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
-    GPIO_Init(GPIOA, GPIO_PIN_1, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_InitPort(&servo_pins);
     
     /* 初始化 PWM - 50Hz (舵机标准频率) */
     PWM_Init(TIM2, 50);
@@ -319,3 +396,66 @@ void Servo_SetAngle(uint8_t servo_id, uint16_t angle)
     }
 }
 
+/**
+  * @brief  定时器在状态数组中的下标
+  * @param  TIMx: 定时器
+  * @retval 0-3, 其他定时器返回 0xFF
+  */
+static uint8_t PWM_Index(TIM_TypeDef *TIMx)
+{
+    uint8_t i;
+    
+    for(i = 0; i < 4; i++)
+    {
+        if(pwm_timers[i] == TIMx)
+            return i;
+    }
+    
+    return 0xFF;
+}
+
+/**
+  * @brief  记录定时器的设置, 首次调用时注册时钟切换通知
+  * @param  TIMx: 定时器
+  * @param  count_rate: 计数频率 (Hz), 0 = 不是按计数频率设置
+  * @param  timebase: 更新事件频率 (Hz), 0 = 不是按更新频率设置
+  * @retval None
+  */
+static void PWM_Remember(TIM_TypeDef *TIMx, uint32_t count_rate, uint32_t timebase)
+{
+    uint8_t i = PWM_Index(TIMx);
+    
+    if(i == 0xFF)
+        return;
+    
+    pwm_count_rate[i] = count_rate;
+    pwm_timebase[i] = timebase;
+    
+    if(pwm_clock_notifier.callback == NULL)
+        Clock_Register(&pwm_clock_notifier, PWM_ClockChanged, NULL);
+}
+
+/**
+  * @brief  时钟切换后按新的定时器时钟重新计算 PSC (及 ARR)
+  * @param  event: CLOCK_EVENT_PRE 或 CLOCK_EVENT_POST
+  * @param  freq: 时钟树
+  * @param  arg: 未使用
+  * @note   按计数频率设置的定时器 ARR 不变, 周期与占空比保持;
+  *         按更新频率设置的定时器会重新装载, 计数器清零
+  * @retval None
+  */
+static void PWM_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg)
+{
+    uint8_t i;
+    
+    if(event != CLOCK_EVENT_POST)
+        return;
+    
+    for(i = 0; i < 4; i++)
+    {
+        if(pwm_count_rate[i] != 0)
+            PWM_SetCountRate(pwm_timers[i], pwm_count_rate[i]);
+        else if(pwm_timebase[i] != 0)
+            PWM_SetTimebase(pwm_timers[i], pwm_timebase[i]);
+    }
+}
@@ -42,9 +42,6 @@ int main(void)
     float voltage[4];
     float temperature;
     
-    /* 系统初始化 */
-    SystemInit();
-    
     /* 使能时钟 */
     RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
     RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file    button_events.c
+  * @brief   EXTI 按键事件示例程序
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- 两个按键通过 EXTI 双边沿中断检测, TIM1 定时消抖 (20ms)
+- 按下/释放/长按 (1s) 事件进入队列, 主循环取出后通过 UART 输出
+- 按键1 短按翻转 LED, 长按点亮 LED; 按键2 输出按键1 的当前状态
+- 没有按键动作时不产生任何中断, TIM1 处于停止状态
+
+硬件连接：
+按键:
+  - PA0: 按键1, 另一端接 GND (内部上拉)
+  - PB1: 按键2, 另一端接 GND (内部上拉)
+
+LED:
+  - PC13: 板载 LED (低电平点亮)
+
+UART:
+  - PA9-10: TX/RX
+
+定时器:
+  - TIM1: 按键消抖
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+#include "exti.h"
+
+int main(void)
+{
+    static const char *const event_name[3] = { "press", "release", "long press" };
+    Button_Event_t ev;
+    uint32_t dropped = 0;
+    int8_t key1, key2;
+
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_IOPCEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+    /* 配置 UART 和 LED */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+    GPIO_Init(GPIOC, GPIO_PIN_13, GPIO_MODE_OUTPUT_2MHZ, GPIO_CNF_OUTPUT_PP);
+    GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+
+    /* 添加按键 (按键接地, 内部上拉) */
+    key1 = Button_Add(GPIOA, GPIO_PIN_0, 1);
+    key2 = Button_Add(GPIOB, GPIO_PIN_1, 1);
+
+    UART_SendString(USART1, "\r\nEXTI button events\r\n");
+
+    while(1)
+    {
+        while(Button_GetEvent(&ev))
+        {
+            UART_Printf(USART1, "key%d %s\r\n", ev.id + 1, event_name[ev.type]);
+
+            if(ev.id == key1 && ev.type == BUTTON_PRESS)
+            {
+                GPIO_PIN_OUT(GPIOC, 13) ^= 1;
+            }
+            else if(ev.id == key1 && ev.type == BUTTON_LONG_PRESS)
+            {
+                GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_RESET);
+            }
+            else if(ev.id == key2 && ev.type == BUTTON_PRESS)
+            {
+                UART_Printf(USART1, "key1 is %s\r\n", Button_IsPressed(key1) ? "down" : "up");
+            }
+        }
+
+        /* 主循环太慢时队列溢出 */
+        if(Button_Dropped() != dropped)
+        {
+            dropped = Button_Dropped();
+            UART_Printf(USART1, "%lu events dropped\r\n", dropped);
+        }
+    }
+}
@@ -14,7 +14,16 @@
 - ADC 采集（电位器控制）
 - PWM 电机控制
 - UART 调试输出
-- 多任务协同工作
+- 多任务协同工作: ADC、电机、LCD、UART 为四个独立任务, 由 sched.h 协作式调度器按优先级运行
+  (ADC 10Hz 采集后把结果投递给电机任务, LCD 5Hz, UART 1Hz 输出状态和各任务执行时间统计)
+- 函数计时: 串口发送 'p' 输出 UART_Printf/ADC_Read/LCD1602_Printf/PWM_SetDutyCycle 的周期数统计
+  (config.h 中 PROFILE_ENABLE 为 0 时不输出)
+- 运行监控: 每秒输出 CPU 负载, 串口发送 'm' 输出 SysTick 中断延迟/抖动直方图和主循环最长执行时间
+- 内存统计: 串口发送 's' 输出主栈最大用量和堆用量
+- 快速启动: LCD 上电等待和初始化由 lcdini 任务分步完成, 不阻塞其他外设和控制任务;
+  欢迎信息在 UART 任务第一次运行时输出, 串口发送 'b' 输出启动检查点 (复位到首次调度的时间)
+- 故障记录: HardFault 等故障记录寄存器和调用栈后复位, 下次启动时输出一次, 串口发送 'f' 再次输出
+  (主机端 tools/fault_decode.py 解析为函数名和行号)
 
 硬件连接：
 LCD1602:
@@ -30,6 +39,10 @@ ADC:
 UART:
   - PA9-10: TX/RX
 
+定时器:
+  - SysTick: 1ms 节拍, 驱动软件定时器和任务周期
+  - TIM4: LCD 后台刷新
+
 应用场景：
 通过电位器调节电机速度，LCD 显示速度值，UART 输出调试信息
 */
@@ -39,9 +52,16 @@ UART:
 #include "gpio.h"
 #include "uart.h"
 #include "delay.h"
+#include "sched.h"
+#include "profile.h"
+#include "monitor.h"
+#include "memstat.h"
+#include "boot.h"
+#include "fault.h"
 #include "adc.h"
 #include "pwm.h"
 #include "lcd1602.h"
+#include <stddef.h>
 
 /* 自定义字符：速度表图标 */
 uint8_t speed_icon[] = {
@@ -49,15 +69,240 @@ uint8_t speed_icon[] = {
     0x11, 0x0E, 0x04, 0x00
 };
 
-int main(void)
+/* 任务优先级: 数字越小越优先 */
+#define PRIO_MOTOR      0
+#define PRIO_ADC        1
+#define PRIO_LCD        2
+#define PRIO_UART       3
+
+static Sched_Task_t motor_task;
+static Sched_Task_t adc_task;
+static Sched_Task_t lcd_task;
+static Sched_Task_t lcd_init_task;
+static Sched_Task_t uart_task;
+
+/* 任务间共享的状态 (只在主循环的任务中读写) */
+static uint16_t adc_value;
+static float voltage;
+static int16_t motor_speed;
+static uint16_t lcd_saved;
+static uint8_t lcd_ready;
+
+/**
+  * @brief  ADC 任务 (10Hz): 采集电位器, 把结果投递给电机任务
+  * @param  event: 未使用
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_ADC(uint32_t event, void *arg)
+{
+    (void)event;
+    (void)arg;
+
+    adc_value = ADC_ReadAverage(ADC_CHANNEL_0, 5);
+    voltage = ADC_ReadVoltage(ADC_CHANNEL_0);
+
+    Sched_Post(&motor_task, adc_value);
+}
+
+/**
+  * @brief  电机任务: 根据 ADC 值设置速度 (最高优先级)
+  * @param  event: ADC 值
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_Motor(uint32_t event, void *arg)
 {
-    uint16_t adc_value;
-    int16_t motor_speed;
-    float voltage;
-    uint32_t update_counter = 0;
+    uint16_t value = (uint16_t)event;
+
+    (void)arg;
+
+    /* 计算电机速度 (-100 到 +100) */
+    /* ADC 0-2047: 反转, 2048-4095: 正转 */
+    if(value < 2048)
+    {
+        motor_speed = -(int16_t)((2048 - value) * 100 / 2048);
+    }
+    else
+    {
+        motor_speed = (int16_t)((value - 2048) * 100 / 2047);
+    }
     
-    /* 系统初始化 */
-    SystemInit();
+    /* 死区处理 (±5%) */
+    if(motor_speed > -5 && motor_speed < 5)
+    {
+        motor_speed = 0;
+    }
+    
+    Motor_SetSpeed(1, motor_speed);
+}
+
+/**
+  * @brief  LCD 初始化任务 (1kHz): 分步初始化, 完成后写入主界面并开始刷新
+  * @param  event: 未使用
+  * @param  arg: 未使用
+  * @note   上电等待期间其他任务照常运行
+  * @retval None
+  */
+static void Task_LCDInit(uint32_t event, void *arg)
+{
+    (void)event;
+    (void)arg;
+
+    /* 停止周期投递前已入队的事件也会运行 */
+    if(lcd_ready || LCD1602_InitStep() != 0)
+    {
+        return;
+    }
+    lcd_ready = 1;
+    Sched_StopPeriodic(&lcd_init_task);
+
+    /* LCD 主界面 (写入帧缓冲, 由 LCD 任务统一刷新) */
+    LCD1602_FB_Clear();
+    LCD1602_FB_Print(0, 0, "Speed:");
+    LCD1602_FB_PutChar(0, 15, LCD1602_Glyph(speed_icon));  /* 速度图标 */
+    LCD1602_FB_Print(1, 0, "ADC:     V:    ");
+    LCD1602_AsyncInit();
+
+    Sched_StartPeriodic(&lcd_task, 0, 200, 0);
+}
+
+/**
+  * @brief  LCD 任务 (5Hz): 更新帧缓冲, 由 TIM4 后台发送
+  * @param  event: 未使用
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_LCD(uint32_t event, void *arg)
+{
+    (void)event;
+    (void)arg;
+
+    /* 只有变化的字符才会发送到 LCD */
+    LCD1602_FB_Printf(0, 7, "%4d%%", motor_speed);
+    LCD1602_FB_Printf(1, 4, "%4u", adc_value);
+    LCD1602_FB_Printf(1, 11, "%.2f", voltage);
+    lcd_saved = LCD1602_FB_FlushAsync();  /* 只入队, 由 TIM4 后台发送 */
+}
+
+/**
+  * @brief  输出一个任务的统计 (周期数换算为微秒)
+  * @param  task: 任务
+  * @retval None
+  */
+static void Print_TaskStats(Sched_Task_t *task)
+{
+    Sched_Stats_t stats;
+    uint32_t avg = 0;
+
+    Sched_GetStats(task, &stats);
+    Sched_ResetStats(task);
+    if(stats.runs != 0)
+    {
+        avg = (uint32_t)(stats.exec_total / stats.runs);
+    }
+
+    UART_Printf(USART1, "│ %-5s P%u run %3lu avg %5luus max %5luus lat %5luus miss %lu drop %lu\r\n",
+                task->name, task->priority, stats.runs,
+                Delay_CyclesToUs(avg), Delay_CyclesToUs(stats.exec_max),
+                Delay_CyclesToUs(stats.latency_max), stats.deadline_misses, stats.dropped);
+}
+
+/**
+  * @brief  UART 任务 (1Hz): 输出状态和任务统计
+  * @param  event: 未使用
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_UART(uint32_t event, void *arg)
+{
+    static uint8_t welcome = 0;
+    Monitor_Stats_t monitor = {0};
+
+    (void)event;
+    (void)arg;
+
+    /* 欢迎信息 (约 50ms) 放到第一次运行, 不推迟启动 */
+    if(!welcome)
+    {
+        welcome = 1;
+        UART_SendString(USART1, "\r\n");
+        UART_SendString(USART1, "╔════════════════════════════════════════╗\r\n");
+        UART_SendString(USART1, "║   STM32F103 综合控制系统               ║\r\n");
+        UART_SendString(USART1, "╠════════════════════════════════════════╣\r\n");
+        UART_SendString(USART1, "║ 功能:                                  ║\r\n");
+        UART_SendString(USART1, "║  • LCD1602 实时显示                    ║\r\n");
+        UART_SendString(USART1, "║  • ADC 电位器采集                      ║\r\n");
+        UART_SendString(USART1, "║  • PWM 电机速度控制                    ║\r\n");
+        UART_SendString(USART1, "║  • UART 数据监控                       ║\r\n");
+        UART_SendString(USART1, "╚════════════════════════════════════════╝\r\n");
+        UART_SendString(USART1, "\r\n系统已启动！\r\n\r\n");
+        Boot_Print(USART1);
+        if(Fault_Pending())
+        {
+            Fault_Print(USART1);  /* 上次复位前的故障 */
+        }
+        return;
+    }
+
+    UART_SendString(USART1, "┌─────────────────────────────────────┐\r\n");
+    UART_Printf(USART1,     "│ ADC值: %-4u  电压: %.2fV         │\r\n", 
+                adc_value, voltage);
+    UART_Printf(USART1,     "│ 电机速度: %+4d%%                   │\r\n", 
+                motor_speed);
+    UART_Printf(USART1,     "│ LCD 刷新节省: %2u 字节             │\r\n", 
+                lcd_saved);
+    
+    if(motor_speed > 0)
+        UART_SendString(USART1, "│ 状态: 正转 →                       │\r\n");
+    else if(motor_speed < 0)
+        UART_SendString(USART1, "│ 状态: 反转 ←                       │\r\n");
+    else
+        UART_SendString(USART1, "│ 状态: 停止 ■                       │\r\n");
+    
+    Monitor_GetStats(&monitor);
+    UART_Printf(USART1,     "│ CPU 负载: %2u.%u%% (峰值 %2u.%u%%)      │\r\n",
+                monitor.load / 10, monitor.load % 10, monitor.load_peak / 10, monitor.load_peak % 10);
+    
+    /* 统计覆盖上一秒 (本任务自己的这次运行下一秒才计入) */
+    Print_TaskStats(&motor_task);
+    Print_TaskStats(&adc_task);
+    Print_TaskStats(&lcd_task);
+    Print_TaskStats(&uart_task);
+    
+    UART_SendString(USART1, "└─────────────────────────────────────┘\r\n");
+    
+    /* 串口命令: 'p' 输出函数计时, 'm' 输出中断延迟和主循环统计 (输出后清零), 's' 输出栈和堆用量,
+       'b' 输出启动检查点, 'f' 输出故障记录 */
+    if(USART1->SR & USART_SR_RXNE)
+    {
+        switch(USART1->DR)
+        {
+            case 'p':
+                Profile_Dump(USART1);
+                Profile_Reset();
+                break;
+            case 'm':
+                Monitor_Print(USART1);
+                Monitor_Reset();
+                break;
+            case 's':
+                MemStat_Print(USART1);
+                break;
+            case 'b':
+                Boot_Print(USART1);
+                break;
+            case 'f':
+                Fault_Print(USART1);
+                break;
+        }
+    }
+}
+
+int main(void)
+{
+    /* 使能 MemManage/BusFault/UsageFault, 故障记录见 fault.h */
+    Fault_Init();
     
     /* 使能时钟 */
     RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
@@ -67,98 +312,33 @@ int main(void)
     GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
     GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
     
-    /* 初始化所有外设 */
+    /* 初始化所有外设; LCD 只配置引脚, 上电等待与其他外设初始化并行 */
     Delay_Init();
+    LCD1602_InitStart();
+    Profile_Init();
+    Monitor_Init();
     UART_Init(USART1, 115200);
     ADC_Init();
     Motor_Init();
-    LCD1602_Init();
+    BOOT_CHECKPOINT("drivers");
     
-    /* 创建自定义字符 */
-    LCD1602_CreateChar(0, speed_icon);
+    /* 创建任务 */
+    Sched_TaskInit(&motor_task, "motor", Task_Motor, NULL, PRIO_MOTOR);
+    Sched_TaskInit(&adc_task, "adc", Task_ADC, NULL, PRIO_ADC);
+    Sched_TaskInit(&lcd_task, "lcd", Task_LCD, NULL, PRIO_LCD);
+    Sched_TaskInit(&lcd_init_task, "lcdini", Task_LCDInit, NULL, PRIO_LCD);
+    Sched_TaskInit(&uart_task, "uart", Task_UART, NULL, PRIO_UART);
     
-    /* LCD 欢迎界面 */
-    LCD1602_Clear();
-    LCD1602_Printf(0, 0, " STM32 Control ");
-    LCD1602_Printf(1, 0, "  System v1.0  ");
-    Delay_Ms(2000);
+    /* 截止时间: 从投递到执行完的最长允许时间 */
+    Sched_SetDeadline(&motor_task, 2000);
+    Sched_SetDeadline(&adc_task, 5000);
+    Sched_SetDeadline(&lcd_task, 50000);
     
-    /* UART 欢迎信息 */
-    UART_SendString(USART1, "\r\n");
-    UART_SendString(USART1, "╔════════════════════════════════════════╗\r\n");
-    UART_SendString(USART1, "║   STM32F103 综合控制系统               ║\r\n");
-    UART_SendString(USART1, "╠════════════════════════════════════════╣\r\n");
-    UART_SendString(USART1, "║ 功能:                                  ║\r\n");
-    UART_SendString(USART1, "║  • LCD1602 实时显示                    ║\r\n");
-    UART_SendString(USART1, "║  • ADC 电位器采集                      ║\r\n");
-    UART_SendString(USART1, "║  • PWM 电机速度控制                    ║\r\n");
-    UART_SendString(USART1, "║  • UART 数据监控                       ║\r\n");
-    UART_SendString(USART1, "╚════════════════════════════════════════╝\r\n");
-    UART_SendString(USART1, "\r\n系统已启动！\r\n\r\n");
+    /* 周期投递: 首次时间错开, 避免同一节拍集中执行 */
+    Sched_StartPeriodic(&adc_task, 0, 100, 0);
+    Sched_StartPeriodic(&lcd_init_task, 0, 1, 0);     /* 完成后启动 lcd_task */
+    Sched_StartPeriodic(&uart_task, 20, 1000, 0);
     
-    /* LCD 主界面 */
-    LCD1602_Clear();
-    LCD1602_Printf(0, 0, "Speed:");
-    LCD1602_SetCursor(0, 15);
-    LCD1602_PrintChar(0);  /* 速度图标 */
-    LCD1602_Printf(1, 0, "ADC:     V:    ");
-    
-    /* 主循环 */
-    while(1)
-    {
-        /* 读取 ADC 值 (电位器) */
-        adc_value = ADC_ReadAverage(ADC_CHANNEL_0, 5);
-        voltage = ADC_ReadVoltage(ADC_CHANNEL_0);
-        
-        /* 计算电机速度 (-100 到 +100) */
-        /* ADC 0-2047: 反转, 2048-4095: 正转 */
-        if(adc_value < 2048)
-        {
-            motor_speed = -(int16_t)((2048 - adc_value) * 100 / 2048);
-        }
-        else
-        {
-            motor_speed = (int16_t)((adc_value - 2048) * 100 / 2047);
-        }
-        
-        /* 死区处理 (±5%) */
-        if(motor_speed > -5 && motor_speed < 5)
-        {
-            motor_speed = 0;
-        }
-        
-        /* 设置电机速度 */
-        Motor_SetSpeed(1, motor_speed);
-        
-        /* 更新 LCD 显示 */
-        LCD1602_Printf(0, 7, "%4d%%", motor_speed);
-        LCD1602_Printf(1, 4, "%4u", adc_value);
-        LCD1602_Printf(1, 11, "%.2f", voltage);
-        
-        /* 每秒通过 UART 输出一次状态 */
-        update_counter++;
-        if(update_counter >= 10)  /* 100ms * 10 = 1s */
-        {
-            update_counter = 0;
-            
-            UART_SendString(USART1, "┌─────────────────────────────────────┐\r\n");
-            UART_Printf(USART1,     "│ ADC值: %-4u  电压: %.2fV         │\r\n", 
-                        adc_value, voltage);
-            UART_Printf(USART1,     "│ 电机速度: %+4d%%                   │\r\n", 
-                        motor_speed);
-            
-            if(motor_speed > 0)
-                UART_SendString(USART1, "│ 状态: 正转 →                       │\r\n");
-            else if(motor_speed < 0)
-                UART_SendString(USART1, "│ 状态: 反转 ←                       │\r\n");
-            else
-                UART_SendString(USART1, "│ 状态: 停止 ■                       │\r\n");
-            
-            UART_SendString(USART1, "└─────────────────────────────────────┘\r\n");
-        }
-        
-        /* 延时 100ms */
-        Delay_Ms(100);
-    }
+    /* 调度器主循环, 空闲时睡眠, 不返回 */
+    Sched_Run();
 }
-
@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    gpio_benchmark.c
+  * @brief   GPIO 引脚配置速度测试程序
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- 用 DWT 周期计数器比较三种引脚配置方式的 CPU 周期数:
+  1. 旧版 GPIO_Init (循环查找引脚位置, 每个引脚一次 CRL/CRH 读改写)
+  2. 当前 GPIO_Init (直接由最低位求位置, 每个引脚一次读改写)
+  3. GPIO_InitPort (编译期算好的掩码, 整个端口一次 CRL + 一次 CRH)
+- 测试两种场景: ADC_Init 的 PA0-PA7 模拟输入, 读忙标志时 D4-D7 的方向切换
+- 通过 UART 输出结果
+
+硬件连接：
+UART:
+  - PA9-10: TX/RX
+
+说明：
+测试只改写 PA0-PA7 和 PB8-PB11 的配置, 运行时不要连接会被输出驱动损坏的外设。
+代码大小对比: 编译后执行
+  arm-none-eabi-nm -S --size-sort build/stm32f103_project.elf | grep -i "GPIO_Init\|Bench_InitScan"
+GPIO_InitPort 的调用方只需传入一个常量结构体地址, 而 GPIO_Init 每个引脚一次调用 (4 个参数)。
+预期的寄存器访问次数和结果表见 docs/PERIPHERAL_GUIDE.md 的 GPIO 一节 (一次配置多个引脚)。
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+
+/* 周期测量重复次数 (取最小值, 排除中断干扰) */
+#define BENCH_RUNS      16
+
+/* 测试场景 1: ADC 通道 PA0-PA7 模拟输入 */
+static const GPIO_PortConfig_t bench_adc_pins =
+    GPIO_PORT_CONFIG(GPIOA, GPIO_CR_MASK(0x00FF),
+                     GPIO_CR_VALUE(0x00FF, GPIO_MODE_INPUT, GPIO_CNF_INPUT_ANALOG));
+
+/* 测试场景 2: LCD 数据线 PB8-PB11 输入/输出切换 */
+static const GPIO_PortConfig_t bench_data_in =
+    GPIO_PORT_CONFIG(GPIOB, GPIO_CR_MASK(0x0F00),
+                     GPIO_CR_VALUE(0x0F00, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING));
+static const GPIO_PortConfig_t bench_data_out =
+    GPIO_PORT_CONFIG(GPIOB, GPIO_CR_MASK(0x0F00),
+                     GPIO_CR_VALUE(0x0F00, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP));
+
+/**
+  * @brief  旧版 GPIO_Init (循环查找引脚位置), 用作对照
+  * @param  GPIOx: GPIO 端口
+  * @param  GPIO_Pin: 引脚
+  * @param  Mode: 模式
+  * @param  CNF: 配置
+  * @retval None
+  */
+static void __attribute__((noinline)) Bench_InitScan(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+                                                     uint32_t Mode, uint32_t CNF)
+{
+    uint32_t position = 0;
+    uint32_t config = 0;
+
+    while(GPIO_Pin >> position != 1)
+    {
+        position++;
+    }
+
+    config = (CNF << 2) | Mode;
+
+    if(position < 8)
+    {
+        GPIOx->CRL &= ~(0xF << (position * 4));
+        GPIOx->CRL |= (config << (position * 4));
+    }
+    else
+    {
+        position -= 8;
+        GPIOx->CRH &= ~(0xF << (position * 4));
+        GPIOx->CRH |= (config << (position * 4));
+    }
+}
+
+/**
+  * @brief  场景 1: 配置 PA0-PA7
+  * @param  method: 0 = 旧版 GPIO_Init, 1 = 当前 GPIO_Init, 2 = GPIO_InitPort
+  * @retval 最小周期数
+  */
+static uint32_t Bench_AdcPins(uint8_t method)
+{
+    uint32_t start, cycles, best = 0xFFFFFFFF;
+    uint8_t run, pin;
+
+    for(run = 0; run < BENCH_RUNS; run++)
+    {
+        start = DWT->CYCCNT;
+
+        if(method == 2)
+        {
+            GPIO_InitPort(&bench_adc_pins);
+        }
+        else
+        {
+            for(pin = 0; pin < 8; pin++)
+            {
+                if(method == 0)
+                    Bench_InitScan(GPIOA, 1 << pin, GPIO_MODE_INPUT, GPIO_CNF_INPUT_ANALOG);
+                else
+                    GPIO_Init(GPIOA, 1 << pin, GPIO_MODE_INPUT, GPIO_CNF_INPUT_ANALOG);
+            }
+        }
+
+        cycles = DWT->CYCCNT - start;
+        if(cycles < best)
+            best = cycles;
+    }
+
+    return best;
+}
+
+/**
+  * @brief  场景 2: PB8-PB11 切换为输入再切回输出 (一次忙标志查询的开销)
+  * @param  method: 0 = 旧版 GPIO_Init, 1 = 当前 GPIO_Init, 2 = GPIO_InitPort
+  * @retval 最小周期数
+  */
+static uint32_t Bench_DataPins(uint8_t method)
+{
+    uint32_t start, cycles, best = 0xFFFFFFFF;
+    uint8_t run, pin;
+
+    for(run = 0; run < BENCH_RUNS; run++)
+    {
+        start = DWT->CYCCNT;
+
+        if(method == 2)
+        {
+            GPIO_InitPort(&bench_data_in);
+            GPIO_InitPort(&bench_data_out);
+        }
+        else
+        {
+            for(pin = 8; pin < 12; pin++)
+            {
+                if(method == 0)
+                    Bench_InitScan(GPIOB, 1 << pin, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+                else
+                    GPIO_Init(GPIOB, 1 << pin, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+            }
+            for(pin = 8; pin < 12; pin++)
+            {
+                if(method == 0)
+                    Bench_InitScan(GPIOB, 1 << pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+                else
+                    GPIO_Init(GPIOB, 1 << pin, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+            }
+        }
+
+        cycles = DWT->CYCCNT - start;
+        if(cycles < best)
+            best = cycles;
+    }
+
+    return best;
+}
+
+int main(void)
+{
+    static const char *const name[3] = { "GPIO_Init (scan)", "GPIO_Init (ctz) ", "GPIO_InitPort   " };
+    uint8_t method;
+
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_IOPBEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+    /* 配置 UART */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+
+    UART_SendString(USART1, "\r\nGPIO config benchmark\r\n");
+
+    UART_SendString(USART1, "PA0-PA7 analog (ADC_Init):\r\n");
+    for(method = 0; method < 3; method++)
+    {
+        UART_Printf(USART1, "  %s: %lu cycles\r\n", name[method], Bench_AdcPins(method));
+    }
+
+    UART_SendString(USART1, "PB8-PB11 in + out (busy flag poll):\r\n");
+    for(method = 0; method < 3; method++)
+    {
+        UART_Printf(USART1, "  %s: %lu cycles\r\n", name[method], Bench_DataPins(method));
+    }
+
+    while(1)
+    {
+    }
+}
@@ -0,0 +1,263 @@
+/**
+  ******************************************************************************
+  * @file    kernel_latency.c
+  * @brief   抢占式内核示例程序 - 测量上下文切换和中断到线程的延迟
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- 4 个线程: irq (优先级 0), ping (1), pong (2), report (3)
+- 中断到线程延迟: TIM3 每 1ms 产生更新中断, 中断中释放信号量, irq 线程被唤醒后读取 TIM3->CNT,
+  得到从定时器更新事件到线程开始运行的周期数 (包含中断进入、信号量、PendSV 切换)
+- 上下文切换延迟: pong 线程记录 DWT 周期数后释放信号量, 高优先级的 ping 线程立即抢占,
+  两者之差即为 "释放信号量 + 切换到另一个线程" 的周期数
+- report 线程每秒输出最小/平均/最大值 (CPU 周期, 72 周期 = 1us) 和每秒切换次数,
+  统计数据用互斥量保护 (report 优先级最低, 持有互斥量时会被临时提升优先级)
+- 每 10 秒输出主栈、各线程栈的最大用量和堆用量 (memstat.h), 用于确定栈大小
+- 结果需在实际硬件上运行得到; 内核占用的 RAM 在启动时输出, Flash 占用用
+  arm-none-eabi-size build/stm32f103_project.elf 或 map 文件查看 kernel.o
+
+硬件连接：
+UART:
+  - PA9-10: TX/RX
+
+定时器:
+  - TIM3: 1kHz 更新中断
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+#include "pwm.h"
+#include "kernel.h"
+#include "memstat.h"
+#include <stddef.h>
+
+#define TIM_DIER_UIE        (1 << 0)   /* 更新中断使能 */
+#define TIM_SR_UIF          (1 << 0)   /* 更新中断标志 */
+#define TIM_CR1_CEN         (1 << 0)   /* 计数器使能 */
+
+/* 延迟统计 (CPU 周期) */
+typedef struct
+{
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;
+    uint32_t count;
+} Latency_t;
+
+static Kernel_Thread_t irq_thread, ping_thread, pong_thread, report_thread;
+static uint32_t irq_stack[128], ping_stack[128], pong_stack[128], report_stack[256];
+
+static Kernel_Sem_t irq_sem;
+static Kernel_Sem_t ping_sem;
+static Kernel_Mutex_t stats_mutex;
+
+static Latency_t irq_latency;
+static Latency_t switch_latency;
+static volatile uint32_t ping_start;
+
+/**
+  * @brief  清零统计
+  * @param  lat: 统计数据
+  * @retval None
+  */
+static void Latency_Reset(Latency_t *lat)
+{
+    lat->min = 0xFFFFFFFFUL;
+    lat->max = 0;
+    lat->sum = 0;
+    lat->count = 0;
+}
+
+/**
+  * @brief  记录一次测量
+  * @param  lat: 统计数据
+  * @param  cycles: 测量值 (CPU 周期)
+  * @retval None
+  */
+static void Latency_Add(Latency_t *lat, uint32_t cycles)
+{
+    Kernel_MutexLock(&stats_mutex, KERNEL_WAIT_FOREVER);
+    if(cycles < lat->min)
+        lat->min = cycles;
+    if(cycles > lat->max)
+        lat->max = cycles;
+    lat->sum += cycles;
+    lat->count++;
+    Kernel_MutexUnlock(&stats_mutex);
+}
+
+/**
+  * @brief  中断到线程: 等待 TIM3 中断释放的信号量
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Thread_Irq(void *arg)
+{
+    uint32_t cycles;
+
+    (void)arg;
+
+    while(1)
+    {
+        Kernel_SemTake(&irq_sem, KERNEL_WAIT_FOREVER);
+
+        /* 计数器从更新事件开始计数, 换算为 CPU 周期 */
+        cycles = TIM3->CNT * (TIM3->PSC + 1);
+        Latency_Add(&irq_latency, cycles);
+    }
+}
+
+/**
+  * @brief  线程到线程: 被 pong 唤醒后立即记录
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Thread_Ping(void *arg)
+{
+    uint32_t cycles;
+
+    (void)arg;
+
+    while(1)
+    {
+        Kernel_SemTake(&ping_sem, KERNEL_WAIT_FOREVER);
+
+        cycles = Delay_GetCycles() - ping_start;
+        Latency_Add(&switch_latency, cycles);
+    }
+}
+
+/**
+  * @brief  每 2ms 唤醒一次 ping
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Thread_Pong(void *arg)
+{
+    (void)arg;
+
+    while(1)
+    {
+        Kernel_Sleep(2);
+
+        ping_start = Delay_GetCycles();
+        Kernel_SemGive(&ping_sem);
+    }
+}
+
+/**
+  * @brief  输出一项统计
+  * @param  name: 名称
+  * @param  lat: 统计数据 (副本)
+  * @retval None
+  */
+static void Print_Latency(const char *name, const Latency_t *lat)
+{
+    if(lat->count == 0)
+    {
+        UART_Printf(USART1, "  %-14s no samples\r\n", name);
+        return;
+    }
+
+    UART_Printf(USART1, "  %-14s n=%4lu  min %4lu  avg %4lu  max %4lu cycles\r\n",
+                name, lat->count, lat->min, lat->sum / lat->count, lat->max);
+}
+
+/**
+  * @brief  每秒输出统计
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Thread_Report(void *arg)
+{
+    Latency_t irq_copy, switch_copy;
+    uint32_t switches, last_switches = 0;
+    uint32_t reports = 0;
+
+    (void)arg;
+
+    while(1)
+    {
+        Kernel_Sleep(1000);
+
+        /* 只在持有互斥量期间复制, UART 输出在锁外进行 */
+        Kernel_MutexLock(&stats_mutex, KERNEL_WAIT_FOREVER);
+        irq_copy = irq_latency;
+        switch_copy = switch_latency;
+        Latency_Reset(&irq_latency);
+        Latency_Reset(&switch_latency);
+        Kernel_MutexUnlock(&stats_mutex);
+
+        switches = Kernel_GetSwitches();
+
+        UART_Printf(USART1, "[%lus] switches/s %lu\r\n", GetTick() / 1000, switches - last_switches);
+        Print_Latency("irq->thread", &irq_copy);
+        Print_Latency("give->thread", &switch_copy);
+        last_switches = switches;
+
+        /* 每 10 秒输出各线程栈的最大用量 */
+        if(++reports % 10 == 0)
+        {
+            MemStat_Print(USART1);
+        }
+    }
+}
+
+int main(void)
+{
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+
+    /* 配置 UART */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+
+    UART_Printf(USART1, "\r\nKernel latency test\r\n");
+    UART_Printf(USART1, "RAM: thread %u B, mutex %u B, sem %u B, idle stack %u B\r\n",
+                sizeof(Kernel_Thread_t), sizeof(Kernel_Mutex_t), sizeof(Kernel_Sem_t),
+                KERNEL_IDLE_STACK * 4);
+
+    Kernel_SemInit(&irq_sem, 0, 1);
+    Kernel_SemInit(&ping_sem, 0, 1);
+    Kernel_MutexInit(&stats_mutex);
+    Latency_Reset(&irq_latency);
+    Latency_Reset(&switch_latency);
+
+    Kernel_ThreadCreate(&irq_thread, "irq", Thread_Irq, NULL, 0, irq_stack, sizeof(irq_stack));
+    Kernel_ThreadCreate(&ping_thread, "ping", Thread_Ping, NULL, 1, ping_stack, sizeof(ping_stack));
+    Kernel_ThreadCreate(&pong_thread, "pong", Thread_Pong, NULL, 2, pong_stack, sizeof(pong_stack));
+    Kernel_ThreadCreate(&report_thread, "report", Thread_Report, NULL, 3, report_stack, sizeof(report_stack));
+
+    /* TIM3: 1kHz 更新中断 */
+    PWM_SetTimebase(TIM3, 1000);
+    TIM3->DIER = TIM_DIER_UIE;
+    TIM3->CR1 |= TIM_CR1_CEN;
+    NVIC_EnableIRQ(TIM3_IRQn);
+
+    Kernel_Start();
+}
+
+/**
+  * @brief  TIM3 更新中断: 唤醒 irq 线程
+  * @param  None
+  * @retval None
+  */
+void TIM3_IRQHandler(void)
+{
+    TIM3->SR = ~TIM_SR_UIF;
+    Kernel_SemGive(&irq_sem);
+}
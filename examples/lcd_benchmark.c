@@ -0,0 +1,265 @@
+/**
+  ******************************************************************************
+  * @file    lcd_benchmark.c
+  * @brief   LCD1602 写入速度测试程序
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- 分别在固定延时模式和忙标志查询模式下写满 LCD
+- 通过 UART 输出每种模式的写入速度 (字符/秒)
+- 用 DWT 周期计数器只测量 D4-D7 的端口写入 (一行 16 个字符 = 32 个半字节,
+  不含使能脉冲延时和忙标志查询), 对比一次 BSRR 写入与逐引脚写入两种路径
+- BENCH_USE_PCF8574 = 1 时改用 I2C 转接板, 输出每行的总线传输时间:
+  整行一次传输 (LCD1602_Print) 与逐字符传输 (LCD1602_PrintChar) 对比
+
+硬件连接：
+LCD1602:
+  - PB12-14: RS, RW, EN (忙标志模式要求 RW 必须连接, 不能直接接地)
+  - PB8-11: D4-D7
+
+I2C 转接板 (BENCH_USE_PCF8574 = 1 时):
+  - PB6: SCL, PB7: SDA (需上拉)
+
+UART:
+  - PA9-10: TX/RX
+
+说明：
+忙标志查询超时后驱动会自动回退到固定延时, 此时结果中标记为 "fallback"
+端口写入测试时 EN 保持低电平, LCD 不会锁存数据线上的值。两种路径是驱动中
+LCD_PutNibble 两个分支的副本, 驱动本身只编译 LCD_DATA_CONTIGUOUS 选中的一个;
+引脚分散时 BSRR 路径无法驱动 D4-D7, 不测量。
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+#include "lcd1602.h"
+#include "lcd_pcf8574.h"
+
+/* 1 = 通过 PCF8574 I2C 转接板连接 LCD, 0 = 并口 */
+#define BENCH_USE_PCF8574   0
+
+/* 每种模式写入的行数 (每行 16 个字符) */
+#define BENCH_LINES     200
+
+/* 周期测量重复次数 (取最小值, 排除中断干扰) */
+#define BENCH_CYCLE_RUNS    8
+
+/* 端口写入测试: 一行 16 个字符的半字节数 */
+#define BENCH_NIBBLES       (LCD_COLS * 2)
+
+/* 半字节写入函数 */
+typedef void (*Bench_Nibble_t)(uint8_t nibble);
+
+/**
+  * @brief  连续写入 BENCH_LINES 行并计算速度
+  * @param  busy_flag: 1 = 忙标志查询, 0 = 固定延时
+  * @retval 写入速度 (字符/秒)
+  */
+static uint32_t Bench_Run(uint8_t busy_flag)
+{
+    uint32_t start, elapsed;
+    uint16_t line;
+
+    LCD1602_SetBusyFlagMode(busy_flag);
+
+    start = GetTick();
+    for(line = 0; line < BENCH_LINES; line++)
+    {
+        LCD1602_SetCursor(line & 1, 0);
+        LCD1602_Print((line & 2) ? "0123456789ABCDEF" : "FEDCBA9876543210");
+    }
+    elapsed = GetTick() - start;
+
+    if(elapsed == 0)
+        elapsed = 1;
+
+    return (uint32_t)BENCH_LINES * LCD_COLS * 1000 / elapsed;
+}
+
+/**
+  * @brief  连续端口路径: 一次 BSRR 写入 4 根数据线 (同驱动 LCD_PutNibble)
+  * @param  nibble: 4位数据
+  * @retval None
+  */
+static void __attribute__((noinline)) Bench_NibbleBSRR(uint8_t nibble)
+{
+    uint32_t bits = nibble & 0x0F;
+
+    LCD_D4_PORT->BSRR = ((bits ^ 0x0F) * LCD_D4_PIN << 16) | (bits * LCD_D4_PIN);
+}
+
+/**
+  * @brief  引脚分散路径: 逐个引脚写入 (同驱动 LCD_PutNibble)
+  * @param  nibble: 4位数据
+  * @retval None
+  */
+static void __attribute__((noinline)) Bench_NibblePins(uint8_t nibble)
+{
+    GPIO_WritePin(LCD_D4_PORT, LCD_D4_PIN, (nibble & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_D5_PORT, LCD_D5_PIN, (nibble & 0x02) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_D6_PORT, LCD_D6_PIN, (nibble & 0x04) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    GPIO_WritePin(LCD_D7_PORT, LCD_D7_PIN, (nibble & 0x08) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+/**
+  * @brief  空函数, 用于扣除调用和循环的开销
+  * @param  nibble: 未使用
+  * @retval None
+  */
+static void __attribute__((noinline)) Bench_NibbleNone(uint8_t nibble)
+{
+    __asm volatile ("" : : "r" (nibble));
+}
+
+/**
+  * @brief  测量写 BENCH_NIBBLES 个半字节的周期数 (关中断)
+  * @param  write: 半字节写入函数
+  * @retval 最小周期数
+  */
+static uint32_t Bench_NibbleCycles(Bench_Nibble_t write)
+{
+    uint32_t primask, start, cycles, best = 0xFFFFFFFF;
+    uint8_t run, i;
+
+    for(run = 0; run < BENCH_CYCLE_RUNS; run++)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        start = DWT->CYCCNT;
+        for(i = 0; i < BENCH_NIBBLES; i++)
+        {
+            write(i);
+        }
+        cycles = DWT->CYCCNT - start;
+
+        __set_PRIMASK(primask);
+
+        if(cycles < best)
+            best = cycles;
+    }
+
+    return best;
+}
+
+#if BENCH_USE_PCF8574
+/**
+  * @brief  测量 I2C 转接板写一行 16 个字符的总线传输时间
+  * @param  batched: 1 = 整行一次写入, 0 = 逐字符写入
+  * @retval 最短传输时间 (us)
+  */
+static uint32_t Bench_LineUs(uint8_t batched)
+{
+    const char *line = "0123456789ABCDEF";
+    uint32_t us, best = 0xFFFFFFFF;
+    uint8_t run, i;
+
+    for(run = 0; run < BENCH_CYCLE_RUNS; run++)
+    {
+        LCD1602_SetCursor(1, 0);
+
+        if(batched)
+        {
+            LCD1602_Print(line);
+            us = LCD_PCF8574_GetLastWriteUs();
+        }
+        else
+        {
+            us = 0;
+            for(i = 0; i < LCD_COLS; i++)
+            {
+                LCD1602_PrintChar(line[i]);
+                us += LCD_PCF8574_GetLastWriteUs();
+            }
+        }
+
+        if(us < best)
+            best = us;
+    }
+
+    return best;
+}
+#endif
+
+int main(void)
+{
+    uint32_t cps_fixed, cps_busy;
+#if !BENCH_USE_PCF8574
+    uint32_t base, cyc_bsrr, cyc_pins;
+#endif
+
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+    /* 配置 UART */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+
+#if BENCH_USE_PCF8574
+    LCD_PCF8574_Config(I2C1, LCD_PCF8574_ADDR);
+    LCD1602_SetTransport(&LCD_TransportPCF8574);
+#endif
+    LCD1602_Init();
+
+    UART_SendString(USART1, "\r\nLCD1602 benchmark\r\n");
+
+#if BENCH_USE_PCF8574
+    if(LCD_PCF8574_GetStatus() != I2C_OK)
+    {
+        UART_Printf(USART1, "PCF8574 at 0x%02X not responding (status %d)\r\n",
+                    LCD_PCF8574_ADDR, LCD_PCF8574_GetStatus());
+    }
+
+    /* 每行传输时间: 一次 I2C 传输 vs 16 次 */
+    UART_Printf(USART1, "line, one burst     : %lu us\r\n", Bench_LineUs(1));
+    UART_Printf(USART1, "line, per-char burst: %lu us\r\n", Bench_LineUs(0));
+#endif
+    UART_Printf(USART1, "data bus    : %s\r\n",
+                LCD_DATA_CONTIGUOUS ? "contiguous (single BSRR write)" : "scattered pins");
+
+#if !BENCH_USE_PCF8574
+    /* 只测端口写入: 两种路径各写一行的半字节, 扣除空调用的开销 */
+    base = Bench_NibbleCycles(Bench_NibbleNone);
+    cyc_pins = Bench_NibbleCycles(Bench_NibblePins) - base;
+    UART_Printf(USART1, "%u nibbles, per-pin writes : %lu cycles\r\n", BENCH_NIBBLES, cyc_pins);
+    if(LCD_DATA_CONTIGUOUS)
+    {
+        cyc_bsrr = Bench_NibbleCycles(Bench_NibbleBSRR) - base;
+        UART_Printf(USART1, "%u nibbles, single BSRR    : %lu cycles\r\n", BENCH_NIBBLES, cyc_bsrr);
+    }
+    else
+    {
+        UART_Printf(USART1, "%u nibbles, single BSRR    : n/a (pins scattered)\r\n", BENCH_NIBBLES);
+    }
+#endif
+
+    /* 固定延时模式 */
+    cps_fixed = Bench_Run(0);
+    UART_Printf(USART1, "fixed delay : %lu chars/s\r\n", cps_fixed);
+
+    /* 忙标志查询模式 */
+    cps_busy = Bench_Run(1);
+    UART_Printf(USART1, "busy flag   : %lu chars/s%s\r\n", cps_busy,
+                LCD1602_GetBusyFlagMode() ? "" : " (fallback)");
+
+    LCD1602_Clear();
+    LCD1602_Printf(0, 0, "Fix %5lu c/s", cps_fixed);
+    LCD1602_Printf(1, 0, "BF  %5lu c/s", cps_busy);
+
+    while(1)
+    {
+    }
+}
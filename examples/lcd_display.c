@@ -11,7 +11,7 @@
 
 功能：
 - LCD1602 字符显示
-- 显示静态文本、动态数字、自定义字符
+- 显示静态文本、动态数字、自定义字符 (由字形缓存自动分配 CGRAM 槽位)
 - 演示各种显示效果
 
 硬件连接 (4位并口模式):
@@ -56,18 +56,10 @@ int main(void)
 {
     uint32_t counter = 0;
     
-    /* 系统初始化 */
-    SystemInit();
-    
     /* 初始化外设 */
     Delay_Init();
     LCD1602_Init();
     
-    /* 创建自定义字符 */
-    LCD1602_CreateChar(0, heart);
-    LCD1602_CreateChar(1, smile);
-    LCD1602_CreateChar(2, temp);
-    
     /* 显示欢迎信息 */
     LCD1602_Clear();
     LCD1602_Printf(0, 0, "  STM32F103  ");
@@ -78,11 +70,11 @@ int main(void)
     LCD1602_Clear();
     LCD1602_Printf(0, 0, "Custom Char:");
     LCD1602_SetCursor(1, 0);
-    LCD1602_PrintChar(0);  /* 心形 */
+    LCD1602_PrintChar(LCD1602_Glyph(heart));  /* 心形 */
     LCD1602_PrintChar(' ');
-    LCD1602_PrintChar(1);  /* 笑脸 */
+    LCD1602_PrintChar(LCD1602_Glyph(smile));  /* 笑脸 */
     LCD1602_PrintChar(' ');
-    LCD1602_PrintChar(2);  /* 温度 */
+    LCD1602_PrintChar(LCD1602_Glyph(temp));  /* 温度 */
     Delay_Ms(2000);
     
     /* 主循环: 显示计数器 */
@@ -99,7 +91,7 @@ int main(void)
         if(counter % 10 == 0)
         {
             LCD1602_SetCursor(1, 15);
-            LCD1602_PrintChar(0);  /* 心形 */
+            LCD1602_PrintChar(LCD1602_Glyph(heart));  /* 心形 */
         }
         
         Delay_Ms(500);
@@ -117,7 +109,7 @@ int main(void)
             LCD1602_Clear();
             LCD1602_Printf(0, 0, "Temperature:");
             LCD1602_SetCursor(0, 13);
-            LCD1602_PrintChar(2);  /* 温度图标 */
+            LCD1602_PrintChar(LCD1602_Glyph(temp));  /* 温度图标 */
             LCD1602_Printf(1, 0, "25.6");
             LCD1602_PrintChar(0xDF);  /* 度数符号 */
             LCD1602_Print("C");
@@ -133,9 +125,9 @@ int main(void)
             LCD1602_Clear();
             LCD1602_Printf(0, 0, "STM32 Project");
             LCD1602_SetCursor(1, 0);
-            LCD1602_PrintChar(1);  /* 笑脸 */
+            LCD1602_PrintChar(LCD1602_Glyph(smile));  /* 笑脸 */
             LCD1602_Print(" Ready! ");
-            LCD1602_PrintChar(1);
+            LCD1602_PrintChar(LCD1602_Glyph(smile));
         }
         else if(counter >= 200)
         {
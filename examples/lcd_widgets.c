@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * @file    lcd_widgets.c
+  * @brief   LCD1602 图形控件示例程序
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- 以 20Hz 刷新电位器读数
+- 页面1: 条形图 (5 像素/字符) + 迷你折线图 (最近 12 个采样)
+- 页面2: 两行高的大号数字
+- 每 5 秒切换页面
+- 控件只写入帧缓冲, 每帧只有变化的字符通过 TIM4 后台发送
+
+硬件连接：
+LCD1602:
+  - PB12-14: RS, RW, EN
+  - PB8-11: D4-D7
+
+ADC:
+  - PA0: 电位器输入
+
+定时器:
+  - TIM4: LCD 后台刷新
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "delay.h"
+#include "adc.h"
+#include "lcd1602.h"
+#include "lcd_widget.h"
+
+/* 刷新周期 (ms) */
+#define FRAME_MS        50
+
+/* 页面切换周期 (帧) */
+#define PAGE_FRAMES     100
+
+int main(void)
+{
+    Widget_Spark_t spark;
+    uint16_t adc_value;
+    uint32_t frame = 0;
+    uint32_t next;
+    uint8_t page = 0;
+
+    /* 初始化外设 */
+    Delay_Init();
+    ADC_Init();
+    LCD1602_Init();
+    LCD1602_AsyncInit();
+
+    LCD1602_FB_Clear();
+    LCD1602_FB_Print(0, 0, "ADC");
+    Widget_SparkInit(&spark, 1, 4, 12);
+
+    next = GetTick();
+
+    while(1)
+    {
+        adc_value = ADC_ReadAverage(ADC_CHANNEL_0, 4);
+
+        if(page == 0)
+        {
+            /* 第0行: 标签 + 条形图, 第1行: 百分比 + 折线图 */
+            Widget_Bar(0, 4, 12, adc_value, 4095);
+            LCD1602_FB_Printf(1, 0, "%3u%%", (unsigned)(adc_value * 100 / 4095));
+            Widget_SparkPush(&spark, adc_value, 4095);
+        }
+        else
+        {
+            /* 大号数字: 4 位占 15 列 */
+            Widget_BigNumber(0, 0, adc_value, 4);
+        }
+
+        /* 只有变化的字符入队, 由 TIM4 在后台发送 */
+        LCD1602_FB_FlushAsync();
+
+        /* 切换页面 */
+        if(++frame % PAGE_FRAMES == 0)
+        {
+            page ^= 1;
+            LCD1602_FB_Clear();
+            if(page == 0)
+            {
+                LCD1602_FB_Print(0, 0, "ADC");
+                Widget_SparkInit(&spark, 1, 4, 12);
+            }
+        }
+
+        /* 固定帧率: 按绝对时间等待, 不受本帧耗时影响 */
+        next += FRAME_MS;
+        while((int32_t)(GetTick() - next) < 0)
+        {
+        }
+    }
+}
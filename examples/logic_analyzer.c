@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file    logic_analyzer.c
+  * @brief   逻辑分析仪示例程序 (DMA 采集 GPIO + VCD 导出 + 采样率测试)
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- TIM3 CH1 (PA6) 输出 1kHz PWM 作为被测信号, 主循环在 PA5 上翻转作为第二个信号
+- 以 1MHz 采集 GPIOA, PA6 上升沿触发, 触发前 256 个样本, 触发后 1792 个样本
+- 采集完成后通过 UART 输出 VCD, 主机端保存为文件:
+    python3 tools/logic_vcd.py /dev/ttyUSB0 capture.vcd
+  然后用 GTKWave 或 PulseView 打开 capture.vcd
+- 最后做采样率扫描: 用 DWT 测量 DMA 写满样本的实际时间, 输出可持续的采样率
+
+硬件连接：
+UART:
+  - PA9-10: TX/RX
+
+被测信号:
+  - PA5, PA6 无需连接 (采集的是本芯片自己的输出), 也可以改为采集外部信号
+
+定时器:
+  - TIM2 + DMA1 通道2: 采样
+  - TIM3: 测试信号 PWM
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+#include "pwm.h"
+#include "logic.h"
+#include <stddef.h>
+
+/* 采样率扫描的设定值 (Hz) */
+static const uint32_t sweep_rate[] = { 1000000, 2000000, 3000000, 4500000, 6000000, 9000000 };
+
+/**
+  * @brief  测量一次采集中 DMA 的实际采样率
+  * @param  rate: 设定采样率 (Hz)
+  * @retval 实际写入速率 (Hz), 0 = 采样率无效
+  *
+  * DMA 来不及处理的定时器请求会被丢弃, 写满同样数量的样本需要更长时间,
+  * 因此 写入样本数 / 实际时间 低于设定值时说明已超过可持续速率。
+  */
+static uint32_t Sweep_Measure(uint32_t rate)
+{
+    uint32_t start, cycles;
+    const Logic_Capture_t *cap;
+
+    rate = Logic_Init(GPIOA, GPIO_PIN_5 | GPIO_PIN_6, rate);
+    if(rate == 0)
+        return 0;
+
+    /* 软件触发, 立即开始计数触发后样本 */
+    start = DWT->CYCCNT;
+    Logic_Arm(0, LOGIC_SAMPLES / 2, NULL, 0, EXTI_EDGE_RISING);
+    Logic_Trigger();
+    while(Logic_GetState() != LOGIC_DONE)
+    {
+    }
+    cycles = DWT->CYCCNT - start;
+
+    cap = Logic_GetCapture();
+    return (uint32_t)((uint64_t)cap->written * SystemCoreClock / cycles);
+}
+
+int main(void)
+{
+    uint32_t rate;
+    uint8_t i;
+
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+
+    /* 配置 UART */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+
+    /* 测试信号: PA5 普通输出, PA6 = TIM3_CH1 PWM */
+    GPIO_Init(GPIOA, GPIO_PIN_5, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_OUTPUT_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_6, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+
+    PWM_Init(TIM3, 1000);
+    PWM_SetDutyCycle(TIM3, PWM_CHANNEL_1, 25.0f);
+    PWM_Start(TIM3, PWM_CHANNEL_1);
+
+    /* 1MHz 采集, PA6 上升沿触发 */
+    rate = Logic_Init(GPIOA, GPIO_PIN_5 | GPIO_PIN_6, 1000000);
+    Logic_Arm(256, 1792, GPIOA, GPIO_PIN_6, EXTI_EDGE_RISING);
+
+    while(Logic_GetState() != LOGIC_DONE)
+    {
+        GPIO_PIN_OUT(GPIOA, 5) ^= 1;
+        Delay_Us(50);
+    }
+
+    Logic_ExportVCD(USART1);
+
+    /* 采样率扫描 */
+    UART_Printf(USART1, "\r\nsample rate sweep (capture rate %lu Hz above)\r\n", rate);
+    for(i = 0; i < sizeof(sweep_rate) / sizeof(sweep_rate[0]); i++)
+    {
+        UART_Printf(USART1, "  set %7lu Hz -> sustained %7lu Hz\r\n",
+                    sweep_rate[i], Sweep_Measure(sweep_rate[i]));
+    }
+
+    while(1)
+    {
+    }
+}
@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * @file    low_power_idle.c
+  * @brief   低功耗空闲示例程序 - Tickless 睡眠 + 空闲比例和唤醒延迟统计
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- LED 每 500ms 翻转一次, 每 5 秒通过 UART 输出一次统计, 其余时间 CPU 在 WFI 中睡眠
+- DELAY_TICKLESS = 1 时空闲期间跳过 SysTick 节拍, 每秒只唤醒几次
+- 统计内容: 空闲比例、睡眠次数、跳过节拍的睡眠次数、提前唤醒次数、唤醒延迟
+- 串口收到任意字符会提前唤醒 CPU (提前唤醒计数增加), 可用来验证节拍补偿:
+  输出中的 Up 时间应与 64 位时钟保持一致
+
+功耗测量：
+- 断开调试器, 在 3.3V 供电回路中串联电流表 (或万用表 mA/uA 档)
+- 分别用 -DDELAY_TICKLESS=0 和 -DDELAY_TICKLESS=1 编译, 记录两种情况的平均电流
+- 唤醒延迟以 CPU 周期输出 (72 周期 = 1us), 需在实际硬件上运行得到
+
+硬件连接：
+LED:
+  - PC13: 板载 LED
+
+UART:
+  - PA9-10: TX/RX
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+#include "swtimer.h"
+#include <stddef.h>
+
+static SwTimer_t led_timer;
+static SwTimer_t report_timer;
+
+static uint64_t report_start;
+
+/**
+  * @brief  LED 闪烁 (在 SysTick 中断中执行)
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_LED(void *arg)
+{
+    (void)arg;
+
+    GPIO_PIN_OUT(GPIOC, 13) ^= 1;
+}
+
+/**
+  * @brief  统计输出 (每 5 秒)
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_Report(void *arg)
+{
+    Delay_IdleStats_t stats;
+    uint64_t now;
+    uint32_t idle_permille;
+
+    (void)arg;
+
+    now = Delay_GetTimestamp();
+    Delay_GetIdleStats(&stats);
+    Delay_ResetIdleStats();
+
+    idle_permille = (uint32_t)(stats.sleep_cycles * 1000 / (now - report_start));
+    report_start = now;
+
+    UART_Printf(USART1, "Up %lus  idle %lu.%lu%%  sleeps %lu  tickless %lu  early %lu  "
+                "wake latency %lu/%lu cycles (last/max)\r\n",
+                (uint32_t)(Delay_GetTick64() / 1000),
+                idle_permille / 10, idle_permille % 10,
+                stats.sleeps, stats.tickless, stats.early_wakes,
+                stats.wake_latency_last, stats.wake_latency_max);
+}
+
+int main(void)
+{
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_IOPCEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+    /* 配置 UART 和 LED */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+    GPIO_Init(GPIOC, GPIO_PIN_13, GPIO_MODE_OUTPUT_2MHZ, GPIO_CNF_OUTPUT_PP);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+
+    /* 串口接收中断: 用于演示提前唤醒 */
+    USART1->CR1 |= USART_CR1_RXNEIE;
+    NVIC_EnableIRQ(USART1_IRQn);
+
+    UART_Printf(USART1, "\r\nLow power idle, DELAY_TICKLESS=%d\r\n", DELAY_TICKLESS);
+
+    SwTimer_Init(&led_timer, Task_LED, NULL, SWTIMER_ISR);
+    SwTimer_Init(&report_timer, Task_Report, NULL, SWTIMER_DEFERRED);
+    SwTimer_Start(&led_timer, 0, 500);
+    SwTimer_Start(&report_timer, 5000, 5000);
+
+    Delay_ResetIdleStats();
+    report_start = Delay_GetTimestamp();
+
+    while(1)
+    {
+        SwTimer_Process();
+        Delay_Idle();
+    }
+}
+
+/**
+  * @brief  USART1 中断: 丢弃收到的字符, 只用于唤醒
+  * @param  None
+  * @retval None
+  */
+void USART1_IRQHandler(void)
+{
+    if(USART1->SR & USART_SR_RXNE)
+    {
+        (void)USART1->DR;
+    }
+}
@@ -39,9 +39,6 @@ int main(void)
 {
     int16_t speed;
     
-    /* 系统初始化 */
-    SystemInit();
-    
     /* 使能时钟 */
     RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
     RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
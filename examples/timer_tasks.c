@@ -0,0 +1,147 @@
+/**
+  ******************************************************************************
+  * @file    timer_tasks.c
+  * @brief   软件定时器示例程序 - 多个任务按各自的周期独立运行
+  ******************************************************************************
+  */
+
+/*
+使用方法：
+将此文件内容复制到 Core/Src/main.c 即可运行此示例
+
+功能：
+- ADC 采集 10Hz, LCD 刷新 5Hz, UART 遥测 1Hz, 三个任务互不阻塞
+- 任务由 SysTick 驱动的软件定时器触发, 回调在主循环 SwTimer_Process() 中执行
+- LED 闪烁定时器的回调直接在 SysTick 中断中执行 (只翻转一个引脚)
+- 主循环中没有任何 Delay_Ms
+
+硬件连接：
+LCD1602:
+  - PB12-14: RS, RW, EN
+  - PB8-11: D4-D7
+
+ADC:
+  - PA0: 电位器输入
+
+LED:
+  - PC13: 板载 LED
+
+UART:
+  - PA9-10: TX/RX
+
+定时器:
+  - SysTick: 1ms 节拍, 驱动软件定时器
+  - TIM4: LCD 后台刷新
+*/
+
+#include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "gpio.h"
+#include "uart.h"
+#include "delay.h"
+#include "swtimer.h"
+#include "adc.h"
+#include "lcd1602.h"
+#include <stddef.h>
+
+static SwTimer_t adc_timer;
+static SwTimer_t lcd_timer;
+static SwTimer_t telemetry_timer;
+static SwTimer_t led_timer;
+
+static volatile uint16_t adc_value;
+static uint32_t adc_samples = 0;
+
+/**
+  * @brief  ADC 任务 (10Hz)
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_ADC(void *arg)
+{
+    (void)arg;
+
+    adc_value = ADC_ReadAverage(ADC_CHANNEL_0, 4);
+    adc_samples++;
+}
+
+/**
+  * @brief  LCD 任务 (5Hz): 更新帧缓冲, 由 TIM4 后台发送
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_LCD(void *arg)
+{
+    (void)arg;
+
+    LCD1602_FB_Printf(0, 5, "%4u", adc_value);
+    LCD1602_FB_Printf(1, 5, "%6lu", GetTick() / 1000);
+    LCD1602_FB_FlushAsync();
+}
+
+/**
+  * @brief  遥测任务 (1Hz)
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_Telemetry(void *arg)
+{
+    (void)arg;
+
+    UART_Printf(USART1, "t=%lus adc=%u samples=%lu lcd_missed=%u\r\n",
+                GetTick() / 1000, adc_value, adc_samples, lcd_timer.missed);
+}
+
+/**
+  * @brief  LED 闪烁 (2Hz, 在 SysTick 中断中执行)
+  * @param  arg: 未使用
+  * @retval None
+  */
+static void Task_LED(void *arg)
+{
+    (void)arg;
+
+    GPIO_PIN_OUT(GPIOC, 13) ^= 1;
+}
+
+int main(void)
+{
+    /* 使能时钟 */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_IOPCEN;
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+    /* 配置 UART 和 LED */
+    GPIO_Init(GPIOA, GPIO_PIN_9, GPIO_MODE_OUTPUT_50MHZ, GPIO_CNF_AF_PP);
+    GPIO_Init(GPIOA, GPIO_PIN_10, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOATING);
+    GPIO_Init(GPIOC, GPIO_PIN_13, GPIO_MODE_OUTPUT_2MHZ, GPIO_CNF_OUTPUT_PP);
+
+    /* 初始化外设 */
+    Delay_Init();
+    UART_Init(USART1, 115200);
+    ADC_Init();
+    LCD1602_Init();
+
+    LCD1602_Clear();
+    LCD1602_FB_Clear();
+    LCD1602_FB_Print(0, 0, "ADC:");
+    LCD1602_FB_Print(1, 0, "Up:       s");
+    LCD1602_AsyncInit();
+
+    /* 创建任务: 首次到期时间错开, 避免同一节拍集中执行 */
+    SwTimer_Init(&adc_timer, Task_ADC, NULL, SWTIMER_DEFERRED);
+    SwTimer_Init(&lcd_timer, Task_LCD, NULL, SWTIMER_DEFERRED);
+    SwTimer_Init(&telemetry_timer, Task_Telemetry, NULL, SWTIMER_DEFERRED);
+    SwTimer_Init(&led_timer, Task_LED, NULL, SWTIMER_ISR);
+
+    SwTimer_Start(&adc_timer, 0, 100);
+    SwTimer_Start(&lcd_timer, 10, 200);
+    SwTimer_Start(&telemetry_timer, 20, 1000);
+    SwTimer_Start(&led_timer, 0, 250);
+
+    UART_SendString(USART1, "\r\nSoftware timer tasks\r\n");
+
+    while(1)
+    {
+        SwTimer_Process();
+    }
+}
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    bitband.h
+  * @brief   Cortex-M3 bit-band alias access
+  ******************************************************************************
+  * Every bit of the first 1MB of SRAM (0x20000000) and of the peripheral
+  * region (0x40000000) is mirrored as a 32-bit word in an alias region.
+  * A store to the alias word sets or clears that single bit as one
+  * uninterruptible bus operation, and a load returns 0 or 1. Use it instead
+  * of "REG |= BIT" / "REG &= ~BIT" when the register is also written from an
+  * interrupt, or to test a flag without a mask:
+  *
+  *   BITBAND_PERI(TIM4->CR1, 0) = 1;          // set CEN
+  *   while(!BITBAND_PERI(ADC1->SR, 1));       // wait for EOC
+  *   BITBAND_SRAM(flags, 3) = 0;              // clear bit 3 of a RAM word
+  *
+  * Registers whose flags hardware sets at any time must not be written
+  * through the alias: the bus still performs a read-modify-write of the
+  * whole word. TIMx->SR flags are rc_w0 (cleared by writing 0), so a flag
+  * that gets set between the read and the write is written back as 0 and
+  * silently lost. Clear them with a plain store that has 1 in every other
+  * bit, e.g. TIMx->SR = ~TIM_SR_UIF.
+  ******************************************************************************
+  */
+
+#ifndef __BITBAND_H
+#define __BITBAND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+
+/* Alias region base addresses */
+#define BITBAND_SRAM_BASE       0x22000000UL
+#define BITBAND_PERI_BASE       0x42000000UL
+
+/* Alias word address for bit 'bit' of the byte at 'addr' */
+#define BITBAND_SRAM_ADDR(addr, bit) \
+    (BITBAND_SRAM_BASE + (((uint32_t)(addr) - SRAM_BASE) << 5) + ((uint32_t)(bit) << 2))
+#define BITBAND_PERI_ADDR(addr, bit) \
+    (BITBAND_PERI_BASE + (((uint32_t)(addr) - PERIPH_BASE) << 5) + ((uint32_t)(bit) << 2))
+
+/* Alias word as an lvalue: 'reg' is a register or variable, not a pointer */
+#define BITBAND_SRAM(reg, bit)  (*(volatile uint32_t *)BITBAND_SRAM_ADDR(&(reg), bit))
+#define BITBAND_PERI(reg, bit)  (*(volatile uint32_t *)BITBAND_PERI_ADDR(&(reg), bit))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BITBAND_H */
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    boot.h
+  * @brief   Boot time checkpoints based on the DWT cycle counter
+  ******************************************************************************
+  * The startup code enables DWT->CYCCNT as its first action after reset,
+  * so the counter holds the cycles since reset. It stores the count after
+  * SystemInit() in boot_clock_cycles (the "clock" checkpoint); everything
+  * before ran on the 8 MHz HSI. The application marks further points:
+  *
+  *   BOOT_CHECKPOINT("drivers");
+  *   ...
+  *   Boot_Print(USART1);       // time since reset and delta per checkpoint
+  *
+  * Sched_Run() marks "sched_run", the start of the first main loop
+  * iteration. Each checkpoint keeps SystemCoreClock, so an interval is
+  * converted with the clock of its end point; an interval that contains
+  * a Clock_SetSysclk() is approximate. CYCCNT stops while the core sleeps
+  * (WFI) and wraps after 59 s at 72 MHz, so checkpoints belong to the
+  * boot path, not to the running application.
+  *
+  * BOOT_TIMING_ENABLE 0 in config.h compiles the checkpoints out.
+  ******************************************************************************
+  */
+
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "config.h"
+
+#ifndef BOOT_TIMING_ENABLE
+#define BOOT_TIMING_ENABLE      0
+#endif
+
+#ifndef BOOT_MAX_CHECKPOINTS
+#define BOOT_MAX_CHECKPOINTS    12
+#endif
+
+/* One checkpoint */
+typedef struct
+{
+    const char *name;
+    uint32_t cycles;            /* DWT->CYCCNT, cycles since reset */
+    uint32_t hz;                /* SystemCoreClock when it was taken */
+} Boot_Checkpoint_t;
+
+/* CYCCNT after SystemInit(), written by the startup code */
+extern uint32_t boot_clock_cycles;
+
+/* Function prototypes */
+void Boot_Checkpoint(const char *name);
+uint32_t Boot_GetCount(void);
+uint32_t Boot_GetUs(uint32_t index);
+void Boot_Print(USART_TypeDef *USARTx);
+
+#if BOOT_TIMING_ENABLE
+#define BOOT_CHECKPOINT(name)   Boot_Checkpoint(name)
+#else
+#define BOOT_CHECKPOINT(name)   ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H */
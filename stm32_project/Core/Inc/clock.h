@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    clock.h
+  * @brief   Clock tree configuration and change notifications
+  ******************************************************************************
+  * Clock_SetSysclk() picks the oscillator, PLL multiplier and AHB divider
+  * for a core clock, sets APB1 to at most 36 MHz, APB2 to HCLK, the ADC
+  * prescaler to at most 14 MHz and the flash wait states. The HSE crystal
+  * (HSE_FREQ in config.h) is preferred; if it does not start, the same
+  * request is served from the HSI where possible, otherwise the nearest
+  * lower HSI frequency is used and ERROR is returned.
+  *
+  * Drivers register a notifier once and re-derive their dividers when the
+  * clock changes (delay, uart, pwm/timers, i2c, monitor do). Notifiers run
+  * in registration order, so the delay clock, registered by Delay_Init(),
+  * is already rescaled when the others run. Both events are sent with
+  * interrupts disabled:
+  *   CLOCK_EVENT_PRE   before the switch; freq holds the planned clocks
+  *   CLOCK_EVENT_POST  after the switch; freq holds the actual clocks
+  *
+  *   Clock_SetSysclk(48000000);          // USB needs 48 MHz from the PLL
+  *   Clock_SetSysclk(8000000);           // HSE without PLL, saves power
+  *
+  * Cycle-based statistics (sched, profile, monitor histograms) keep the
+  * unit of the clock they were taken at; reset them after a change.
+  ******************************************************************************
+  */
+
+#ifndef __CLOCK_H
+#define __CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+
+/* Internal RC oscillator */
+#define CLOCK_HSI_FREQ          8000000UL
+
+/* Highest SYSCLK / HCLK / PCLK2, and highest PCLK1 */
+#define CLOCK_SYSCLK_MAX        72000000UL
+#define CLOCK_PCLK1_MAX         36000000UL
+
+/* Highest ADC clock */
+#define CLOCK_ADC_MAX           14000000UL
+
+typedef enum
+{
+    CLOCK_SOURCE_HSI = 0,       /* 8 MHz RC */
+    CLOCK_SOURCE_HSE,           /* Crystal */
+    CLOCK_SOURCE_PLL_HSI,       /* PLL from HSI / 2 (max 64 MHz) */
+    CLOCK_SOURCE_PLL_HSE        /* PLL from HSE */
+} Clock_Source_t;
+
+/* Clock tree frequencies (Hz) */
+typedef struct
+{
+    uint32_t sysclk;
+    uint32_t hclk;              /* Core, AHB, SysTick, DWT (= SystemCoreClock) */
+    uint32_t pclk1;             /* APB1: USART2, I2C */
+    uint32_t pclk2;             /* APB2: USART1, ADC, GPIO */
+    uint32_t tim_apb1;          /* TIM2-TIM4 (2 x PCLK1 if APB1 is divided) */
+    uint32_t tim_apb2;          /* TIM1 */
+    uint32_t adcclk;
+    uint8_t source;             /* Clock_Source_t */
+    uint8_t hse_failed;         /* 1 = the last HSE start timed out */
+} Clock_Freq_t;
+
+typedef enum
+{
+    CLOCK_EVENT_PRE = 0,
+    CLOCK_EVENT_POST
+} Clock_Event_t;
+
+typedef void (*Clock_Callback_t)(Clock_Event_t event, const Clock_Freq_t *freq, void *arg);
+
+/* Change notifier (caller-owned, registered once) */
+typedef struct Clock_Notifier
+{
+    struct Clock_Notifier *next;
+    Clock_Callback_t callback;
+    void *arg;
+} Clock_Notifier_t;
+
+/* Function prototypes */
+ErrorStatus Clock_SetSysclk(uint32_t hz);
+void Clock_GetFreq(Clock_Freq_t *freq);
+void Clock_Register(Clock_Notifier_t *notifier, Clock_Callback_t callback, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CLOCK_H */
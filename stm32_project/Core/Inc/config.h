@@ -47,15 +47,17 @@ extern "C" {
 
 /* LED 配置 */
 #define LED_PIN                 GPIO_PIN_13
+#define LED_PIN_NUM             13      /* 引脚序号, 位带访问用 */
 #define LED_PORT                GPIOC
 #define LED_ON()                GPIO_WritePin(LED_PORT, LED_PIN, GPIO_PIN_RESET)
 #define LED_OFF()               GPIO_WritePin(LED_PORT, LED_PIN, GPIO_PIN_SET)
-#define LED_TOGGLE()            GPIO_TogglePin(LED_PORT, LED_PIN)
+#define LED_TOGGLE()            (GPIO_PIN_OUT(LED_PORT, LED_PIN_NUM) ^= 1)
 
 /* 按键配置 (示例 - 如果使用) */
 #define BUTTON_PIN              GPIO_PIN_0
+#define BUTTON_PIN_NUM          0
 #define BUTTON_PORT             GPIOA
-#define BUTTON_READ()           GPIO_ReadPin(BUTTON_PORT, BUTTON_PIN)
+#define BUTTON_READ()           ((GPIO_PinState)GPIO_PIN_IN(BUTTON_PORT, BUTTON_PIN_NUM))
 
 /*============================================================================*/
 /* 定时器配置                                                                  */
@@ -81,6 +83,69 @@ extern "C" {
     #define DEBUG_PRINT(fmt, ...)
 #endif
 
+/*============================================================================*/
+/* 性能分析配置                                                                */
+/*============================================================================*/
+
+/* 1 = 启用 DWT 计时区 (profile.h), 0 = 计时代码全部编译掉 */
+#define PROFILE_ENABLE          DEBUG_ENABLE
+
+/* 计时区数量 (内置区 + 用户区) */
+#define PROFILE_MAX_ZONES       16
+
+/*============================================================================*/
+/* 运行监控配置                                                                */
+/*============================================================================*/
+
+/* 1 = 统计 CPU 负载、中断延迟/抖动和主循环最长执行时间 (monitor.h) */
+#define MONITOR_ENABLE          1
+
+/* 中断源数量 (SysTick + 用户中断) */
+#define MONITOR_SOURCES         4
+
+/* CPU 负载统计窗口 (ms) */
+#define MONITOR_WINDOW_MS       1000
+
+/*============================================================================*/
+/* 内存统计配置                                                                */
+/*============================================================================*/
+
+/* 1 = SysTick 中检查各栈底的保护字 (memstat.h), 0 = 只在查询时统计 */
+#define MEMSTAT_GUARD_CHECK     1
+
+/* 每个栈底的保护字数量 (每字 4 字节) */
+#define MEMSTAT_GUARD_WORDS     4
+
+/*============================================================================*/
+/* RAM 代码配置                                                                */
+/*============================================================================*/
+
+/* 1 = RAMFUNC 标记的中断热路径在 SRAM 中执行 (ramfunc.h), 0 = 全部在 Flash */
+#define RAMFUNC_ENABLE          1
+
+/*============================================================================*/
+/* 启动时间配置                                                                */
+/*============================================================================*/
+
+/* 1 = 记录启动检查点 (boot.h), 0 = BOOT_CHECKPOINT() 编译掉 */
+#define BOOT_TIMING_ENABLE      1
+
+/* 启动检查点数量 (不含 "clock") */
+#define BOOT_MAX_CHECKPOINTS    12
+
+/*============================================================================*/
+/* 故障记录配置                                                                */
+/*============================================================================*/
+
+/* 1 = 记录故障后复位 (fault.h), 0 = 停在故障处理函数中等待调试器 */
+#define FAULT_RESET             1
+
+/* 记录的调用栈深度 (疑似返回地址个数) */
+#define FAULT_STACK_DEPTH       8
+
+/* 从故障栈帧向上最多扫描的字数 */
+#define FAULT_SCAN_WORDS        256
+
 /*============================================================================*/
 /* 应用配置                                                                    */
 /*============================================================================*/
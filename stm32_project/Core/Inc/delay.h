@@ -3,6 +3,12 @@
   * @file    delay.h
   * @brief   Delay functions header file
   ******************************************************************************
+  * Time base: SysTick interrupts every millisecond and its down-counter
+  * extends to a 64-bit cycle clock (Delay_GetTimestamp) that keeps running
+  * while the core sleeps. Delay_Ms() and Delay_Idle() sleep with WFI; with
+  * DELAY_TICKLESS enabled SysTick is reprogrammed to skip the ticks in which
+  * no software timer expires, so an idle system wakes only when needed.
+  ******************************************************************************
   */
 
 #ifndef __DELAY_H
@@ -13,16 +19,77 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include "stm32f1xx.h"
+
+/* 1 = skip idle SysTick interrupts while sleeping, 0 = WFI between ticks */
+#ifndef DELAY_TICKLESS
+#define DELAY_TICKLESS          1
+#endif
+
+/* Sleep statistics, see Delay_GetIdleStats() */
+typedef struct
+{
+    uint64_t sleep_cycles;      /* Time spent in WFI (core clock cycles) */
+    uint32_t sleeps;            /* WFI entries */
+    uint32_t tickless;          /* Entries that skipped at least one tick */
+    uint32_t early_wakes;       /* Tickless sleeps ended by another interrupt */
+    uint32_t wake_latency_max;  /* Cycles from SysTick wakeup to its handler */
+    uint32_t wake_latency_last;
+} Delay_IdleStats_t;
 
 /* Function prototypes */
 void Delay_Init(void);
 void Delay_Ms(uint32_t ms);
 void Delay_Us(uint32_t us);
+void Delay_Ns(uint32_t ns);
 uint32_t GetTick(void);
+uint64_t Delay_GetTick64(void);
+
+/* Low-power idle */
+void Delay_Idle(void);
+void Delay_GetIdleStats(Delay_IdleStats_t *stats);
+void Delay_ResetIdleStats(void);
+
+/* 64-bit monotonic clock (SysTick, keeps counting in sleep) */
+uint64_t Delay_GetTimestamp(void);
+uint64_t Delay_GetMicros(void);
+uint32_t Delay_CyclesToUs(uint32_t cycles);
+uint32_t Delay_CyclesToNs(uint32_t cycles);
+uint64_t Delay_TimestampToUs(uint64_t timestamp);
+
+/* Short intervals: DWT cycle counter, stops while the core sleeps */
+
+/**
+  * @brief  Read the 32-bit cycle counter (wraps every 2^32 / SystemCoreClock s)
+  * @retval Core clock cycles
+  */
+static inline uint32_t Delay_GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+  * @brief  Cycles elapsed since a Delay_GetCycles() value (wrap-safe)
+  * @param  start: Earlier Delay_GetCycles() value
+  * @retval Elapsed core clock cycles
+  */
+static inline uint32_t Delay_ElapsedCycles(uint32_t start)
+{
+    return DWT->CYCCNT - start;
+}
+
+/**
+  * @brief  Microseconds elapsed since a Delay_GetCycles() value
+  * @param  start: Earlier Delay_GetCycles() value
+  * @retval Elapsed time in microseconds
+  */
+static inline uint32_t Delay_ElapsedUs(uint32_t start)
+{
+    return Delay_CyclesToUs(DWT->CYCCNT - start);
+}
 
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* __DELAY_H */
-
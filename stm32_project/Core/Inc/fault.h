@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    fault.h
+  * @brief   Fault handlers with a crash record that survives the reset
+  ******************************************************************************
+  * HardFault, MemManage, BusFault and UsageFault all enter one handler. It
+  * switches to its own small stack, so a fault caused by a stack overflow
+  * can still be recorded, and saves into the .noinit RAM section (not
+  * cleared or painted by the startup code):
+  *   - the exception frame: r0-r3, r12, lr, pc, xpsr and the stack pointer
+  *   - CFSR, HFSR, MMFAR, BFAR
+  *   - up to FAULT_STACK_DEPTH words above the frame that look like return
+  *     addresses (odd values inside the code in flash or .ramfunc)
+  * With FAULT_RESET it then resets the MCU. After the reset the record is
+  * still there, guarded by a magic word and a checksum:
+  *
+  *   Fault_Init();                     // enable the configurable faults
+  *   UART_Init(USART1, 115200);
+  *   if(Fault_Pending())
+  *   {
+  *       Fault_Print(USART1);          // once per fault
+  *   }
+  *
+  * tools/fault_decode.py reads the dump from the port or a log file and
+  * resolves the addresses against the ELF with arm-none-eabi-addr2line.
+  * The call stack is a heuristic scan: it can show stale return addresses
+  * and misses frames of functions that never spilled lr.
+  ******************************************************************************
+  */
+
+#ifndef __FAULT_H
+#define __FAULT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "config.h"
+
+#ifndef FAULT_RESET
+#define FAULT_RESET             1
+#endif
+
+#ifndef FAULT_STACK_DEPTH
+#define FAULT_STACK_DEPTH       8
+#endif
+
+#ifndef FAULT_SCAN_WORDS
+#define FAULT_SCAN_WORDS        256
+#endif
+
+/* Record flags */
+#define FAULT_FLAG_PSP          0x01    /* Faulted on a thread stack (PSP) */
+#define FAULT_FLAG_BAD_SP       0x02    /* Stack pointer outside RAM, no frame */
+#define FAULT_FLAG_REPORTED     0x04    /* Fault_Print() has shown it */
+
+/* Crash record, kept in .noinit */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t count;             /* Faults since power-on */
+    uint32_t exception;         /* 3 HardFault, 4 MemManage, 5 BusFault, 6 UsageFault */
+    uint32_t flags;
+    uint32_t r0;
+    uint32_t r1;
+    uint32_t r2;
+    uint32_t r3;
+    uint32_t r12;
+    uint32_t lr;
+    uint32_t pc;
+    uint32_t xpsr;
+    uint32_t sp;                /* Stack pointer before the exception */
+    uint32_t exc_return;
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint32_t depth;             /* Valid entries in stack[] */
+    uint32_t stack[FAULT_STACK_DEPTH];
+    uint32_t checksum;
+} Fault_Record_t;
+
+/* Function prototypes */
+void Fault_Init(void);
+uint8_t Fault_GetRecord(Fault_Record_t *record);
+uint8_t Fault_Pending(void);
+void Fault_Print(USART_TypeDef *USARTx);
+void Fault_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FAULT_H */
@@ -13,6 +13,7 @@ extern "C" {
 #endif
 
 #include "stm32f1xx.h"
+#include "bitband.h"
 
 /* GPIO Mode definitions */
 #define GPIO_MODE_INPUT         0x0
@@ -48,6 +49,57 @@ extern "C" {
 #define GPIO_PIN_14             ((uint16_t)0x4000)
 #define GPIO_PIN_15             ((uint16_t)0x8000)
 
+/* 4-bit CRL/CRH field value for one pin */
+#define GPIO_CFG(Mode, CNF)     (((CNF) << 2) | (Mode))
+
+/*
+ * Compile-time pin descriptors
+ *
+ * CRL (pins 0-7) and CRH (pins 8-15) are treated as one 64-bit word holding a
+ * 4-bit field per pin. The macros below expand a GPIO_PIN_x bitmask into the
+ * field mask and field value at compile time, so a whole port is configured
+ * with one masked CRL write and one masked CRH write and no bit scanning:
+ *
+ *   static const GPIO_PortConfig_t adc_pins =
+ *       GPIO_PORT_CONFIG(GPIOA, GPIO_CR_MASK(0x00FF),
+ *                        GPIO_CR_VALUE(0x00FF, GPIO_MODE_INPUT, GPIO_CNF_INPUT_ANALOG));
+ *   GPIO_InitPort(&adc_pins);
+ *
+ * Pin groups with different modes on the same port are combined by OR-ing
+ * their masks and values.
+ */
+#define GPIO_CR_FIELD(pins, n)  ((((pins) >> (n)) & 1) ? (0xFULL << ((n) * 4)) : 0)
+#define GPIO_CR_MASK(pins)                                                          \
+    (GPIO_CR_FIELD(pins, 0)  | GPIO_CR_FIELD(pins, 1)  | GPIO_CR_FIELD(pins, 2)  |  \
+     GPIO_CR_FIELD(pins, 3)  | GPIO_CR_FIELD(pins, 4)  | GPIO_CR_FIELD(pins, 5)  |  \
+     GPIO_CR_FIELD(pins, 6)  | GPIO_CR_FIELD(pins, 7)  | GPIO_CR_FIELD(pins, 8)  |  \
+     GPIO_CR_FIELD(pins, 9)  | GPIO_CR_FIELD(pins, 10) | GPIO_CR_FIELD(pins, 11) |  \
+     GPIO_CR_FIELD(pins, 12) | GPIO_CR_FIELD(pins, 13) | GPIO_CR_FIELD(pins, 14) |  \
+     GPIO_CR_FIELD(pins, 15))
+#define GPIO_CR_VALUE(pins, Mode, CNF) \
+    (GPIO_CR_MASK(pins) & (0x1111111111111111ULL * GPIO_CFG(Mode, CNF)))
+
+/* Precomputed port configuration (see GPIO_PORT_CONFIG) */
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint32_t crl_mask;
+    uint32_t crl;
+    uint32_t crh_mask;
+    uint32_t crh;
+} GPIO_PortConfig_t;
+
+#define GPIO_PORT_CONFIG(GPIOx, mask, value)                          \
+    { (GPIOx), (uint32_t)(mask), (uint32_t)(value),                   \
+      (uint32_t)((mask) >> 32), (uint32_t)((value) >> 32) }
+
+/* Single-pin access through the bit-band alias (n = pin index 0-15).
+ * Reads return 0/1, writes change only that pin and cannot race with ISRs:
+ *   GPIO_PIN_OUT(GPIOC, 13) ^= 1;
+ *   if(GPIO_PIN_IN(GPIOA, 0)) ... */
+#define GPIO_PIN_OUT(GPIOx, n)  BITBAND_PERI((GPIOx)->ODR, n)
+#define GPIO_PIN_IN(GPIOx, n)   BITBAND_PERI((GPIOx)->IDR, n)
+
 /* GPIO Pin State */
 typedef enum
 {
@@ -57,6 +109,7 @@ typedef enum
 
 /* Function prototypes */
 void GPIO_Init(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint32_t Mode, uint32_t CNF);
+void GPIO_InitPort(const GPIO_PortConfig_t *config);
 void GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
 void GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
 GPIO_PinState GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
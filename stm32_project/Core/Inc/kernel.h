@@ -0,0 +1,144 @@
+/**
+  ******************************************************************************
+  * @file    kernel.h
+  * @brief   Minimal preemptive kernel: threads, mutexes, semaphores, queues
+  ******************************************************************************
+  * Fixed-priority preemptive scheduling (0 = highest, FIFO among equal
+  * priorities, no time slicing). Each thread runs on its own PSP stack;
+  * PendSV switches context, SVC starts the first thread. Interrupts keep
+  * using the main stack.
+  *
+  * Sleeps and wait timeouts are software timers (swtimer.h), so they share
+  * the SysTick time base and tickless idle. The idle thread runs
+  * SWTIMER_DEFERRED callbacks and sleeps in Delay_Idle().
+  *
+  *   static Kernel_Thread_t ctrl;
+  *   static uint32_t ctrl_stack[128];
+  *   Kernel_ThreadCreate(&ctrl, "ctrl", Control_Loop, NULL, 1,
+  *                       ctrl_stack, sizeof(ctrl_stack));
+  *   Kernel_Start();                       // never returns
+  *
+  * Semaphore gives and queue sends with timeout 0 may be used from
+  * interrupts; everything else is for threads only.
+  ******************************************************************************
+  */
+
+#ifndef __KERNEL_H
+#define __KERNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "swtimer.h"
+
+/* Priority levels: 0 = highest, KERNEL_PRIORITIES - 1 = idle */
+#define KERNEL_PRIORITIES       8
+
+/* Idle thread stack (words); it also runs SWTIMER_DEFERRED callbacks */
+#define KERNEL_IDLE_STACK       128
+
+/* Timeout values (ms) */
+#define KERNEL_NO_WAIT          0UL
+#define KERNEL_WAIT_FOREVER     0xFFFFFFFFUL
+
+#if KERNEL_PRIORITIES > 32
+#error "KERNEL_PRIORITIES must not exceed 32"
+#endif
+
+/* Result of blocking calls */
+typedef enum
+{
+    KERNEL_OK = 0,
+    KERNEL_TIMEOUT,             /* Not available within the timeout */
+    KERNEL_ERROR                /* Invalid use, e.g. unlocking a mutex not owned */
+} Kernel_Status_t;
+
+typedef enum
+{
+    KERNEL_READY = 0,           /* Running or runnable */
+    KERNEL_BLOCKED,             /* Sleeping or waiting on an object */
+    KERNEL_EXITED               /* Entry function returned */
+} Kernel_State_t;
+
+typedef void (*Kernel_Entry_t)(void *arg);
+
+struct Kernel_Mutex;
+
+/* Thread object (fields are managed by kernel.c) */
+typedef struct Kernel_Thread
+{
+    uint32_t *sp;               /* Saved PSP, must stay first (PendSV) */
+    struct Kernel_Thread *next; /* Ready list or wait list */
+    struct Kernel_Thread *link; /* All created threads, see Kernel_GetThreads() */
+    struct Kernel_Thread **wait_list;   /* List blocked on, NULL if none */
+    struct Kernel_Mutex *blocked_on;    /* Mutex waited for (inheritance chain) */
+    struct Kernel_Mutex *held;          /* Mutexes owned */
+    const char *name;
+    uint32_t *stack;            /* Lowest stack address */
+    uint32_t stack_size;        /* Bytes */
+    void *msg;                  /* Queue item being transferred */
+    SwTimer_t timer;            /* Sleep and wait timeout */
+    uint32_t switches;          /* Times switched in */
+    uint8_t priority;           /* Effective priority */
+    uint8_t base_priority;      /* Priority without inheritance */
+    uint8_t state;              /* Kernel_State_t */
+    uint8_t result;             /* Kernel_Status_t of the last wait */
+} Kernel_Thread_t;
+
+/* Non-recursive mutex with priority inheritance */
+typedef struct Kernel_Mutex
+{
+    Kernel_Thread_t *owner;
+    Kernel_Thread_t *waiters;   /* Highest priority first */
+    struct Kernel_Mutex *next_held;
+} Kernel_Mutex_t;
+
+/* Counting semaphore */
+typedef struct
+{
+    uint32_t count;
+    uint32_t max;
+    Kernel_Thread_t *waiters;
+} Kernel_Sem_t;
+
+/* Message queue of fixed-size items copied in and out */
+typedef struct
+{
+    uint8_t *buffer;
+    uint16_t item_size;
+    uint16_t length;
+    uint16_t head;
+    uint16_t count;
+    Kernel_Thread_t *senders;
+    Kernel_Thread_t *receivers;
+} Kernel_Queue_t;
+
+/* Function prototypes */
+void Kernel_ThreadCreate(Kernel_Thread_t *thread, const char *name, Kernel_Entry_t entry, void *arg,
+                         uint8_t priority, uint32_t *stack, uint32_t stack_size);
+void Kernel_Start(void);
+Kernel_Thread_t *Kernel_Self(void);
+void Kernel_Yield(void);
+void Kernel_Sleep(uint32_t ms);
+uint32_t Kernel_GetSwitches(void);
+Kernel_Thread_t *Kernel_GetThreads(void);
+
+void Kernel_MutexInit(Kernel_Mutex_t *mutex);
+Kernel_Status_t Kernel_MutexLock(Kernel_Mutex_t *mutex, uint32_t timeout_ms);
+Kernel_Status_t Kernel_MutexUnlock(Kernel_Mutex_t *mutex);
+
+void Kernel_SemInit(Kernel_Sem_t *sem, uint32_t count, uint32_t max);
+Kernel_Status_t Kernel_SemTake(Kernel_Sem_t *sem, uint32_t timeout_ms);
+Kernel_Status_t Kernel_SemGive(Kernel_Sem_t *sem);
+
+void Kernel_QueueInit(Kernel_Queue_t *queue, void *buffer, uint16_t item_size, uint16_t length);
+Kernel_Status_t Kernel_QueueSend(Kernel_Queue_t *queue, const void *item, uint32_t timeout_ms);
+Kernel_Status_t Kernel_QueueReceive(Kernel_Queue_t *queue, void *item, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_H */
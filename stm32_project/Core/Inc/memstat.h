@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file    memstat.h
+  * @brief   Stack and heap usage: painting, high-water marks, guard words
+  ******************************************************************************
+  * The startup code paints all RAM between the end of .bss and the top of
+  * the main stack with MEMSTAT_PAINT before main() runs; the kernel
+  * paints each thread stack when the thread is created. The deepest point
+  * a stack ever reached is the lowest word that no longer holds the
+  * pattern, so high-water marks cost nothing at run time and are found
+  * by scanning on request.
+  *
+  * The heap (newlib malloc) grows through _sbrk(), implemented here: it
+  * records the current and peak break and refuses to grow into the stack
+  * reserved by _Min_Stack_Size in the linker script.
+  *
+  * Each stack keeps MEMSTAT_GUARD_WORDS painted words at its limit. With
+  * MEMSTAT_GUARD_CHECK they are checked on every SysTick interrupt; an
+  * overwritten guard is counted, repainted and reported through
+  * MemStat_OverflowHook(). This catches overflows without an MPU, but only
+  * those that reach the guard, and only after the fact.
+  *
+  *   MemStat_Print(USART1);     // main stack, heap and every thread stack
+  ******************************************************************************
+  */
+
+#ifndef __MEMSTAT_H
+#define __MEMSTAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "config.h"
+
+#ifndef MEMSTAT_GUARD_CHECK
+#define MEMSTAT_GUARD_CHECK     0
+#endif
+
+#ifndef MEMSTAT_GUARD_WORDS
+#define MEMSTAT_GUARD_WORDS     4
+#endif
+
+/* Fill pattern of unused stack (also used in startup_stm32f103xb.s) */
+#define MEMSTAT_PAINT           0xA5A5A5A5UL
+
+/* Stack usage, in bytes */
+typedef struct
+{
+    uint32_t size;              /* Reserved size */
+    uint32_t used;              /* High-water mark */
+    uint8_t guard_ok;           /* 1 = guard words still painted */
+} MemStat_Stack_t;
+
+/* Heap usage (the _sbrk break, not bytes allocated by malloc), in bytes */
+typedef struct
+{
+    uint32_t used;              /* Current break above the end of .bss */
+    uint32_t peak;              /* Highest break */
+    uint32_t limit;             /* Most _sbrk() may hand out */
+    uint32_t failures;          /* Requests refused */
+} MemStat_Heap_t;
+
+/* Function prototypes */
+void MemStat_GetMainStack(MemStat_Stack_t *stack);
+void MemStat_GetStack(const uint32_t *bottom, uint32_t size, MemStat_Stack_t *stack);
+void MemStat_GetHeap(MemStat_Heap_t *heap);
+uint32_t MemStat_GetOverflows(void);
+void MemStat_Paint(uint32_t *bottom, uint32_t size);
+void MemStat_Check(void);
+void MemStat_Print(USART_TypeDef *USARTx);
+void MemStat_OverflowHook(const char *name);
+
+#if MEMSTAT_GUARD_CHECK
+#define MEMSTAT_TICK()          MemStat_Check()
+#else
+#define MEMSTAT_TICK()          ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEMSTAT_H */
@@ -0,0 +1,147 @@
+/**
+  ******************************************************************************
+  * @file    monitor.h
+  * @brief   Runtime monitor: CPU load, interrupt latency/jitter, loop WCET
+  ******************************************************************************
+  * CPU load is the share of time not spent in WFI. Idle time comes from
+  * the sleep accounting in delay.c, so only code that idles through
+  * Delay_Idle()/Delay_Ms() (Sched_Run, the kernel idle thread) counts as
+  * idle; a loop that busy-polls shows 100 %. Load is computed by SysTick
+  * over windows of MONITOR_WINDOW_MS; the last and the peak are kept.
+  *
+  * Interrupt latency is the time from the hardware event to the first
+  * instruction of the handler that records it. SysTick is recorded by
+  * delay.c, the TIM4 LCD refresh (lcd1602.c) and the TIM1 button timer
+  * (exti.c) by their handlers. Other timer update interrupts record
+  * themselves first thing:
+  *
+  *   enum { MON_TIM3 = MONITOR_SRC_USER };
+  *   Monitor_SetName(MON_TIM3, "tim3");
+  *
+  *   void TIM3_IRQHandler(void)
+  *   {
+  *       MONITOR_ISR_ENTRY(MON_TIM3, Monitor_TimerLatency(TIM3));
+  *       ...
+  *   }
+  *
+  * Each source keeps log2 histograms of latency and of jitter (change of
+  * latency from the previous entry). Bin 0 holds values below 16 cycles,
+  * bin k values from 2^(k+3) to 2^(k+4) - 1, the last bin everything above.
+  *
+  * Monitor_LoopMark() at the top of the main loop records the worst busy
+  * time of one iteration (sleep excluded). Sched_Run() calls it.
+  *
+  * MONITOR_ENABLE 0 in config.h removes the hooks and all statistics.
+  ******************************************************************************
+  */
+
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "config.h"
+
+#ifndef MONITOR_ENABLE
+#define MONITOR_ENABLE          0
+#endif
+
+#ifndef MONITOR_SOURCES
+#define MONITOR_SOURCES         4
+#endif
+
+#ifndef MONITOR_WINDOW_MS
+#define MONITOR_WINDOW_MS       1000
+#endif
+
+/* Histogram bins, see the file header */
+#define MONITOR_HIST_BINS       16
+
+/* Interrupt sources; application sources start at MONITOR_SRC_USER */
+enum
+{
+    MONITOR_SRC_SYSTICK = 0,
+    MONITOR_SRC_LCD,            /* TIM4 update, LCD background refresh */
+    MONITOR_SRC_BUTTON,         /* TIM1 update, button debounce */
+    MONITOR_SRC_USER
+};
+
+#if MONITOR_SRC_USER > MONITOR_SOURCES
+#error "MONITOR_SOURCES is smaller than the number of built-in sources"
+#endif
+
+/* Load and main loop statistics */
+typedef struct
+{
+    uint16_t load;              /* Last window, 0.1 % units (1000 = 100 %) */
+    uint16_t load_peak;         /* Highest window since the last reset */
+    uint32_t windows;           /* Completed load windows */
+    uint32_t loop_count;        /* Monitor_LoopMark() iterations */
+    uint32_t loop_max;          /* Longest iteration, busy cycles */
+    uint64_t loop_total;        /* Sum of busy cycles of all iterations */
+} Monitor_Stats_t;
+
+/* Per-interrupt statistics, times in core clock cycles */
+typedef struct
+{
+    const char *name;           /* NULL = unnamed user source */
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t jitter_max;
+    uint32_t last;              /* Latency of the previous entry */
+    uint32_t latency_hist[MONITOR_HIST_BINS];
+    uint32_t jitter_hist[MONITOR_HIST_BINS];
+} Monitor_IsrStats_t;
+
+/**
+  * @brief  Cycles since the update event of an up-counting timer
+  * @param  TIMx: Timer whose update interrupt is being handled
+  * @note   Read first thing in the handler. Resolution is PSC + 1 timer
+  *         clocks; the timer clock equals the core clock at 72 MHz.
+  * @retval Latency in core clock cycles
+  */
+static inline uint32_t Monitor_TimerLatency(TIM_TypeDef *TIMx)
+{
+    return TIMx->CNT * (TIMx->PSC + 1);
+}
+
+#if MONITOR_ENABLE
+
+#define MONITOR_ISR_ENTRY(source, latency)  Monitor_IsrEntry((source), (latency))
+#define MONITOR_TICK(now)                   Monitor_Tick(now)
+
+void Monitor_Init(void);
+void Monitor_IsrEntry(uint8_t source, uint32_t latency);
+void Monitor_Tick(uint64_t now);
+void Monitor_LoopMark(void);
+void Monitor_SetName(uint8_t source, const char *name);
+void Monitor_GetStats(Monitor_Stats_t *stats);
+void Monitor_GetIsrStats(uint8_t source, Monitor_IsrStats_t *stats);
+void Monitor_Reset(void);
+void Monitor_Print(USART_TypeDef *USARTx);
+
+#else
+
+#define MONITOR_ISR_ENTRY(source, latency)  ((void)0)
+#define MONITOR_TICK(now)                   ((void)0)
+
+#define Monitor_Init()                      ((void)0)
+#define Monitor_LoopMark()                  ((void)0)
+#define Monitor_SetName(source, name)       ((void)0)
+#define Monitor_GetStats(stats)             ((void)0)
+#define Monitor_GetIsrStats(source, stats)  ((void)0)
+#define Monitor_Reset()                     ((void)0)
+#define Monitor_Print(USARTx)               ((void)0)
+
+#endif /* MONITOR_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MONITOR_H */
@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    profile.h
+  * @brief   Cycle-accurate profiling zones based on the DWT cycle counter
+  ******************************************************************************
+  * A zone is a slot in a static table that accumulates count, min, max and
+  * total cycles of a code section. PROFILE_SCOPE() times from its position
+  * to the end of the enclosing block, including early returns:
+  *
+  *   enum { ZONE_FILTER = PROFILE_ZONE_USER };
+  *   Profile_SetName(ZONE_FILTER, "filter");
+  *
+  *   void Filter_Run(void)
+  *   {
+  *       PROFILE_SCOPE(ZONE_FILTER);
+  *       ...
+  *   }
+  *
+  *   Profile_Dump(USART1);                 // one line per zone
+  *
+  * Times are inclusive: a zone that calls another zone's function contains
+  * its time, and interrupts that hit inside a zone are counted too. The
+  * counter is DWT->CYCCNT (started by Delay_Init()); it stops while the
+  * core sleeps, so zones must not contain WFI.
+  *
+  * With PROFILE_ENABLE 0 in config.h the macros expand to nothing and the
+  * built-in zones in UART_Printf, ADC_Read, LCD1602_Printf and
+  * PWM_SetDutyCycle cost no code or RAM.
+  ******************************************************************************
+  */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "config.h"
+
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE          0
+#endif
+
+#ifndef PROFILE_MAX_ZONES
+#define PROFILE_MAX_ZONES       16
+#endif
+
+/* Built-in zones; application zones start at PROFILE_ZONE_USER */
+enum
+{
+    PROFILE_ZONE_UART_PRINTF = 0,
+    PROFILE_ZONE_ADC_READ,
+    PROFILE_ZONE_LCD_PRINTF,
+    PROFILE_ZONE_PWM_DUTY,
+    PROFILE_ZONE_USER
+};
+
+#if PROFILE_ZONE_USER > PROFILE_MAX_ZONES
+#error "PROFILE_MAX_ZONES is smaller than the number of built-in zones"
+#endif
+
+/* Zone statistics, times in core clock cycles */
+typedef struct
+{
+    const char *name;           /* NULL = unnamed user zone */
+    uint32_t count;             /* Completed runs */
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;             /* Sum of all runs */
+} Profile_Stats_t;
+
+#if PROFILE_ENABLE
+
+/* Started scope, see PROFILE_SCOPE() */
+typedef struct
+{
+    uint8_t zone;
+    uint32_t start;
+} Profile_Scope_t;
+
+#define PROFILE_CONCAT_(a, b)   a##b
+#define PROFILE_CONCAT(a, b)    PROFILE_CONCAT_(a, b)
+
+/* Time the rest of the enclosing block as the given zone */
+#define PROFILE_SCOPE(zone) \
+    Profile_Scope_t PROFILE_CONCAT(profile_scope_, __LINE__) \
+        __attribute__((cleanup(Profile_ScopeEnd))) = { (zone), DWT->CYCCNT }
+
+void Profile_Init(void);
+void Profile_Record(uint8_t zone, uint32_t cycles);
+void Profile_SetName(uint8_t zone, const char *name);
+void Profile_GetStats(uint8_t zone, Profile_Stats_t *stats);
+void Profile_Reset(void);
+void Profile_Dump(USART_TypeDef *USARTx);
+
+/**
+  * @brief  End of a PROFILE_SCOPE() (called by the compiler on scope exit)
+  * @param  scope: Scope being left
+  * @retval None
+  */
+static inline void Profile_ScopeEnd(Profile_Scope_t *scope)
+{
+    Profile_Record(scope->zone, DWT->CYCCNT - scope->start);
+}
+
+#else
+
+#define PROFILE_SCOPE(zone)     ((void)0)
+
+#define Profile_Init()                  ((void)0)
+#define Profile_Record(zone, cycles)    ((void)0)
+#define Profile_SetName(zone, name)     ((void)0)
+#define Profile_GetStats(zone, stats)   ((void)0)
+#define Profile_Reset()                 ((void)0)
+#define Profile_Dump(USARTx)            ((void)0)
+
+#endif /* PROFILE_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROFILE_H */
@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    ramfunc.h
+  * @brief   Functions executed from SRAM
+  ******************************************************************************
+  * At 72 MHz the flash needs 2 wait states. The prefetch buffer hides them
+  * on straight-line code, but every taken branch refetches from flash.
+  * RAMFUNC puts a function into the .ramfunc section, which the linker
+  * script loads after the code in flash and Reset_Handler copies to SRAM
+  * before SystemInit(); it then runs without wait states:
+  *
+  *   RAMFUNC void TIM2_IRQHandler(void) { ... }
+  *
+  * Keep it for short, branchy interrupt paths:
+  *   - SRAM is scarce (20KB) and instruction fetches from it share the
+  *     system bus with data accesses
+  *   - calls between SRAM and flash are out of BL range; the linker adds
+  *     a veneer of a few cycles
+  *   - constants and string literals stay in flash
+  *
+  * RAMFUNC_ENABLE (config.h) set to 0 leaves everything in flash, so the
+  * interrupt latencies reported by Monitor_Print() can be compared.
+  ******************************************************************************
+  */
+
+#ifndef __RAMFUNC_H
+#define __RAMFUNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "config.h"
+
+#ifndef RAMFUNC_ENABLE
+#define RAMFUNC_ENABLE          1
+#endif
+
+#if RAMFUNC_ENABLE
+#define RAMFUNC                 __attribute__((section(".ramfunc")))
+#else
+#define RAMFUNC
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RAMFUNC_H */
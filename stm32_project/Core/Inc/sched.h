@@ -0,0 +1,98 @@
+/**
+  ******************************************************************************
+  * @file    sched.h
+  * @brief   Cooperative run-to-completion scheduler with priorities
+  ******************************************************************************
+  * Each task is a handler function with its own event queue. Interrupts,
+  * software timers and other tasks post 32-bit events to a task; the main
+  * loop runs the highest-priority task that has an event, one event per
+  * call, so a high-priority task waits at most for one handler to finish.
+  * Tasks of equal priority take turns.
+  *
+  * The queue is lock-free (LDREX/STREX), so posting is safe from any ISR.
+  * Only the post time stamp masks interrupts, for the few cycles it takes
+  * to read the 64-bit clock (Delay_GetTimestamp(); DWT->CYCCNT would stop
+  * in sleep). Each task records run count, execution time and
+  * post-to-completion latency against an optional deadline:
+  *
+  *   static Sched_Task_t adc_task;
+  *   Sched_TaskInit(&adc_task, "adc", Task_ADC, NULL, 1);
+  *   Sched_SetDeadline(&adc_task, 5000);             // 5 ms
+  *   Sched_StartPeriodic(&adc_task, 0, 100, 0);      // event 0 every 100 ms
+  *   Sched_Run();                                    // never returns
+  ******************************************************************************
+  */
+
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+#include "swtimer.h"
+
+/* Events each task can hold (power of 2); further posts are dropped */
+#define SCHED_QUEUE_LEN         8
+
+/* Priority levels: 0 = highest */
+#define SCHED_PRIORITIES        4
+
+#if (SCHED_QUEUE_LEN & (SCHED_QUEUE_LEN - 1)) != 0
+#error "SCHED_QUEUE_LEN must be a power of 2"
+#endif
+
+typedef void (*Sched_Handler_t)(uint32_t event, void *arg);
+
+/* Per-task statistics, times in core clock cycles */
+typedef struct
+{
+    uint32_t runs;              /* Events handled */
+    uint32_t dropped;           /* Posts rejected because the queue was full */
+    uint32_t deadline_misses;   /* Events completed later than the deadline */
+    uint32_t exec_max;          /* Longest handler run */
+    uint32_t latency_max;       /* Longest post-to-completion time */
+    uint64_t exec_total;        /* Sum of handler run times */
+} Sched_Stats_t;
+
+/* Task object (fields are managed by sched.c) */
+typedef struct Sched_Task
+{
+    struct Sched_Task *next;    /* Run list, sorted by priority */
+    const char *name;
+    Sched_Handler_t handler;
+    void *arg;
+    uint8_t priority;
+    uint32_t deadline;          /* Cycles from post to completion, 0 = none */
+
+    /* Multi-producer, single-consumer event queue */
+    volatile uint32_t head;     /* Next slot to reserve (producers) */
+    volatile uint32_t tail;     /* Next slot to run (main loop) */
+    volatile uint32_t event[SCHED_QUEUE_LEN];
+    volatile uint32_t stamp[SCHED_QUEUE_LEN];
+    volatile uint8_t valid[SCHED_QUEUE_LEN];
+
+    SwTimer_t timer;            /* Sched_StartPeriodic() */
+    uint32_t timer_event;
+
+    Sched_Stats_t stats;
+} Sched_Task_t;
+
+/* Function prototypes */
+void Sched_TaskInit(Sched_Task_t *task, const char *name, Sched_Handler_t handler,
+                    void *arg, uint8_t priority);
+void Sched_SetDeadline(Sched_Task_t *task, uint32_t deadline_us);
+ErrorStatus Sched_Post(Sched_Task_t *task, uint32_t event);
+void Sched_StartPeriodic(Sched_Task_t *task, uint32_t delay_ms, uint32_t period_ms, uint32_t event);
+void Sched_StopPeriodic(Sched_Task_t *task);
+uint8_t Sched_RunOne(void);
+void Sched_Run(void);
+void Sched_GetStats(Sched_Task_t *task, Sched_Stats_t *stats);
+void Sched_ResetStats(Sched_Task_t *task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCHED_H */
@@ -171,6 +171,91 @@ typedef struct
   volatile uint32_t DMAR;
 } TIM_TypeDef;
 
+/** 
+  * @brief Inter-integrated Circuit Interface
+  */
+typedef struct
+{
+  volatile uint32_t CR1;
+  volatile uint32_t CR2;
+  volatile uint32_t OAR1;
+  volatile uint32_t OAR2;
+  volatile uint32_t DR;
+  volatile uint32_t SR1;
+  volatile uint32_t SR2;
+  volatile uint32_t CCR;
+  volatile uint32_t TRISE;
+} I2C_TypeDef;
+
+/** 
+  * @brief DMA Controller
+  */
+typedef struct
+{
+  volatile uint32_t CCR;
+  volatile uint32_t CNDTR;
+  volatile uint32_t CPAR;
+  volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t ISR;
+  volatile uint32_t IFCR;
+} DMA_TypeDef;
+
+/** 
+  * @brief Alternate Function I/O
+  */
+typedef struct
+{
+  volatile uint32_t EVCR;
+  volatile uint32_t MAPR;
+  volatile uint32_t EXTICR[4];
+  uint32_t RESERVED0;
+  volatile uint32_t MAPR2;
+} AFIO_TypeDef;
+
+/** 
+  * @brief External Interrupt/Event Controller
+  */
+typedef struct
+{
+  volatile uint32_t IMR;
+  volatile uint32_t EMR;
+  volatile uint32_t RTSR;
+  volatile uint32_t FTSR;
+  volatile uint32_t SWIER;
+  volatile uint32_t PR;
+} EXTI_TypeDef;
+
+/** 
+  * @brief Analog to Digital Converter
+  */
+typedef struct
+{
+  volatile uint32_t SR;
+  volatile uint32_t CR1;
+  volatile uint32_t CR2;
+  volatile uint32_t SMPR1;
+  volatile uint32_t SMPR2;
+  volatile uint32_t JOFR1;
+  volatile uint32_t JOFR2;
+  volatile uint32_t JOFR3;
+  volatile uint32_t JOFR4;
+  volatile uint32_t HTR;
+  volatile uint32_t LTR;
+  volatile uint32_t SQR1;
+  volatile uint32_t SQR2;
+  volatile uint32_t SQR3;
+  volatile uint32_t JSQR;
+  volatile uint32_t JDR1;
+  volatile uint32_t JDR2;
+  volatile uint32_t JDR3;
+  volatile uint32_t JDR4;
+  volatile uint32_t DR;
+} ADC_TypeDef;
+
 /**
   * @}
   */
@@ -186,14 +271,29 @@ typedef struct
 #define APB2PERIPH_BASE       (PERIPH_BASE + 0x00010000UL)
 #define AHBPERIPH_BASE        (PERIPH_BASE + 0x00020000UL)
 
+#define AFIO_BASE             (APB2PERIPH_BASE + 0x00000000UL)
+#define EXTI_BASE             (APB2PERIPH_BASE + 0x00000400UL)
 #define GPIOA_BASE            (APB2PERIPH_BASE + 0x00000800UL)
 #define GPIOB_BASE            (APB2PERIPH_BASE + 0x00000C00UL)
 #define GPIOC_BASE            (APB2PERIPH_BASE + 0x00001000UL)
 #define RCC_BASE              (AHBPERIPH_BASE + 0x00001000UL)
+#define ADC1_BASE             (APB2PERIPH_BASE + 0x00002400UL)
+#define TIM1_BASE             (APB2PERIPH_BASE + 0x00002C00UL)
 #define USART1_BASE           (APB2PERIPH_BASE + 0x00003800UL)
 #define USART2_BASE           (APB1PERIPH_BASE + 0x00004400UL)
 #define TIM2_BASE             (APB1PERIPH_BASE + 0x00000000UL)
 #define TIM3_BASE             (APB1PERIPH_BASE + 0x00000400UL)
+#define TIM4_BASE             (APB1PERIPH_BASE + 0x00000800UL)
+#define I2C1_BASE             (APB1PERIPH_BASE + 0x00005400UL)
+#define I2C2_BASE             (APB1PERIPH_BASE + 0x00005800UL)
+#define DMA1_BASE             (AHBPERIPH_BASE + 0x00000000UL)
+#define DMA1_Channel1_BASE    (AHBPERIPH_BASE + 0x00000008UL)
+#define DMA1_Channel2_BASE    (AHBPERIPH_BASE + 0x0000001CUL)
+#define DMA1_Channel3_BASE    (AHBPERIPH_BASE + 0x00000030UL)
+#define DMA1_Channel4_BASE    (AHBPERIPH_BASE + 0x00000044UL)
+#define DMA1_Channel5_BASE    (AHBPERIPH_BASE + 0x00000058UL)
+#define DMA1_Channel6_BASE    (AHBPERIPH_BASE + 0x0000006CUL)
+#define DMA1_Channel7_BASE    (AHBPERIPH_BASE + 0x00000080UL)
 
 /**
   * @}
@@ -202,14 +302,29 @@ typedef struct
 /** @addtogroup Peripheral_declaration
   * @{
   */  
+#define AFIO                ((AFIO_TypeDef *) AFIO_BASE)
+#define EXTI                ((EXTI_TypeDef *) EXTI_BASE)
 #define GPIOA               ((GPIO_TypeDef *) GPIOA_BASE)
 #define GPIOB               ((GPIO_TypeDef *) GPIOB_BASE)
 #define GPIOC               ((GPIO_TypeDef *) GPIOC_BASE)
 #define RCC                 ((RCC_TypeDef *) RCC_BASE)
+#define ADC1                ((ADC_TypeDef *) ADC1_BASE)
 #define USART1              ((USART_TypeDef *) USART1_BASE)
 #define USART2              ((USART_TypeDef *) USART2_BASE)
+#define TIM1                ((TIM_TypeDef *) TIM1_BASE)
 #define TIM2                ((TIM_TypeDef *) TIM2_BASE)
 #define TIM3                ((TIM_TypeDef *) TIM3_BASE)
+#define TIM4                ((TIM_TypeDef *) TIM4_BASE)
+#define I2C1                ((I2C_TypeDef *) I2C1_BASE)
+#define I2C2                ((I2C_TypeDef *) I2C2_BASE)
+#define DMA1                ((DMA_TypeDef *) DMA1_BASE)
+#define DMA1_Channel1       ((DMA_Channel_TypeDef *) DMA1_Channel1_BASE)
+#define DMA1_Channel2       ((DMA_Channel_TypeDef *) DMA1_Channel2_BASE)
+#define DMA1_Channel3       ((DMA_Channel_TypeDef *) DMA1_Channel3_BASE)
+#define DMA1_Channel4       ((DMA_Channel_TypeDef *) DMA1_Channel4_BASE)
+#define DMA1_Channel5       ((DMA_Channel_TypeDef *) DMA1_Channel5_BASE)
+#define DMA1_Channel6       ((DMA_Channel_TypeDef *) DMA1_Channel6_BASE)
+#define DMA1_Channel7       ((DMA_Channel_TypeDef *) DMA1_Channel7_BASE)
 
 /**
   * @}
@@ -219,16 +334,25 @@ typedef struct
   * @{
   */
 
+/* RCC AHB peripheral clock enable */
+#define RCC_AHBENR_DMA1EN     (0x1UL << 0)
+
 /* RCC APB2 peripheral clock enable */
+#define RCC_APB2ENR_AFIOEN    (0x1UL << 0)
 #define RCC_APB2ENR_IOPAEN    (0x1UL << 2)
 #define RCC_APB2ENR_IOPBEN    (0x1UL << 3)
 #define RCC_APB2ENR_IOPCEN    (0x1UL << 4)
+#define RCC_APB2ENR_ADC1EN    (0x1UL << 9)
+#define RCC_APB2ENR_TIM1EN    (0x1UL << 11)
 #define RCC_APB2ENR_USART1EN  (0x1UL << 14)
 
 /* RCC APB1 peripheral clock enable */
 #define RCC_APB1ENR_TIM2EN    (0x1UL << 0)
 #define RCC_APB1ENR_TIM3EN    (0x1UL << 1)
+#define RCC_APB1ENR_TIM4EN    (0x1UL << 2)
 #define RCC_APB1ENR_USART2EN  (0x1UL << 17)
+#define RCC_APB1ENR_I2C1EN    (0x1UL << 21)
+#define RCC_APB1ENR_I2C2EN    (0x1UL << 22)
 
 /**
   * @}
@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file    swtimer.h
+  * @brief   Software timers on a hierarchical timer wheel driven by SysTick
+  ******************************************************************************
+  * Timers are caller-owned SwTimer_t objects linked into a wheel of
+  * SWTIMER_LEVELS levels with SWTIMER_SLOTS slots each. Level 0 has 1 ms
+  * slots; each higher level covers SWTIMER_SLOTS times the range of the one
+  * below and is cascaded down as time reaches it. Start and stop are O(1)
+  * list operations; each SysTick runs one level-0 slot.
+  *
+  * Callbacks run either in the SysTick interrupt (SWTIMER_ISR) or from
+  * SwTimer_Process() in the main loop (SWTIMER_DEFERRED):
+  *
+  *   static SwTimer_t adc_timer;
+  *   SwTimer_Init(&adc_timer, Sample_ADC, NULL, SWTIMER_DEFERRED);
+  *   SwTimer_Start(&adc_timer, 100, 100);      // every 100 ms
+  *   while(1) { SwTimer_Process(); }
+  ******************************************************************************
+  */
+
+#ifndef __SWTIMER_H
+#define __SWTIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+
+/* Wheel geometry: 4 levels x 32 slots = 2^20 ms (17.5 min) direct range,
+ * 512 bytes of RAM. Longer delays are re-cascaded from the top level. */
+#define SWTIMER_SLOT_BITS       5
+#define SWTIMER_LEVELS          4
+
+#define SWTIMER_SLOTS           (1UL << SWTIMER_SLOT_BITS)
+
+/* SwTimer_NextExpiry() result when no timer is running */
+#define SWTIMER_NO_EXPIRY       0xFFFFFFFFUL
+
+/* Where the callback runs */
+typedef enum
+{
+    SWTIMER_ISR = 0,            /* In SysTick_Handler: keep it short */
+    SWTIMER_DEFERRED            /* In SwTimer_Process(), main loop context */
+} SwTimer_Mode_t;
+
+typedef void (*SwTimer_Callback_t)(void *arg);
+
+/* Timer object (fields are managed by swtimer.c; the application may read missed) */
+typedef struct SwTimer
+{
+    struct SwTimer *next;       /* Wheel slot list */
+    struct SwTimer **pprev;     /* NULL when not in the wheel */
+    struct SwTimer *pend_next;  /* Deferred pending list */
+    struct SwTimer **pend_pprev;/* NULL when not pending */
+    uint32_t expires;           /* Absolute tick */
+    uint32_t period;            /* 0 = one-shot */
+    SwTimer_Callback_t callback;
+    void *arg;
+    SwTimer_Mode_t mode;
+    uint16_t missed;            /* Deferred expiries merged while pending */
+} SwTimer_t;
+
+/* Function prototypes */
+void SwTimer_Init(SwTimer_t *timer, SwTimer_Callback_t callback, void *arg, SwTimer_Mode_t mode);
+void SwTimer_Start(SwTimer_t *timer, uint32_t delay_ms, uint32_t period_ms);
+void SwTimer_Stop(SwTimer_t *timer);
+uint8_t SwTimer_IsActive(const SwTimer_t *timer);
+void SwTimer_Process(void);
+void SwTimer_Tick(void);
+uint32_t SwTimer_NextExpiry(void);
+uint8_t SwTimer_IsPending(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SWTIMER_H */
@@ -23,6 +23,7 @@ extern "C" {
 #define USART_CR1_UE    (1 << 13) /* USART Enable */
 #define USART_CR1_TE    (1 << 3)  /* Transmitter Enable */
 #define USART_CR1_RE    (1 << 2)  /* Receiver Enable */
+#define USART_CR1_RXNEIE (1 << 5) /* RXNE interrupt enable */
 
 /* Function prototypes */
 void UART_Init(USART_TypeDef *USARTx, uint32_t baudrate);
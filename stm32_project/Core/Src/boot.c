@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    boot.c
+  * @brief   Boot time checkpoints based on the DWT cycle counter
+  ******************************************************************************
+  */
+
+#include "boot.h"
+#include "system_stm32f1xx.h"
+#include "clock.h"
+#include "uart.h"
+
+/* Written by Reset_Handler after .bss is cleared and SystemInit() ran */
+uint32_t boot_clock_cycles;
+
+/* Application checkpoints; "clock" is entry 0 and not stored here */
+static Boot_Checkpoint_t boot_points[BOOT_MAX_CHECKPOINTS];
+static uint32_t boot_count = 0;
+
+/* Private function prototypes */
+static void Boot_Get(uint32_t index, Boot_Checkpoint_t *point);
+
+/**
+  * @brief  Record a checkpoint
+  * @param  name: Static string
+  * @note   Use BOOT_CHECKPOINT() so the call compiles out when disabled.
+  *         Checkpoints beyond BOOT_MAX_CHECKPOINTS are dropped.
+  * @retval None
+  */
+void Boot_Checkpoint(const char *name)
+{
+    uint32_t cycles = DWT->CYCCNT;
+
+    if(boot_count >= BOOT_MAX_CHECKPOINTS)
+    {
+        return;
+    }
+
+    boot_points[boot_count].name = name;
+    boot_points[boot_count].cycles = cycles;
+    boot_points[boot_count].hz = SystemCoreClock;
+    boot_count++;
+}
+
+/**
+  * @brief  Number of checkpoints, including "clock"
+  * @param  None
+  * @retval Count
+  */
+uint32_t Boot_GetCount(void)
+{
+    return boot_count + 1;
+}
+
+/**
+  * @brief  Time from reset to a checkpoint
+  * @param  index: 0 = "clock", 1 = first BOOT_CHECKPOINT(), ...
+  * @note   Each interval is converted with the clock of its end point
+  * @retval Microseconds, 0 if index is out of range
+  */
+uint32_t Boot_GetUs(uint32_t index)
+{
+    Boot_Checkpoint_t point;
+    uint32_t prev = 0;
+    uint64_t us = 0;
+    uint32_t i;
+
+    if(index > boot_count)
+    {
+        return 0;
+    }
+
+    for(i = 0; i <= index; i++)
+    {
+        Boot_Get(i, &point);
+        us += (uint64_t)(point.cycles - prev) * 1000000 / point.hz;
+        prev = point.cycles;
+    }
+
+    return (uint32_t)us;
+}
+
+/**
+  * @brief  Print all checkpoints
+  * @param  USARTx: USART peripheral
+  * @retval None
+  */
+void Boot_Print(USART_TypeDef *USARTx)
+{
+    Boot_Checkpoint_t point;
+    uint32_t prev_us = 0;
+    uint32_t us;
+    uint32_t i;
+
+    UART_Printf(USARTx, "checkpoint      since reset      delta\r\n");
+    for(i = 0; i <= boot_count; i++)
+    {
+        Boot_Get(i, &point);
+        us = Boot_GetUs(i);
+        UART_Printf(USARTx, "%-12s %8lu us %8lu us  (%lu MHz)\r\n",
+                    point.name, us, us - prev_us, point.hz / 1000000);
+        prev_us = us;
+    }
+}
+
+/**
+  * @brief  Checkpoint by index
+  * @param  index: 0 = "clock", 1.. = recorded checkpoints
+  * @param  point: Destination
+  * @retval None
+  */
+static void Boot_Get(uint32_t index, Boot_Checkpoint_t *point)
+{
+    if(index == 0)
+    {
+        /* Reset to the end of SystemInit() ran on the HSI */
+        point->name = "clock";
+        point->cycles = boot_clock_cycles;
+        point->hz = CLOCK_HSI_FREQ;
+        return;
+    }
+
+    *point = boot_points[index - 1];
+}
@@ -0,0 +1,464 @@
+/**
+  ******************************************************************************
+  * @file    clock.c
+  * @brief   Clock tree configuration and change notifications
+  ******************************************************************************
+  */
+
+#include "clock.h"
+#include "config.h"
+#include "system_stm32f1xx.h"
+#include <stddef.h>
+
+/* RCC_CR bits */
+#define RCC_CR_HSION            (1UL << 0)
+#define RCC_CR_HSIRDY           (1UL << 1)
+#define RCC_CR_HSEON            (1UL << 16)
+#define RCC_CR_HSERDY           (1UL << 17)
+#define RCC_CR_PLLON            (1UL << 24)
+#define RCC_CR_PLLRDY           (1UL << 25)
+
+/* RCC_CFGR fields */
+#define RCC_CFGR_SW_Msk         (0x3UL << 0)
+#define RCC_CFGR_SWS_Pos        2
+#define RCC_CFGR_HPRE_Pos       4
+#define RCC_CFGR_PPRE1_Pos      8
+#define RCC_CFGR_PPRE2_Pos      11
+#define RCC_CFGR_ADCPRE_Pos     14
+#define RCC_CFGR_PLLSRC         (1UL << 16)
+#define RCC_CFGR_PLLXTPRE       (1UL << 17)
+#define RCC_CFGR_PLLMUL_Pos     18
+#define RCC_CFGR_USBPRE         (1UL << 22)
+#define RCC_CFGR_BUS_Msk        (0xFFFUL << RCC_CFGR_HPRE_Pos)  /* HPRE, PPRE1, PPRE2, ADCPRE */
+#define RCC_CFGR_PLL_Msk        (0x7FUL << 16)                  /* PLLSRC, PLLXTPRE, PLLMUL, USBPRE */
+
+#define CLOCK_SW_HSI            0
+#define CLOCK_SW_HSE            1
+#define CLOCK_SW_PLL            2
+
+/* FLASH_ACR: wait states and prefetch buffer */
+#define CLOCK_FLASH_ACR         (*(volatile uint32_t *)0x40022000UL)
+#define FLASH_ACR_LATENCY_Msk   0x7UL
+#define FLASH_ACR_PRFTBE        (1UL << 4)
+
+/* Ready-flag polls before giving up (HSE start-up is the slow one) */
+#define CLOCK_TIMEOUT           0x8000UL
+
+/* AHB divider for each HPRE code 1000b .. 1111b */
+static const uint16_t clock_ahb_div[8] = { 2, 4, 8, 16, 64, 128, 256, 512 };
+
+/* Oscillator, PLL and divider choice for one core clock */
+typedef struct
+{
+    uint32_t sysclk;
+    uint32_t hclk;
+    uint8_t source;             /* Clock_Source_t */
+    uint8_t pll_mul;            /* 2..16, 0 = no PLL */
+    uint8_t hpre;               /* HPRE field */
+} Clock_Plan_t;
+
+static Clock_Notifier_t *clock_notifiers = NULL;
+static uint8_t clock_hse_failed = 0;
+
+/* Private function prototypes */
+static void Clock_Plan(uint32_t hz, uint8_t hse, Clock_Plan_t *plan);
+static void Clock_PlanFreq(const Clock_Plan_t *plan, Clock_Freq_t *freq);
+static ErrorStatus Clock_Apply(const Clock_Plan_t *plan, const Clock_Freq_t *freq);
+static uint8_t Clock_WaitFlag(volatile uint32_t *reg, uint32_t mask, uint32_t value);
+static uint32_t Clock_FlashLatency(uint32_t sysclk);
+static uint32_t Clock_AdcDiv(uint32_t pclk2);
+static void Clock_Notify(Clock_Event_t event, const Clock_Freq_t *freq);
+
+/**
+  * @brief  Switch the core clock
+  * @param  hz: HCLK in Hz: HSE or HSI divided by 1..512, or a PLL output
+  *         (multiples of HSE_FREQ or of 4 MHz, up to 72 MHz), optionally
+  *         divided by the AHB prescaler
+  * @note   Blocks with interrupts disabled for the oscillator start-up.
+  *         Notifiers run before and after the switch.
+  * @retval SUCCESS, or ERROR if hz cannot be produced (nothing changed) or
+  *         HSE failed and a lower HSI-based clock is running instead
+  */
+ErrorStatus Clock_SetSysclk(uint32_t hz)
+{
+    Clock_Plan_t hse_plan;
+    Clock_Plan_t hsi_plan;
+    const Clock_Plan_t *plan;
+    Clock_Freq_t freq;
+    ErrorStatus status = SUCCESS;
+    uint32_t primask;
+
+    Clock_Plan(hz, 1, &hse_plan);
+    Clock_Plan(hz, 0, &hsi_plan);
+
+    if(hse_plan.hclk == hz)
+    {
+        plan = &hse_plan;
+    }
+    else if(hsi_plan.hclk == hz)
+    {
+        plan = &hsi_plan;
+    }
+    else
+    {
+        return ERROR;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    Clock_PlanFreq(plan, &freq);
+    Clock_Notify(CLOCK_EVENT_PRE, &freq);
+
+    clock_hse_failed = 0;
+    if(Clock_Apply(plan, &freq) != SUCCESS)
+    {
+        /* HSE or PLL did not start; Clock_Apply() left the core on the HSI */
+        clock_hse_failed = (plan->source == CLOCK_SOURCE_HSE || plan->source == CLOCK_SOURCE_PLL_HSE);
+        Clock_PlanFreq(&hsi_plan, &freq);
+        if(Clock_Apply(&hsi_plan, &freq) != SUCCESS || hsi_plan.hclk != hz)
+        {
+            status = ERROR;
+        }
+    }
+
+    SystemCoreClockUpdate();
+    Clock_GetFreq(&freq);
+    Clock_Notify(CLOCK_EVENT_POST, &freq);
+
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+/**
+  * @brief  Read the current clock tree from the RCC registers
+  * @param  freq: Destination
+  * @retval None
+  */
+void Clock_GetFreq(Clock_Freq_t *freq)
+{
+    uint32_t cfgr = RCC->CFGR;
+    uint32_t sws = (cfgr >> RCC_CFGR_SWS_Pos) & 0x3;
+    uint32_t hpre = (cfgr >> RCC_CFGR_HPRE_Pos) & 0xF;
+    uint32_t ppre1 = (cfgr >> RCC_CFGR_PPRE1_Pos) & 0x7;
+    uint32_t ppre2 = (cfgr >> RCC_CFGR_PPRE2_Pos) & 0x7;
+    uint32_t adcpre = (cfgr >> RCC_CFGR_ADCPRE_Pos) & 0x3;
+    uint32_t mul;
+
+    if(sws == CLOCK_SW_PLL)
+    {
+        mul = ((cfgr >> RCC_CFGR_PLLMUL_Pos) & 0xF) + 2;
+        if(mul > 16)
+        {
+            mul = 16;
+        }
+        if(cfgr & RCC_CFGR_PLLSRC)
+        {
+            freq->source = CLOCK_SOURCE_PLL_HSE;
+            freq->sysclk = ((cfgr & RCC_CFGR_PLLXTPRE) ? HSE_FREQ / 2 : HSE_FREQ) * mul;
+        }
+        else
+        {
+            freq->source = CLOCK_SOURCE_PLL_HSI;
+            freq->sysclk = CLOCK_HSI_FREQ / 2 * mul;
+        }
+    }
+    else if(sws == CLOCK_SW_HSE)
+    {
+        freq->source = CLOCK_SOURCE_HSE;
+        freq->sysclk = HSE_FREQ;
+    }
+    else
+    {
+        freq->source = CLOCK_SOURCE_HSI;
+        freq->sysclk = CLOCK_HSI_FREQ;
+    }
+
+    freq->hclk = (hpre & 0x8) ? freq->sysclk / clock_ahb_div[hpre & 0x7] : freq->sysclk;
+    freq->pclk1 = (ppre1 & 0x4) ? freq->hclk >> ((ppre1 & 0x3) + 1) : freq->hclk;
+    freq->pclk2 = (ppre2 & 0x4) ? freq->hclk >> ((ppre2 & 0x3) + 1) : freq->hclk;
+
+    /* A divided APB clocks its timers at twice its own rate */
+    freq->tim_apb1 = (ppre1 & 0x4) ? freq->pclk1 * 2 : freq->pclk1;
+    freq->tim_apb2 = (ppre2 & 0x4) ? freq->pclk2 * 2 : freq->pclk2;
+    freq->adcclk = freq->pclk2 / ((adcpre + 1) * 2);
+    freq->hse_failed = clock_hse_failed;
+}
+
+/**
+  * @brief  Register a clock change notifier
+  * @param  notifier: Caller-owned, static or long-lived; register it once
+  * @param  callback: Called with interrupts disabled, see clock.h
+  * @param  arg: Passed to the callback
+  * @retval None
+  */
+void Clock_Register(Clock_Notifier_t *notifier, Clock_Callback_t callback, void *arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    Clock_Notifier_t **link;
+
+    notifier->next = NULL;
+    notifier->callback = callback;
+    notifier->arg = arg;
+
+    /* Append: notifiers run in registration order, delay first */
+    __disable_irq();
+    for(link = &clock_notifiers; *link != NULL; link = &(*link)->next)
+    {
+    }
+    *link = notifier;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Find the highest clock not above hz from one oscillator
+  * @param  hz: Requested HCLK
+  * @param  hse: 1 = HSE and PLL from HSE, 0 = HSI and PLL from HSI / 2
+  * @param  plan: Result; plan->hclk == hz for an exact match
+  * @note   Without the PLL is preferred on a tie (lower power)
+  * @retval None
+  */
+static void Clock_Plan(uint32_t hz, uint8_t hse, Clock_Plan_t *plan)
+{
+    uint32_t osc = hse ? HSE_FREQ : CLOCK_HSI_FREQ;
+    uint32_t pll_in = hse ? HSE_FREQ : CLOCK_HSI_FREQ / 2;
+    uint32_t sysclk;
+    uint32_t hclk;
+    uint32_t div;
+    uint8_t mul;
+    uint8_t i;
+
+    /* Replaced by the best match below */
+    plan->sysclk = osc;
+    plan->hclk = 0;
+    plan->source = hse ? CLOCK_SOURCE_HSE : CLOCK_SOURCE_HSI;
+    plan->pll_mul = 0;
+    plan->hpre = 0;
+
+    for(mul = 0; mul <= 16; mul++)
+    {
+        if(mul == 1)
+        {
+            continue;
+        }
+        sysclk = (mul == 0) ? osc : pll_in * mul;
+        if(sysclk > CLOCK_SYSCLK_MAX)
+        {
+            break;
+        }
+
+        for(i = 0; i < 9; i++)
+        {
+            div = (i == 0) ? 1 : clock_ahb_div[i - 1];
+            hclk = sysclk / div;
+            if(hclk <= hz && hclk > plan->hclk && hclk * div == sysclk)
+            {
+                plan->sysclk = sysclk;
+                plan->hclk = hclk;
+                plan->pll_mul = mul;
+                plan->hpre = (i == 0) ? 0 : (uint8_t)(0x8 | (i - 1));
+                if(mul == 0)
+                {
+                    plan->source = hse ? CLOCK_SOURCE_HSE : CLOCK_SOURCE_HSI;
+                }
+                else
+                {
+                    plan->source = hse ? CLOCK_SOURCE_PLL_HSE : CLOCK_SOURCE_PLL_HSI;
+                }
+            }
+        }
+    }
+
+    if(plan->hclk == 0)
+    {
+        /* Below osc / 512: run as slow as possible */
+        plan->hclk = osc / 512;
+        plan->hpre = 0xF;
+    }
+}
+
+/**
+  * @brief  Bus frequencies a plan will produce
+  * @param  plan: Plan
+  * @param  freq: Destination
+  * @retval None
+  */
+static void Clock_PlanFreq(const Clock_Plan_t *plan, Clock_Freq_t *freq)
+{
+    freq->sysclk = plan->sysclk;
+    freq->hclk = plan->hclk;
+    freq->pclk1 = (plan->hclk > CLOCK_PCLK1_MAX) ? plan->hclk / 2 : plan->hclk;
+    freq->pclk2 = plan->hclk;
+    freq->tim_apb1 = (freq->pclk1 != freq->hclk) ? freq->pclk1 * 2 : freq->pclk1;
+    freq->tim_apb2 = freq->pclk2;
+    freq->adcclk = freq->pclk2 / Clock_AdcDiv(freq->pclk2);
+    freq->source = plan->source;
+    freq->hse_failed = 0;
+}
+
+/**
+  * @brief  Program the RCC and flash for a plan
+  * @param  plan: Plan
+  * @param  freq: Bus frequencies of the plan (Clock_PlanFreq)
+  * @note   Call with interrupts disabled. Runs from the HSI while the PLL
+  *         and dividers change; on failure the core stays on the HSI.
+  * @retval SUCCESS, or ERROR if HSE or PLL did not become ready
+  */
+static ErrorStatus Clock_Apply(const Clock_Plan_t *plan, const Clock_Freq_t *freq)
+{
+    uint32_t latency = Clock_FlashLatency(plan->sysclk);
+    uint8_t use_hse = (plan->source == CLOCK_SOURCE_HSE || plan->source == CLOCK_SOURCE_PLL_HSE);
+    uint32_t cfgr;
+    uint32_t sw;
+
+    /* More wait states before the clock goes up */
+    if(latency > (CLOCK_FLASH_ACR & FLASH_ACR_LATENCY_Msk))
+    {
+        CLOCK_FLASH_ACR = FLASH_ACR_PRFTBE | latency;
+    }
+
+    /* Park on the HSI (with undivided buses) */
+    RCC->CR |= RCC_CR_HSION;
+    if(!Clock_WaitFlag(&RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY))
+    {
+        return ERROR;
+    }
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_SW_Msk | RCC_CFGR_BUS_Msk)) | CLOCK_SW_HSI;
+    Clock_WaitFlag(&RCC->CFGR, 0x3UL << RCC_CFGR_SWS_Pos, CLOCK_SW_HSI << RCC_CFGR_SWS_Pos);
+
+    RCC->CR &= ~RCC_CR_PLLON;
+    Clock_WaitFlag(&RCC->CR, RCC_CR_PLLRDY, 0);
+
+    if(use_hse)
+    {
+        RCC->CR |= RCC_CR_HSEON;
+        if(!Clock_WaitFlag(&RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY))
+        {
+            RCC->CR &= ~RCC_CR_HSEON;
+            return ERROR;
+        }
+    }
+
+    cfgr = RCC->CFGR & ~RCC_CFGR_PLL_Msk;
+    sw = use_hse ? CLOCK_SW_HSE : CLOCK_SW_HSI;
+    if(plan->pll_mul != 0)
+    {
+        cfgr |= (uint32_t)(plan->pll_mul - 2) << RCC_CFGR_PLLMUL_Pos;
+        if(use_hse)
+        {
+            cfgr |= RCC_CFGR_PLLSRC;
+        }
+        /* USB needs 48 MHz: PLL / 1 at 48 MHz, PLL / 1.5 at 72 MHz */
+        if(plan->sysclk == 48000000UL)
+        {
+            cfgr |= RCC_CFGR_USBPRE;
+        }
+        RCC->CFGR = cfgr;
+
+        RCC->CR |= RCC_CR_PLLON;
+        if(!Clock_WaitFlag(&RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY))
+        {
+            RCC->CR &= ~(RCC_CR_PLLON | RCC_CR_HSEON);
+            return ERROR;
+        }
+        sw = CLOCK_SW_PLL;
+    }
+
+    /* Bus dividers, then the switch itself */
+    cfgr = (uint32_t)plan->hpre << RCC_CFGR_HPRE_Pos;
+    if(freq->pclk1 != freq->hclk)
+    {
+        cfgr |= 0x4UL << RCC_CFGR_PPRE1_Pos;                    /* /2 */
+    }
+    cfgr |= (Clock_AdcDiv(freq->pclk2) / 2 - 1) << RCC_CFGR_ADCPRE_Pos;
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_SW_Msk | RCC_CFGR_BUS_Msk)) | cfgr | sw;
+    Clock_WaitFlag(&RCC->CFGR, 0x3UL << RCC_CFGR_SWS_Pos, sw << RCC_CFGR_SWS_Pos);
+
+    /* Stop what is no longer used */
+    if(!use_hse)
+    {
+        RCC->CR &= ~RCC_CR_HSEON;
+    }
+
+    /* Fewer wait states once the clock is down */
+    if(latency < (CLOCK_FLASH_ACR & FLASH_ACR_LATENCY_Msk))
+    {
+        CLOCK_FLASH_ACR = FLASH_ACR_PRFTBE | latency;
+    }
+
+    return SUCCESS;
+}
+
+/**
+  * @brief  Poll a register field with a timeout
+  * @param  reg: Register
+  * @param  mask: Field
+  * @param  value: Expected field value
+  * @retval 1 = reached, 0 = timed out
+  */
+static uint8_t Clock_WaitFlag(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+{
+    uint32_t count;
+
+    for(count = 0; count < CLOCK_TIMEOUT; count++)
+    {
+        if((*reg & mask) == value)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+  * @brief  Flash wait states for a SYSCLK
+  * @param  sysclk: SYSCLK in Hz
+  * @retval 0 up to 24 MHz, 1 up to 48 MHz, else 2
+  */
+static uint32_t Clock_FlashLatency(uint32_t sysclk)
+{
+    if(sysclk <= 24000000UL)
+    {
+        return 0;
+    }
+    if(sysclk <= 48000000UL)
+    {
+        return 1;
+    }
+
+    return 2;
+}
+
+/**
+  * @brief  Smallest ADC prescaler that keeps the ADC clock legal
+  * @param  pclk2: APB2 clock in Hz
+  * @retval 2, 4, 6 or 8
+  */
+static uint32_t Clock_AdcDiv(uint32_t pclk2)
+{
+    uint32_t div;
+
+    for(div = 2; div < 8 && pclk2 / div > CLOCK_ADC_MAX; div += 2)
+    {
+    }
+
+    return div;
+}
+
+/**
+  * @brief  Call every registered notifier
+  * @param  event: CLOCK_EVENT_PRE or CLOCK_EVENT_POST
+  * @param  freq: Planned or actual clocks
+  * @retval None
+  */
+static void Clock_Notify(Clock_Event_t event, const Clock_Freq_t *freq)
+{
+    Clock_Notifier_t *n;
+
+    for(n = clock_notifiers; n != NULL; n = n->next)
+    {
+        n->callback(event, freq, n->arg);
+    }
+}
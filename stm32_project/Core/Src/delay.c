@@ -1,25 +1,83 @@
 /**
   ******************************************************************************
   * @file    delay.c
-  * @brief   Delay functions implementation using SysTick
+  * @brief   Delay functions implementation using SysTick and the DWT cycle counter
   ******************************************************************************
   */
 
 #include "delay.h"
 #include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
+#include "swtimer.h"
+#include "monitor.h"
+#include "memstat.h"
+#include "clock.h"
+#include "ramfunc.h"
+#include <stddef.h>
 
-static volatile uint32_t g_SysTick_Counter = 0;
+#define SYSTICK_RUN     (SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk)
+#define SYSTICK_STOP    (SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk)
+
+static volatile uint64_t g_SysTick_Counter = 0;
+
+/* Cycle counter scaling, derived from SystemCoreClock in Delay_Init and
+ * after every Clock_SetSysclk() */
+static uint32_t g_CyclesPerUs = 72;
+static uint32_t g_CyclesPerNs_Q16 = 4719;   /* cycles per ns, 16.16 fixed point */
+
+/* SysTick clock: the current period started at g_Clock_Base and ends when the
+ * counter reaches 0 at g_Clock_Base + g_Period_Load. Normal periods are one
+ * tick long; a tickless sleep programs one period spanning several ticks. */
+static uint32_t g_TickCycles = 72000;
+static uint32_t g_IdleMaxTicks = 233;       /* Longest period the 24-bit LOAD holds */
+static volatile uint64_t g_Clock_Base = 0;
+static volatile uint32_t g_Period_Load = 71999;
+
+/* Timestamp of the next tick not yet counted */
+static volatile uint64_t g_Tick_Next = 71999;
+
+/* Tickless wakeup in progress and when SysTick is due to fire */
+static volatile uint8_t g_Tickless_Wake = 0;
+static volatile uint64_t g_Wake_Target = 0;
+
+static Delay_IdleStats_t g_IdleStats;
+
+/* Clock change: time and core clock when the switch started */
+static Clock_Notifier_t g_ClockNotifier;
+static uint64_t g_Clock_Then = 0;
+static uint32_t g_Clock_Hz = 72000000;
+
+static void Delay_SetRate(uint32_t hz);
+static void Delay_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg);
+static uint8_t Delay_Account(void);
+static uint64_t Delay_Now(void);
+static void Delay_RunTicks(void);
+static void Delay_Sleep(uint32_t max_ticks);
 
 /**
-  * @brief  Initialize SysTick for delay functions
+  * @brief  Initialize SysTick for delay functions and start the cycle counter
   * @param  None
   * @retval None
   */
 void Delay_Init(void)
 {
+    Delay_SetRate(SystemCoreClock);
+
+    /* Enable the DWT cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    g_Clock_Base = 0;
+    g_Period_Load = g_TickCycles - 1;
+    g_Tick_Next = g_Period_Load;
+
     /* Configure SysTick to generate interrupt every 1ms */
-    /* 72MHz / 1000 = 72000 ticks for 1ms */
-    SysTick_Config(72000);
+    SysTick_Config(g_TickCycles);
+
+    if(g_ClockNotifier.callback == NULL)
+    {
+        Clock_Register(&g_ClockNotifier, Delay_ClockChanged, NULL);
+    }
 }
 
 /**
@@ -27,48 +85,488 @@ void Delay_Init(void)
   * @param  None
   * @retval None
   */
-void SysTick_Handler(void)
+RAMFUNC void SysTick_Handler(void)
 {
-    g_SysTick_Counter++;
+    uint32_t primask = __get_PRIMASK();
+    uint64_t now;
+    uint32_t latency;
+
+    /* Higher-priority ISRs may read the clock */
+    __disable_irq();
+    now = Delay_Now();
+    
+    /* The current period started when SysTick reloaded and raised this */
+    MONITOR_ISR_ENTRY(MONITOR_SRC_SYSTICK, (uint32_t)(now - g_Clock_Base));
+    
+    if(g_Tickless_Wake && now >= g_Wake_Target)
+    {
+        latency = (uint32_t)(now - g_Wake_Target);
+        g_IdleStats.wake_latency_last = latency;
+        if(latency > g_IdleStats.wake_latency_max)
+        {
+            g_IdleStats.wake_latency_max = latency;
+        }
+        g_Tickless_Wake = 0;
+    }
+    MONITOR_TICK(now);
+    __set_PRIMASK(primask);
+
+    MEMSTAT_TICK();
+    Delay_RunTicks();
 }
 
 /**
   * @brief  Delay in milliseconds
   * @param  ms: Number of milliseconds to delay
+  * @note   Sleeps in WFI; interrupts and software timers keep running
   * @retval None
   */
 void Delay_Ms(uint32_t ms)
 {
-    uint32_t start_tick = g_SysTick_Counter;
+    uint32_t start_tick = GetTick();
+    uint32_t elapsed;
+    uint32_t primask;
     
-    while((g_SysTick_Counter - start_tick) < ms)
+    while((elapsed = GetTick() - start_tick) < ms)
     {
-        /* Wait */
+        primask = __get_PRIMASK();
+        __disable_irq();
+        Delay_Sleep(ms - elapsed);
+        __set_PRIMASK(primask);
     }
 }
 
 /**
-  * @brief  Delay in microseconds (approximate)
+  * @brief  Sleep until the next interrupt that needs the main loop
+  * @param  None
+  * @note   Call from the main loop when there is nothing to do. Returns
+  *         at once if SWTIMER_DEFERRED callbacks are pending, otherwise
+  *         after any interrupt, or after the next software timer expiry.
+  * @retval None
+  */
+void Delay_Idle(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* Checked with interrupts off so a callback queued now still wakes us */
+    __disable_irq();
+    if(!SwTimer_IsPending())
+    {
+        Delay_Sleep(0xFFFFFFFFUL);
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Delay in microseconds
   * @param  us: Number of microseconds to delay
+  * @note   Counts core clock cycles, so the delay does not depend on the
+  *         optimization level; interrupts can only make it longer
   * @retval None
   */
 void Delay_Us(uint32_t us)
 {
-    uint32_t cycles = us * 72; /* 72 cycles per microsecond at 72MHz */
+    uint32_t start;
+    uint32_t cycles;
+    
+    /* Long delays in 1 s steps keep us * cycles/us below 2^32 */
+    while(us > 1000000)
+    {
+        Delay_Us(1000000);
+        us -= 1000000;
+    }
+    
+    start = DWT->CYCCNT;
+    cycles = us * g_CyclesPerUs;
+    
+    while((DWT->CYCCNT - start) < cycles)
+    {
+        /* Wait */
+    }
+}
+
+/**
+  * @brief  Delay in nanoseconds
+  * @param  ns: Number of nanoseconds to delay (rounded up to whole cycles)
+  * @note   Call overhead is a few tens of cycles, so short delays are
+  *         minimums, e.g. for HD44780 enable pulse widths
+  * @retval None
+  */
+void Delay_Ns(uint32_t ns)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = (uint32_t)(((uint64_t)ns * g_CyclesPerNs_Q16 + 0xFFFF) >> 16);
     
-    while(cycles--)
+    while((DWT->CYCCNT - start) < cycles)
     {
-        __asm("NOP");
+        /* Wait */
     }
 }
 
+
 /**
   * @brief  Get current tick count
   * @param  None
-  * @retval Current tick count in milliseconds
+  * @note   In SRAM for the I2C event interrupt path (i2c.c)
+  * @retval Current tick count in milliseconds (wraps after 49 days)
+  */
+RAMFUNC uint32_t GetTick(void)
+{
+    return (uint32_t)g_SysTick_Counter;
+}
+
+/**
+  * @brief  Get the 64-bit tick count
+  * @param  None
+  * @retval Milliseconds since Delay_Init, never wraps
+  */
+uint64_t Delay_GetTick64(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint64_t ticks;
+    
+    __disable_irq();
+    ticks = g_SysTick_Counter;
+    __set_PRIMASK(primask);
+    
+    return ticks;
+}
+
+/**
+  * @brief  64-bit timestamp in core clock cycles since Delay_Init
+  * @param  None
+  * @note   Counts through WFI sleep and never wraps in practice (8000 years
+  *         at 72 MHz). A tickless sleep loses a few cycles while SysTick is
+  *         reprogrammed. Safe from ISRs.
+  * @retval Timestamp in cycles
+  */
+uint64_t Delay_GetTimestamp(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint64_t now;
+    
+    __disable_irq();
+    now = Delay_Now();
+    __set_PRIMASK(primask);
+    
+    return now;
+}
+
+/**
+  * @brief  Microseconds since Delay_Init
+  * @param  None
+  * @retval Monotonic time in microseconds
+  */
+uint64_t Delay_GetMicros(void)
+{
+    return Delay_GetTimestamp() / g_CyclesPerUs;
+}
+
+/**
+  * @brief  Convert a cycle count to microseconds
+  * @param  cycles: Core clock cycles
+  * @retval Microseconds (truncated)
   */
-uint32_t GetTick(void)
+uint32_t Delay_CyclesToUs(uint32_t cycles)
 {
-    return g_SysTick_Counter;
+    return cycles / g_CyclesPerUs;
 }
 
+/**
+  * @brief  Convert a cycle count to nanoseconds
+  * @param  cycles: Core clock cycles
+  * @retval Nanoseconds (truncated, saturates after about 4.29 s)
+  */
+uint32_t Delay_CyclesToNs(uint32_t cycles)
+{
+    uint64_t ns = (uint64_t)cycles * 1000 / g_CyclesPerUs;
+    
+    return (ns > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)ns;
+}
+
+/**
+  * @brief  Convert a 64-bit timestamp to microseconds
+  * @param  timestamp: Delay_GetTimestamp() value or difference
+  * @retval Microseconds
+  */
+uint64_t Delay_TimestampToUs(uint64_t timestamp)
+{
+    return timestamp / g_CyclesPerUs;
+}
+
+/**
+  * @brief  Copy the sleep statistics
+  * @param  stats: Destination
+  * @note   Idle fraction = sleep_cycles / elapsed Delay_GetTimestamp() cycles
+  * @retval None
+  */
+void Delay_GetIdleStats(Delay_IdleStats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    
+    __disable_irq();
+    *stats = g_IdleStats;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear the sleep statistics
+  * @param  None
+  * @retval None
+  */
+void Delay_ResetIdleStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    
+    __disable_irq();
+    g_IdleStats.sleep_cycles = 0;
+    g_IdleStats.sleeps = 0;
+    g_IdleStats.tickless = 0;
+    g_IdleStats.early_wakes = 0;
+    g_IdleStats.wake_latency_max = 0;
+    g_IdleStats.wake_latency_last = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Derive the cycle scaling and tick length from the core clock
+  * @param  hz: HCLK in Hz
+  * @retval None
+  */
+static void Delay_SetRate(uint32_t hz)
+{
+    g_Clock_Hz = hz;
+    g_CyclesPerUs = hz / 1000000;
+    if(g_CyclesPerUs == 0)
+    {
+        /* Below 1 MHz microsecond conversions round up to 1 cycle */
+        g_CyclesPerUs = 1;
+    }
+    g_CyclesPerNs_Q16 = (uint32_t)(((uint64_t)hz << 16) / 1000000000 + 1);
+    g_TickCycles = hz / 1000;
+    g_IdleMaxTicks = (SysTick_LOAD_RELOAD_Msk + 1) / g_TickCycles;
+}
+
+/**
+  * @brief  Keep the clock running across a core clock change
+  * @param  event: CLOCK_EVENT_PRE or CLOCK_EVENT_POST
+  * @param  freq: Clock tree
+  * @param  arg: Unused
+  * @note   Called by Clock_SetSysclk() with interrupts disabled. The
+  *         timestamp is rescaled to cycles of the new clock, so
+  *         Delay_GetMicros() stays continuous; the time spent switching
+  *         and the fraction of the current tick are lost. Timestamps taken
+  *         before the change are in cycles of the old clock.
+  * @retval None
+  */
+static void Delay_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg)
+{
+    uint64_t base;
+
+    if(event == CLOCK_EVENT_PRE)
+    {
+        g_Clock_Then = Delay_Now();
+        return;
+    }
+
+    /* then / old * new without overflowing 64 bits */
+    base = (g_Clock_Then / g_Clock_Hz) * freq->hclk
+         + (g_Clock_Then % g_Clock_Hz) * freq->hclk / g_Clock_Hz;
+
+    Delay_SetRate(freq->hclk);
+    g_Clock_Base = base;
+    g_Period_Load = g_TickCycles - 1;
+    g_Tick_Next = base + g_Period_Load;
+    g_Tickless_Wake = 0;
+
+    SysTick->CTRL = SYSTICK_STOP;
+    SysTick->LOAD = g_Period_Load;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SYSTICK_RUN;
+}
+
+/**
+  * @brief  Count a SysTick reload if one happened since the last check
+  * @param  None
+  * @note   Call with interrupts disabled. Reading CTRL clears COUNTFLAG, so
+  *         all CTRL reads in this file go through here.
+  * @retval 1 = a new period started, 0 = same period
+  */
+RAMFUNC static uint8_t Delay_Account(void)
+{
+    if((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) == 0)
+    {
+        return 0;
+    }
+    
+    /* The next period runs for whatever LOAD holds now */
+    g_Clock_Base += (uint64_t)g_Period_Load + 1;
+    g_Period_Load = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+    
+    return 1;
+}
+
+/**
+  * @brief  Read the 64-bit clock
+  * @param  None
+  * @note   Call with interrupts disabled
+  * @retval Cycles since Delay_Init
+  */
+RAMFUNC static uint64_t Delay_Now(void)
+{
+    uint32_t val = SysTick->VAL;
+    
+    /* A reload between the two reads would pair an old VAL with a new base */
+    if(Delay_Account())
+    {
+        val = SysTick->VAL;
+    }
+    
+    return g_Clock_Base + (g_Period_Load - val);
+}
+
+/**
+  * @brief  Count every tick that has passed and advance the software timers
+  * @param  None
+  * @note   A tickless sleep delivers all skipped ticks in one call
+  * @retval None
+  */
+RAMFUNC static void Delay_RunTicks(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint64_t now;
+    
+    __disable_irq();
+    now = Delay_Now();
+    while(now >= g_Tick_Next)
+    {
+        g_Tick_Next += g_TickCycles;
+        g_SysTick_Counter++;
+        
+        __set_PRIMASK(primask);
+        SwTimer_Tick();
+        __disable_irq();
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Sleep in WFI for at most max_ticks ticks
+  * @param  max_ticks: Tick boundaries the caller is willing to sleep through
+  * @note   Call with interrupts disabled; a pending interrupt ends the sleep
+  *         and runs once the caller restores PRIMASK
+  * @retval None
+  */
+static void Delay_Sleep(uint32_t max_ticks)
+{
+    uint64_t t0;
+    uint64_t t1;
+#if DELAY_TICKLESS
+    uint64_t now;
+    uint64_t target;
+    uint64_t next;
+    uint32_t idle;
+    uint32_t load;
+    
+    /* Ticks after the next one in which no software timer expires */
+    idle = SwTimer_NextExpiry();
+    if(max_ticks == 0)
+    {
+        max_ticks = 1;
+    }
+    if(idle > max_ticks - 1)
+    {
+        idle = max_ticks - 1;
+    }
+    if(idle > g_IdleMaxTicks - 1)
+    {
+        idle = g_IdleMaxTicks - 1;
+    }
+    
+    if(idle > 0 && (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) == 0)
+    {
+        SysTick->CTRL = SYSTICK_STOP;
+        if(Delay_Account())
+        {
+            /* A tick is due right now: sleep normally */
+            SysTick->CTRL = SYSTICK_RUN;
+        }
+        else
+        {
+            /* Stretch the current period to end idle ticks later */
+            now = g_Clock_Base + (g_Period_Load - SysTick->VAL);
+            target = g_Clock_Base + g_Period_Load + (uint64_t)idle * g_TickCycles;
+            load = (uint32_t)(target - now);
+            
+            g_Clock_Base = now;
+            g_Period_Load = load;
+            g_Wake_Target = target;
+            g_Tickless_Wake = 1;
+            
+            SysTick->LOAD = load;
+            SysTick->VAL = 0;
+            SysTick->CTRL = SYSTICK_RUN;
+            /* Takes effect at the next reload, after the long period */
+            SysTick->LOAD = g_TickCycles - 1;
+            
+            g_IdleStats.tickless++;
+            
+            t0 = now;
+            __DSB();
+            __WFI();
+            __ISB();
+            t1 = Delay_Now();
+            
+            if(t1 < target)
+            {
+                /* Woken early: end the period at the next tick boundary */
+                SysTick->CTRL = SYSTICK_STOP;
+                if(Delay_Account())
+                {
+                    /* Reached the target meanwhile: SysTick is pending */
+                    SysTick->CTRL = SYSTICK_RUN;
+                }
+                else
+                {
+                    now = g_Clock_Base + (g_Period_Load - SysTick->VAL);
+                    next = g_Tick_Next;
+                    if(now >= next)
+                    {
+                        next += (uint64_t)((uint32_t)(now - next) / g_TickCycles + 1) * g_TickCycles;
+                    }
+                    load = (uint32_t)(next - now);
+                    
+                    g_Clock_Base = now;
+                    g_Period_Load = load;
+                    
+                    SysTick->LOAD = load;
+                    SysTick->VAL = 0;
+                    SysTick->CTRL = SYSTICK_RUN;
+                    SysTick->LOAD = g_TickCycles - 1;
+                    
+                    g_Tickless_Wake = 0;
+                    g_IdleStats.early_wakes++;
+                    
+                    /* Deliver the ticks slept through; no timer expires in them */
+                    Delay_RunTicks();
+                }
+            }
+            
+            g_IdleStats.sleep_cycles += t1 - t0;
+            g_IdleStats.sleeps++;
+            return;
+        }
+    }
+#else
+    (void)max_ticks;
+#endif
+    
+    t0 = Delay_Now();
+    __DSB();
+    __WFI();
+    __ISB();
+    t1 = Delay_Now();
+    
+    g_IdleStats.sleep_cycles += t1 - t0;
+    g_IdleStats.sleeps++;
+}
@@ -0,0 +1,286 @@
+/**
+  ******************************************************************************
+  * @file    fault.c
+  * @brief   Fault handlers with a crash record that survives the reset
+  ******************************************************************************
+  */
+
+#include "fault.h"
+#include "uart.h"
+
+#define FAULT_MAGIC             0xFA017EC0UL
+
+/* Stack of the fault handler (Fault_Save and what it calls) */
+#define FAULT_HANDLER_STACK     256
+
+#define FAULT_XSTR(x)           #x
+#define FAULT_STR(x)            FAULT_XSTR(x)
+
+/* Linker script symbols (addresses only) */
+extern uint8_t _etext;              /* End of code in flash */
+extern uint8_t _sramfunc;           /* Code copied to SRAM (ramfunc.h) */
+extern uint8_t _eramfunc;
+extern uint8_t _estack;             /* Top of RAM */
+
+/* Not cleared by the startup code, validated by magic and checksum */
+static Fault_Record_t fault_record __attribute__((section(".noinit")));
+
+/* Used by HardFault_Handler, so a broken MSP does not matter. The AAPCS
+   wants an 8-byte aligned stack; referenced only from the asm. */
+static uint32_t fault_stack[FAULT_HANDLER_STACK / 4] __attribute__((aligned(8), used));
+
+static const char *const fault_names[] =
+{
+    "HardFault", "MemManage", "BusFault", "UsageFault"
+};
+
+/* Private function prototypes */
+void Fault_Save(uint32_t *frame, uint32_t exc_return) __attribute__((noreturn, used));
+static uint8_t Fault_Valid(void);
+static uint32_t Fault_Checksum(const Fault_Record_t *record);
+static uint8_t Fault_IsCode(uint32_t addr);
+
+/**
+  * @brief  Enable the MemManage, BusFault and UsageFault handlers
+  * @param  None
+  * @note   Without them every fault escalates to HardFault. Integer
+  *         division by zero traps as UsageFault instead of returning 0.
+  *         Without an MPU, MemManage only reports execution from an
+  *         execute-never region (peripherals, system space).
+  * @retval None
+  */
+void Fault_Init(void)
+{
+    SCB->SHCSR |= SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_MEMFAULTENA_Msk;
+    SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+}
+
+/**
+  * @brief  Copy the crash record
+  * @param  record: Destination
+  * @retval 1 = a fault was recorded, 0 = no valid record
+  */
+uint8_t Fault_GetRecord(Fault_Record_t *record)
+{
+    if(!Fault_Valid())
+    {
+        return 0;
+    }
+
+    *record = fault_record;
+    return 1;
+}
+
+/**
+  * @brief  Check for a fault that was not printed yet
+  * @param  None
+  * @retval 1 = Fault_Print() has something new to show
+  */
+uint8_t Fault_Pending(void)
+{
+    return Fault_Valid() && !(fault_record.flags & FAULT_FLAG_REPORTED);
+}
+
+/**
+  * @brief  Print the crash record for tools/fault_decode.py
+  * @param  USARTx: USART peripheral
+  * @note   Marks the record reported; it stays valid until Fault_Clear()
+  *         or power-off, and the count keeps counting
+  * @retval None
+  */
+void Fault_Print(USART_TypeDef *USARTx)
+{
+    Fault_Record_t *r = &fault_record;
+    uint32_t i;
+
+    if(!Fault_Valid())
+    {
+        UART_Printf(USARTx, "no fault recorded\r\n");
+        return;
+    }
+
+    UART_Printf(USARTx, "*** FAULT ***\r\n");
+    UART_Printf(USARTx, "count      %lu\r\n", r->count);
+    UART_Printf(USARTx, "exception  %lu %s\r\n", r->exception,
+                (r->exception >= 3 && r->exception <= 6) ? fault_names[r->exception - 3] : "?");
+    UART_Printf(USARTx, "flags      0x%08lX%s%s\r\n", r->flags,
+                (r->flags & FAULT_FLAG_PSP) ? " psp" : " msp",
+                (r->flags & FAULT_FLAG_BAD_SP) ? " bad_sp" : "");
+    UART_Printf(USARTx, "pc         0x%08lX\r\n", r->pc);
+    UART_Printf(USARTx, "lr         0x%08lX\r\n", r->lr);
+    UART_Printf(USARTx, "sp         0x%08lX\r\n", r->sp);
+    UART_Printf(USARTx, "xpsr       0x%08lX\r\n", r->xpsr);
+    UART_Printf(USARTx, "r0-r3      0x%08lX 0x%08lX 0x%08lX 0x%08lX\r\n", r->r0, r->r1, r->r2, r->r3);
+    UART_Printf(USARTx, "r12        0x%08lX\r\n", r->r12);
+    UART_Printf(USARTx, "exc_return 0x%08lX\r\n", r->exc_return);
+    UART_Printf(USARTx, "cfsr       0x%08lX\r\n", r->cfsr);
+    UART_Printf(USARTx, "hfsr       0x%08lX\r\n", r->hfsr);
+    UART_Printf(USARTx, "mmfar      0x%08lX%s\r\n", r->mmfar, (r->cfsr & SCB_CFSR_MMARVALID_Msk) ? "" : " (invalid)");
+    UART_Printf(USARTx, "bfar       0x%08lX%s\r\n", r->bfar, (r->cfsr & SCB_CFSR_BFARVALID_Msk) ? "" : " (invalid)");
+    UART_Printf(USARTx, "stack     ");
+    for(i = 0; i < r->depth; i++)
+    {
+        UART_Printf(USARTx, " 0x%08lX", r->stack[i]);
+    }
+    UART_Printf(USARTx, "\r\n*** END ***\r\n");
+
+    r->flags |= FAULT_FLAG_REPORTED;
+    r->checksum = Fault_Checksum(r);
+}
+
+/**
+  * @brief  Discard the crash record
+  * @param  None
+  * @retval None
+  */
+void Fault_Clear(void)
+{
+    fault_record.magic = 0;
+}
+
+/**
+  * @brief  Common entry of HardFault, MemManage, BusFault and UsageFault
+  * @param  None
+  * @note   Passes the exception frame (from the MSP or PSP, see EXC_RETURN
+  *         bit 2) to Fault_Save() and moves the MSP to fault_stack
+  * @retval None
+  */
+__attribute__((naked)) void HardFault_Handler(void)
+{
+    __asm volatile (
+        "   tst     lr, #4              \n"
+        "   ite     eq                  \n"
+        "   mrseq   r0, msp             \n"
+        "   mrsne   r0, psp             \n"     /* r0 = exception frame */
+        "   mov     r1, lr              \n"     /* r1 = EXC_RETURN */
+        "   ldr     r2, =fault_stack + " FAULT_STR(FAULT_HANDLER_STACK) "\n"
+        "   msr     msp, r2             \n"
+        "   b       Fault_Save          \n"
+        "   .ltorg                      \n"
+    );
+}
+
+void MemManage_Handler(void) __attribute__((alias("HardFault_Handler")));
+void BusFault_Handler(void) __attribute__((alias("HardFault_Handler")));
+void UsageFault_Handler(void) __attribute__((alias("HardFault_Handler")));
+
+/**
+  * @brief  Fill the crash record, then reset (FAULT_RESET) or stop
+  * @param  frame: Exception frame r0-r3, r12, lr, pc, xpsr
+  * @param  exc_return: lr on exception entry
+  * @note   Runs on fault_stack. The frame is only read if it lies in RAM.
+  * @retval None
+  */
+void Fault_Save(uint32_t *frame, uint32_t exc_return)
+{
+    Fault_Record_t *r = &fault_record;
+    uint32_t *regs = &r->r0;            /* r0 .. xpsr, same order as the frame */
+    uint32_t sp = (uint32_t)frame;
+    const uint32_t *p;
+    const uint32_t *top = (const uint32_t *)&_estack;
+    uint32_t count = Fault_Valid() ? r->count : 0;
+    uint8_t frame_ok;
+    uint32_t i;
+
+    frame_ok = (sp & 3) == 0 && sp >= SRAM_BASE && sp + 32 <= (uint32_t)&_estack;
+
+    r->magic = FAULT_MAGIC;
+    r->count = count + 1;
+    r->exception = __get_IPSR() & 0x1FF;
+    r->flags = (exc_return & 4) ? FAULT_FLAG_PSP : 0;
+    r->exc_return = exc_return;
+    r->cfsr = SCB->CFSR;
+    r->hfsr = SCB->HFSR;
+    r->mmfar = SCB->MMFAR;
+    r->bfar = SCB->BFAR;
+    r->depth = 0;
+    for(i = 0; i < 8; i++)
+    {
+        regs[i] = frame_ok ? frame[i] : 0;
+    }
+
+    if(frame_ok)
+    {
+        /* Stack pointer before the exception: frame plus alignment word */
+        r->sp = sp + 32 + ((r->xpsr & (1UL << 9)) ? 4 : 0);
+
+        for(p = (const uint32_t *)r->sp, i = 0; p < top && i < FAULT_SCAN_WORDS; p++, i++)
+        {
+            if(Fault_IsCode(*p))
+            {
+                r->stack[r->depth++] = *p;
+                if(r->depth == FAULT_STACK_DEPTH)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        r->flags |= FAULT_FLAG_BAD_SP;
+        r->sp = sp;
+    }
+
+    for(i = r->depth; i < FAULT_STACK_DEPTH; i++)
+    {
+        r->stack[i] = 0;
+    }
+    r->checksum = Fault_Checksum(r);
+
+#if FAULT_RESET
+    NVIC_SystemReset();
+#else
+    /* Stop here for the debugger */
+    while(1)
+    {
+    }
+#endif
+}
+
+/**
+  * @brief  Check magic and checksum of the crash record
+  * @param  None
+  * @note   RAM holds random data after power-on
+  * @retval 1 = valid
+  */
+static uint8_t Fault_Valid(void)
+{
+    return fault_record.magic == FAULT_MAGIC &&
+           fault_record.checksum == Fault_Checksum(&fault_record);
+}
+
+/**
+  * @brief  Checksum of all words before the checksum field
+  * @param  record: Crash record
+  * @retval Checksum
+  */
+static uint32_t Fault_Checksum(const Fault_Record_t *record)
+{
+    const uint32_t *w = (const uint32_t *)record;
+    uint32_t n = (uint32_t)((const uint8_t *)&record->checksum - (const uint8_t *)record) / 4;
+    uint32_t sum = 0;
+
+    while(n--)
+    {
+        sum = ((sum << 1) | (sum >> 31)) ^ *w++;
+    }
+
+    return ~sum;
+}
+
+/**
+  * @brief  Check whether a stack word can be a return address
+  * @param  addr: Stack word
+  * @retval 1 = Thumb address inside the code in flash or .ramfunc
+  */
+static uint8_t Fault_IsCode(uint32_t addr)
+{
+    if(!(addr & 1))
+    {
+        return 0;
+    }
+
+    return (addr >= FLASH_BASE && addr < (uint32_t)&_etext) ||
+           (addr >= (uint32_t)&_sramfunc && addr < (uint32_t)&_eramfunc);
+}
@@ -13,34 +13,59 @@
   * @param  GPIO_Pin: GPIO pin number (GPIO_PIN_0 to GPIO_PIN_15)
   * @param  Mode: GPIO mode
   * @param  CNF: GPIO configuration
+  * @note   Configures a single pin. To configure several pins at once use a
+  *         precomputed GPIO_PortConfig_t and GPIO_InitPort()
   * @retval None
   */
 void GPIO_Init(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint32_t Mode, uint32_t CNF)
 {
-    uint32_t position = 0;
-    uint32_t config = 0;
+    uint32_t position;
+    uint32_t shift;
+    uint32_t config;
     
-    /* Find pin position */
-    while(GPIO_Pin >> position != 1)
+    if(GPIO_Pin == 0)
     {
-        position++;
+        return;
     }
     
+    /* Pin position from the lowest set bit (RBIT + CLZ, no loop) */
+    position = (uint32_t)__builtin_ctz(GPIO_Pin);
+    shift = (position & 7) * 4;
+    
     /* Configure pin mode and CNF */
     config = (CNF << 2) | Mode;
     
     if(position < 8)
     {
         /* Configure CRL register (pins 0-7) */
-        GPIOx->CRL &= ~(0xF << (position * 4));
-        GPIOx->CRL |= (config << (position * 4));
+        GPIOx->CRL = (GPIOx->CRL & ~(0xFUL << shift)) | (config << shift);
     }
     else
     {
         /* Configure CRH register (pins 8-15) */
-        position -= 8;
-        GPIOx->CRH &= ~(0xF << (position * 4));
-        GPIOx->CRH |= (config << (position * 4));
+        GPIOx->CRH = (GPIOx->CRH & ~(0xFUL << shift)) | (config << shift);
+    }
+}
+
+/**
+  * @brief  Configure a set of pins on one port from precomputed masks
+  * @param  config: port configuration built with GPIO_PORT_CONFIG()
+  * @note   At most one read-modify-write of CRL and one of CRH, skipped
+  *         when no pin of that half is selected
+  * @retval None
+  */
+void GPIO_InitPort(const GPIO_PortConfig_t *config)
+{
+    GPIO_TypeDef *GPIOx = config->port;
+    
+    if(config->crl_mask != 0)
+    {
+        GPIOx->CRL = (GPIOx->CRL & ~config->crl_mask) | config->crl;
+    }
+    
+    if(config->crh_mask != 0)
+    {
+        GPIOx->CRH = (GPIOx->CRH & ~config->crh_mask) | config->crh;
     }
 }
 
@@ -66,12 +91,21 @@ void GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinStat
 /**
   * @brief  Toggle pin state
   * @param  GPIOx: GPIO port
-  * @param  GPIO_Pin: GPIO pin
+  * @param  GPIO_Pin: GPIO pin (several pins may be OR-ed together)
+  * @note   A single pin is flipped through its ODR bit-band alias
   * @retval None
   */
 void GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
 {
-    uint32_t odr = GPIOx->ODR;
+    uint32_t odr;
+    
+    if(GPIO_Pin != 0 && (GPIO_Pin & (GPIO_Pin - 1)) == 0)
+    {
+        GPIO_PIN_OUT(GPIOx, __builtin_ctz(GPIO_Pin)) ^= 1;
+        return;
+    }
+    
+    odr = GPIOx->ODR;
     GPIOx->BSRR = ((odr & GPIO_Pin) << 16) | (~odr & GPIO_Pin);
 }
 
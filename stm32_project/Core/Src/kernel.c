@@ -0,0 +1,916 @@
+/**
+  ******************************************************************************
+  * @file    kernel.c
+  * @brief   Minimal preemptive kernel: threads, mutexes, semaphores, queues
+  ******************************************************************************
+  */
+
+#include "kernel.h"
+#include "delay.h"
+#include "memstat.h"
+#include "ramfunc.h"
+#include <stddef.h>
+#include <string.h>
+
+#define KERNEL_XPSR_THUMB       0x01000000UL
+
+/* Running thread and the one PendSV switches to; read by the handlers below */
+Kernel_Thread_t *volatile kernel_current = NULL;
+Kernel_Thread_t *volatile kernel_next = NULL;
+
+/* Ready lists per priority, running thread at the head of its list */
+static Kernel_Thread_t *kernel_ready[KERNEL_PRIORITIES];
+static Kernel_Thread_t *kernel_ready_tail[KERNEL_PRIORITIES];
+static uint32_t kernel_ready_map = 0;
+
+static volatile uint8_t kernel_running = 0;
+static volatile uint32_t kernel_switches = 0;
+
+/* Every created thread, newest first (linked through link) */
+static Kernel_Thread_t *kernel_threads = NULL;
+
+static Kernel_Thread_t kernel_idle;
+static uint32_t kernel_idle_stack[KERNEL_IDLE_STACK];
+
+/* Called from the assembly handlers */
+uint32_t *Kernel_Launch(void);
+uint32_t *Kernel_SwitchContext(void);
+
+/* Private function prototypes */
+static void Kernel_ReadyAdd(Kernel_Thread_t *thread, uint8_t at_head);
+static void Kernel_ReadyRemove(Kernel_Thread_t *thread);
+static void Kernel_WaitInsert(Kernel_Thread_t **list, Kernel_Thread_t *thread);
+static void Kernel_WaitRemove(Kernel_Thread_t **list, Kernel_Thread_t *thread);
+static void Kernel_Schedule(void);
+static uint8_t Kernel_CanBlock(void);
+static void Kernel_Suspend(Kernel_Thread_t **list, uint32_t timeout_ms);
+static void Kernel_Wake(Kernel_Thread_t *thread, Kernel_Status_t result);
+static void Kernel_SetPriority(Kernel_Thread_t *thread, uint8_t priority);
+static void Kernel_UpdatePriority(Kernel_Thread_t *thread);
+static void Kernel_TimeoutCallback(void *arg);
+static void Kernel_ThreadExit(void);
+static void Kernel_IdleThread(void *arg);
+
+/**
+  * @brief  Create a thread
+  * @param  thread: Caller-owned thread object
+  * @param  name: Name for diagnostics
+  * @param  entry: Thread function; returning ends the thread
+  * @param  arg: Argument passed to entry
+  * @param  priority: 0 (highest) .. KERNEL_PRIORITIES - 2
+  * @param  stack: Caller-owned stack
+  * @param  stack_size: Stack size in bytes, at least 64 words is advisable
+  * @note   May be called before or after Kernel_Start()
+  * @retval None
+  */
+void Kernel_ThreadCreate(Kernel_Thread_t *thread, const char *name, Kernel_Entry_t entry, void *arg,
+                         uint8_t priority, uint32_t *stack, uint32_t stack_size)
+{
+    uint32_t primask;
+    uint32_t *sp;
+    uint8_t i;
+
+    if(priority >= KERNEL_PRIORITIES)
+    {
+        priority = KERNEL_PRIORITIES - 1;
+    }
+
+    /* Unused stack keeps the pattern, see MemStat_GetStack() */
+    MemStat_Paint(stack, stack_size);
+
+    /* Initial exception frame, popped by the first switch to this thread */
+    sp = (uint32_t *)(((uint32_t)stack + stack_size) & ~7UL);
+    *--sp = KERNEL_XPSR_THUMB;
+    *--sp = (uint32_t)entry & ~1UL;             /* PC */
+    *--sp = (uint32_t)Kernel_ThreadExit;        /* LR */
+    for(i = 0; i < 4; i++)
+    {
+        *--sp = 0;                              /* R12, R3, R2, R1 */
+    }
+    *--sp = (uint32_t)arg;                      /* R0 */
+    for(i = 0; i < 8; i++)
+    {
+        *--sp = 0;                              /* R11 .. R4 */
+    }
+
+    thread->sp = sp;
+    thread->next = NULL;
+    thread->wait_list = NULL;
+    thread->blocked_on = NULL;
+    thread->held = NULL;
+    thread->name = name;
+    thread->stack = stack;
+    thread->stack_size = stack_size;
+    thread->msg = NULL;
+    thread->switches = 0;
+    thread->priority = priority;
+    thread->base_priority = priority;
+    thread->state = KERNEL_READY;
+    thread->result = KERNEL_OK;
+    SwTimer_Init(&thread->timer, Kernel_TimeoutCallback, thread, SWTIMER_ISR);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    thread->link = kernel_threads;
+    kernel_threads = thread;
+    Kernel_ReadyAdd(thread, 0);
+    Kernel_Schedule();
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Start scheduling
+  * @param  None
+  * @note   Creates the idle thread and switches to the highest-priority
+  *         thread; the main stack is reset for interrupt use. Never returns.
+  * @retval None
+  */
+void Kernel_Start(void)
+{
+    Kernel_ThreadCreate(&kernel_idle, "idle", Kernel_IdleThread, NULL, KERNEL_PRIORITIES - 1,
+                        kernel_idle_stack, sizeof(kernel_idle_stack));
+
+    /* Switch only once no other handler is active */
+    NVIC_SetPriority(PendSV_IRQn, 0xF);
+
+    __enable_irq();
+    __asm volatile ("svc 0");
+
+    while(1)
+    {
+    }
+}
+
+/**
+  * @brief  Get the running thread
+  * @param  None
+  * @retval Current thread, NULL before Kernel_Start()
+  */
+Kernel_Thread_t *Kernel_Self(void)
+{
+    return kernel_current;
+}
+
+/**
+  * @brief  Let other ready threads of the same priority run
+  * @param  None
+  * @retval None
+  */
+void Kernel_Yield(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if(kernel_running)
+    {
+        Kernel_ReadyRemove(kernel_current);
+        Kernel_ReadyAdd(kernel_current, 0);
+        Kernel_Schedule();
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Block the calling thread for at least ms milliseconds
+  * @param  ms: Sleep time, 0 = Kernel_Yield()
+  * @note   Use instead of Delay_Ms() in threads so lower priorities can run
+  * @retval None
+  */
+void Kernel_Sleep(uint32_t ms)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    if(ms == 0)
+    {
+        Kernel_Yield();
+        return;
+    }
+
+    __disable_irq();
+    if(Kernel_CanBlock())
+    {
+        Kernel_Suspend(NULL, ms);
+        Kernel_Schedule();
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Number of context switches since Kernel_Start()
+  * @param  None
+  * @retval Switch count
+  */
+uint32_t Kernel_GetSwitches(void)
+{
+    return kernel_switches;
+}
+
+/**
+  * @brief  First of all created threads, including the idle thread
+  * @param  None
+  * @note   Follow thread->link to the next; exited threads stay listed
+  * @retval Newest thread, NULL if none
+  */
+Kernel_Thread_t *Kernel_GetThreads(void)
+{
+    return kernel_threads;
+}
+
+/**
+  * @brief  Initialize a mutex (unlocked)
+  * @param  mutex: Caller-owned mutex
+  * @retval None
+  */
+void Kernel_MutexInit(Kernel_Mutex_t *mutex)
+{
+    mutex->owner = NULL;
+    mutex->waiters = NULL;
+    mutex->next_held = NULL;
+}
+
+/**
+  * @brief  Lock a mutex
+  * @param  mutex: Initialized mutex
+  * @param  timeout_ms: KERNEL_NO_WAIT, time in ms, or KERNEL_WAIT_FOREVER
+  * @note   While a higher-priority thread waits, the owner runs at that
+  *         thread's priority (transitively through nested mutexes).
+  *         Threads only.
+  * @retval KERNEL_OK, KERNEL_TIMEOUT, or KERNEL_ERROR if already owned by the caller
+  */
+Kernel_Status_t Kernel_MutexLock(Kernel_Mutex_t *mutex, uint32_t timeout_ms)
+{
+    uint32_t primask = __get_PRIMASK();
+    Kernel_Thread_t *self = kernel_current;
+    Kernel_Status_t status;
+
+    __disable_irq();
+
+    if(self == NULL || __get_IPSR() != 0)
+    {
+        status = KERNEL_ERROR;
+    }
+    else if(mutex->owner == NULL)
+    {
+        mutex->owner = self;
+        mutex->next_held = self->held;
+        self->held = mutex;
+        status = KERNEL_OK;
+    }
+    else if(mutex->owner == self)
+    {
+        status = KERNEL_ERROR;
+    }
+    else if(timeout_ms == KERNEL_NO_WAIT || !Kernel_CanBlock())
+    {
+        status = KERNEL_TIMEOUT;
+    }
+    else
+    {
+        self->blocked_on = mutex;
+        Kernel_Suspend(&mutex->waiters, timeout_ms);
+        Kernel_UpdatePriority(mutex->owner);
+        Kernel_Schedule();
+        __set_PRIMASK(primask);
+
+        /* Ownership was handed over by the unlocking thread */
+        return (Kernel_Status_t)self->result;
+    }
+
+    __set_PRIMASK(primask);
+    return status;
+}
+
+/**
+  * @brief  Unlock a mutex owned by the calling thread
+  * @param  mutex: Locked mutex
+  * @note   Passes ownership to the highest-priority waiter and drops any
+  *         priority inherited through this mutex
+  * @retval KERNEL_OK, or KERNEL_ERROR if the caller is not the owner
+  */
+Kernel_Status_t Kernel_MutexUnlock(Kernel_Mutex_t *mutex)
+{
+    uint32_t primask = __get_PRIMASK();
+    Kernel_Thread_t *self = kernel_current;
+    Kernel_Thread_t *waiter;
+    Kernel_Mutex_t **link;
+
+    __disable_irq();
+
+    if(mutex->owner != self || self == NULL || __get_IPSR() != 0)
+    {
+        __set_PRIMASK(primask);
+        return KERNEL_ERROR;
+    }
+
+    for(link = &self->held; *link != mutex; link = &(*link)->next_held)
+    {
+    }
+    *link = mutex->next_held;
+    mutex->next_held = NULL;
+
+    waiter = mutex->waiters;
+    if(waiter != NULL)
+    {
+        mutex->owner = waiter;
+        mutex->next_held = waiter->held;
+        waiter->held = mutex;
+        waiter->blocked_on = NULL;
+        Kernel_Wake(waiter, KERNEL_OK);
+        Kernel_UpdatePriority(waiter);
+    }
+    else
+    {
+        mutex->owner = NULL;
+    }
+
+    Kernel_UpdatePriority(self);
+    Kernel_Schedule();
+
+    __set_PRIMASK(primask);
+    return KERNEL_OK;
+}
+
+/**
+  * @brief  Initialize a counting semaphore
+  * @param  sem: Caller-owned semaphore
+  * @param  count: Initial count
+  * @param  max: Highest count (1 = binary semaphore)
+  * @retval None
+  */
+void Kernel_SemInit(Kernel_Sem_t *sem, uint32_t count, uint32_t max)
+{
+    sem->count = count;
+    sem->max = max;
+    sem->waiters = NULL;
+}
+
+/**
+  * @brief  Take a semaphore
+  * @param  sem: Initialized semaphore
+  * @param  timeout_ms: KERNEL_NO_WAIT, time in ms, or KERNEL_WAIT_FOREVER
+  * @note   Only KERNEL_NO_WAIT from interrupts
+  * @retval KERNEL_OK or KERNEL_TIMEOUT
+  */
+Kernel_Status_t Kernel_SemTake(Kernel_Sem_t *sem, uint32_t timeout_ms)
+{
+    uint32_t primask = __get_PRIMASK();
+    Kernel_Status_t status = KERNEL_TIMEOUT;
+
+    __disable_irq();
+
+    if(sem->count > 0)
+    {
+        sem->count--;
+        status = KERNEL_OK;
+    }
+    else if(timeout_ms != KERNEL_NO_WAIT && Kernel_CanBlock())
+    {
+        Kernel_Suspend(&sem->waiters, timeout_ms);
+        Kernel_Schedule();
+        __set_PRIMASK(primask);
+
+        return (Kernel_Status_t)kernel_current->result;
+    }
+
+    __set_PRIMASK(primask);
+    return status;
+}
+
+/**
+  * @brief  Give a semaphore
+  * @param  sem: Initialized semaphore
+  * @note   Safe from interrupts; a woken higher-priority thread runs as
+  *         soon as the interrupt returns
+  * @retval KERNEL_OK, or KERNEL_ERROR if the count is already at max
+  */
+Kernel_Status_t Kernel_SemGive(Kernel_Sem_t *sem)
+{
+    uint32_t primask = __get_PRIMASK();
+    Kernel_Status_t status = KERNEL_OK;
+
+    __disable_irq();
+
+    if(sem->waiters != NULL)
+    {
+        Kernel_Wake(sem->waiters, KERNEL_OK);
+        Kernel_Schedule();
+    }
+    else if(sem->count < sem->max)
+    {
+        sem->count++;
+    }
+    else
+    {
+        status = KERNEL_ERROR;
+    }
+
+    __set_PRIMASK(primask);
+    return status;
+}
+
+/**
+  * @brief  Initialize a message queue
+  * @param  queue: Caller-owned queue
+  * @param  buffer: Storage for length * item_size bytes
+  * @param  item_size: Bytes per item
+  * @param  length: Items the queue holds (at least 1)
+  * @retval None
+  */
+void Kernel_QueueInit(Kernel_Queue_t *queue, void *buffer, uint16_t item_size, uint16_t length)
+{
+    queue->buffer = (uint8_t *)buffer;
+    queue->item_size = item_size;
+    queue->length = length;
+    queue->head = 0;
+    queue->count = 0;
+    queue->senders = NULL;
+    queue->receivers = NULL;
+}
+
+/**
+  * @brief  Send an item (copied)
+  * @param  queue: Initialized queue
+  * @param  item: Item of item_size bytes
+  * @param  timeout_ms: KERNEL_NO_WAIT, time in ms, or KERNEL_WAIT_FOREVER
+  * @note   Only KERNEL_NO_WAIT from interrupts. A waiting receiver gets
+  *         the item directly.
+  * @retval KERNEL_OK or KERNEL_TIMEOUT (queue full)
+  */
+Kernel_Status_t Kernel_QueueSend(Kernel_Queue_t *queue, const void *item, uint32_t timeout_ms)
+{
+    uint32_t primask = __get_PRIMASK();
+    Kernel_Status_t status = KERNEL_OK;
+    Kernel_Thread_t *receiver;
+    uint16_t slot;
+
+    __disable_irq();
+
+    receiver = queue->receivers;
+    if(receiver != NULL)
+    {
+        memcpy(receiver->msg, item, queue->item_size);
+        Kernel_Wake(receiver, KERNEL_OK);
+        Kernel_Schedule();
+    }
+    else if(queue->count < queue->length)
+    {
+        slot = (uint16_t)((queue->head + queue->count) % queue->length);
+        memcpy(&queue->buffer[slot * queue->item_size], item, queue->item_size);
+        queue->count++;
+    }
+    else if(timeout_ms != KERNEL_NO_WAIT && Kernel_CanBlock())
+    {
+        /* The receiver that makes room copies the item from here */
+        kernel_current->msg = (void *)item;
+        Kernel_Suspend(&queue->senders, timeout_ms);
+        Kernel_Schedule();
+        __set_PRIMASK(primask);
+
+        return (Kernel_Status_t)kernel_current->result;
+    }
+    else
+    {
+        status = KERNEL_TIMEOUT;
+    }
+
+    __set_PRIMASK(primask);
+    return status;
+}
+
+/**
+  * @brief  Receive the oldest item
+  * @param  queue: Initialized queue
+  * @param  item: Destination of item_size bytes
+  * @param  timeout_ms: KERNEL_NO_WAIT, time in ms, or KERNEL_WAIT_FOREVER
+  * @note   Only KERNEL_NO_WAIT from interrupts
+  * @retval KERNEL_OK or KERNEL_TIMEOUT (queue empty)
+  */
+Kernel_Status_t Kernel_QueueReceive(Kernel_Queue_t *queue, void *item, uint32_t timeout_ms)
+{
+    uint32_t primask = __get_PRIMASK();
+    Kernel_Status_t status = KERNEL_OK;
+    Kernel_Thread_t *sender;
+    uint16_t slot;
+
+    __disable_irq();
+
+    if(queue->count > 0)
+    {
+        memcpy(item, &queue->buffer[queue->head * queue->item_size], queue->item_size);
+        queue->head = (uint16_t)((queue->head + 1) % queue->length);
+        queue->count--;
+
+        /* Move the first blocked sender's item into the freed slot */
+        sender = queue->senders;
+        if(sender != NULL)
+        {
+            slot = (uint16_t)((queue->head + queue->count) % queue->length);
+            memcpy(&queue->buffer[slot * queue->item_size], sender->msg, queue->item_size);
+            queue->count++;
+            Kernel_Wake(sender, KERNEL_OK);
+            Kernel_Schedule();
+        }
+    }
+    else if(timeout_ms != KERNEL_NO_WAIT && Kernel_CanBlock())
+    {
+        kernel_current->msg = item;
+        Kernel_Suspend(&queue->receivers, timeout_ms);
+        Kernel_Schedule();
+        __set_PRIMASK(primask);
+
+        return (Kernel_Status_t)kernel_current->result;
+    }
+    else
+    {
+        status = KERNEL_TIMEOUT;
+    }
+
+    __set_PRIMASK(primask);
+    return status;
+}
+
+/**
+  * @brief  SVC handler: switch from main() to the first thread
+  * @param  None
+  * @note   Only used by Kernel_Start() (svc 0)
+  * @retval None
+  */
+__attribute__((naked)) void SVC_Handler(void)
+{
+    __asm volatile (
+        "   cpsid   i                   \n"
+        "   bl      Kernel_Launch       \n"     /* r0 = first thread's sp */
+        "   ldmia   r0!, {r4-r11}       \n"
+        "   msr     psp, r0             \n"
+        "   ldr     r0, =_estack        \n"     /* main() never resumes */
+        "   msr     msp, r0             \n"
+        "   mvn     lr, #2              \n"     /* EXC_RETURN: thread mode, PSP */
+        "   cpsie   i                   \n"
+        "   bx      lr                  \n"
+        "   .ltorg                      \n"
+    );
+}
+
+/**
+  * @brief  PendSV handler: save the current thread, restore kernel_next
+  * @param  None
+  * @note   Lowest priority, so it runs after all other handlers; the
+  *         hardware frame (r0-r3, r12, lr, pc, xpsr) is already on the PSP
+  * @retval None
+  */
+RAMFUNC __attribute__((naked)) void PendSV_Handler(void)
+{
+    __asm volatile (
+        "   cpsid   i                   \n"
+        "   mrs     r0, psp             \n"
+        "   stmdb   r0!, {r4-r11}       \n"
+        "   ldr     r1, =kernel_current \n"
+        "   ldr     r1, [r1]            \n"
+        "   str     r0, [r1]            \n"     /* current->sp */
+        "   mov     r4, lr              \n"
+        "   bl      Kernel_SwitchContext\n"     /* r0 = next thread's sp */
+        "   mov     lr, r4              \n"
+        "   ldmia   r0!, {r4-r11}       \n"
+        "   msr     psp, r0             \n"
+        "   cpsie   i                   \n"
+        "   bx      lr                  \n"
+        "   .ltorg                      \n"
+    );
+}
+
+/**
+  * @brief  Mark the kernel running and select the first thread
+  * @param  None
+  * @note   Called from SVC_Handler with interrupts disabled
+  * @retval Saved stack pointer of the first thread
+  */
+uint32_t *Kernel_Launch(void)
+{
+    kernel_running = 1;
+    kernel_next = kernel_ready[__builtin_ctz(kernel_ready_map)];
+
+    return Kernel_SwitchContext();
+}
+
+/**
+  * @brief  Make kernel_next the current thread
+  * @param  None
+  * @note   Called from PendSV_Handler with interrupts disabled
+  * @retval Saved stack pointer of the new current thread
+  */
+RAMFUNC uint32_t *Kernel_SwitchContext(void)
+{
+    Kernel_Thread_t *next = kernel_next;
+
+    if(next != kernel_current)
+    {
+        next->switches++;
+        kernel_switches++;
+    }
+    kernel_current = next;
+
+    return next->sp;
+}
+
+/**
+  * @brief  Add a thread to the ready list of its priority
+  * @param  thread: Thread not in any list
+  * @param  at_head: 1 = keep it running ahead of equal priorities
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void Kernel_ReadyAdd(Kernel_Thread_t *thread, uint8_t at_head)
+{
+    uint8_t priority = thread->priority;
+
+    if(kernel_ready[priority] == NULL)
+    {
+        thread->next = NULL;
+        kernel_ready[priority] = thread;
+        kernel_ready_tail[priority] = thread;
+    }
+    else if(at_head)
+    {
+        thread->next = kernel_ready[priority];
+        kernel_ready[priority] = thread;
+    }
+    else
+    {
+        thread->next = NULL;
+        kernel_ready_tail[priority]->next = thread;
+        kernel_ready_tail[priority] = thread;
+    }
+    kernel_ready_map |= 1UL << priority;
+}
+
+/**
+  * @brief  Remove a thread from its ready list
+  * @param  thread: Ready thread
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void Kernel_ReadyRemove(Kernel_Thread_t *thread)
+{
+    uint8_t priority = thread->priority;
+    Kernel_Thread_t **link = &kernel_ready[priority];
+    Kernel_Thread_t *prev = NULL;
+
+    while(*link != thread)
+    {
+        prev = *link;
+        link = &prev->next;
+    }
+    *link = thread->next;
+    thread->next = NULL;
+
+    if(kernel_ready_tail[priority] == thread)
+    {
+        kernel_ready_tail[priority] = prev;
+    }
+    if(kernel_ready[priority] == NULL)
+    {
+        kernel_ready_map &= ~(1UL << priority);
+    }
+}
+
+/**
+  * @brief  Insert a thread into a wait list, highest priority first
+  * @param  list: Wait list head
+  * @param  thread: Thread not in any list
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void Kernel_WaitInsert(Kernel_Thread_t **list, Kernel_Thread_t *thread)
+{
+    while(*list != NULL && (*list)->priority <= thread->priority)
+    {
+        list = &(*list)->next;
+    }
+    thread->next = *list;
+    *list = thread;
+}
+
+/**
+  * @brief  Remove a thread from a wait list
+  * @param  list: Wait list head
+  * @param  thread: Thread in the list
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void Kernel_WaitRemove(Kernel_Thread_t **list, Kernel_Thread_t *thread)
+{
+    while(*list != thread)
+    {
+        list = &(*list)->next;
+    }
+    *list = thread->next;
+    thread->next = NULL;
+}
+
+/**
+  * @brief  Select the highest-priority ready thread and request a switch
+  * @param  None
+  * @note   Call with interrupts disabled; the switch happens when no
+  *         other handler is active and interrupts are enabled
+  * @retval None
+  */
+static void Kernel_Schedule(void)
+{
+    Kernel_Thread_t *next;
+
+    if(!kernel_running)
+    {
+        return;
+    }
+
+    /* The idle thread is always ready */
+    next = kernel_ready[__builtin_ctz(kernel_ready_map)];
+    kernel_next = next;
+    if(next != kernel_current)
+    {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+}
+
+/**
+  * @brief  Check whether the caller may block
+  * @param  None
+  * @retval 1 = running thread, 0 = interrupt or before Kernel_Start()
+  */
+static uint8_t Kernel_CanBlock(void)
+{
+    return (kernel_running && __get_IPSR() == 0);
+}
+
+/**
+  * @brief  Take the calling thread off the ready list
+  * @param  list: Wait list to join, NULL for a plain sleep
+  * @param  timeout_ms: Wake with KERNEL_TIMEOUT after this time, or KERNEL_WAIT_FOREVER
+  * @note   Call with interrupts disabled, then Kernel_Schedule() and
+  *         re-enable interrupts; the thread continues once woken
+  * @retval None
+  */
+static void Kernel_Suspend(Kernel_Thread_t **list, uint32_t timeout_ms)
+{
+    Kernel_Thread_t *self = kernel_current;
+
+    Kernel_ReadyRemove(self);
+    self->state = KERNEL_BLOCKED;
+    self->result = KERNEL_TIMEOUT;
+    self->wait_list = list;
+    if(list != NULL)
+    {
+        Kernel_WaitInsert(list, self);
+    }
+    if(timeout_ms != KERNEL_WAIT_FOREVER)
+    {
+        SwTimer_Start(&self->timer, timeout_ms, 0);
+    }
+}
+
+/**
+  * @brief  Make a blocked thread ready
+  * @param  thread: Blocked thread
+  * @param  result: Value its blocking call returns
+  * @note   Call with interrupts disabled, then Kernel_Schedule()
+  * @retval None
+  */
+static void Kernel_Wake(Kernel_Thread_t *thread, Kernel_Status_t result)
+{
+    SwTimer_Stop(&thread->timer);
+    if(thread->wait_list != NULL)
+    {
+        Kernel_WaitRemove(thread->wait_list, thread);
+        thread->wait_list = NULL;
+    }
+    thread->result = result;
+    thread->state = KERNEL_READY;
+    Kernel_ReadyAdd(thread, 0);
+}
+
+/**
+  * @brief  Change the effective priority of a thread
+  * @param  thread: Any thread
+  * @param  priority: New effective priority
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void Kernel_SetPriority(Kernel_Thread_t *thread, uint8_t priority)
+{
+    if(thread->state == KERNEL_READY)
+    {
+        Kernel_ReadyRemove(thread);
+        thread->priority = priority;
+        Kernel_ReadyAdd(thread, thread == kernel_current);
+    }
+    else if(thread->wait_list != NULL)
+    {
+        Kernel_WaitRemove(thread->wait_list, thread);
+        thread->priority = priority;
+        Kernel_WaitInsert(thread->wait_list, thread);
+    }
+    else
+    {
+        thread->priority = priority;
+    }
+}
+
+/**
+  * @brief  Recompute inherited priority along a chain of mutex owners
+  * @param  thread: Mutex owner whose waiters changed
+  * @note   Call with interrupts disabled. A thread runs at the higher of
+  *         its base priority and its highest waiter on any held mutex.
+  * @retval None
+  */
+static void Kernel_UpdatePriority(Kernel_Thread_t *thread)
+{
+    Kernel_Mutex_t *mutex;
+    uint8_t priority;
+    uint8_t depth;
+
+    /* Depth bound guards against deadlocked (circular) chains */
+    for(depth = 0; thread != NULL && depth < KERNEL_PRIORITIES; depth++)
+    {
+        priority = thread->base_priority;
+        for(mutex = thread->held; mutex != NULL; mutex = mutex->next_held)
+        {
+            if(mutex->waiters != NULL && mutex->waiters->priority < priority)
+            {
+                priority = mutex->waiters->priority;
+            }
+        }
+
+        if(priority == thread->priority)
+        {
+            break;
+        }
+        Kernel_SetPriority(thread, priority);
+
+        thread = (thread->blocked_on != NULL) ? thread->blocked_on->owner : NULL;
+    }
+}
+
+/**
+  * @brief  Software timer callback: sleep or wait timeout expired
+  * @param  arg: Thread
+  * @note   Runs in SysTick_Handler
+  * @retval None
+  */
+static void Kernel_TimeoutCallback(void *arg)
+{
+    Kernel_Thread_t *thread = (Kernel_Thread_t *)arg;
+    Kernel_Mutex_t *mutex;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    /* A give in a higher-priority interrupt may have won the race */
+    if(thread->state == KERNEL_BLOCKED)
+    {
+        mutex = thread->blocked_on;
+        thread->blocked_on = NULL;
+        Kernel_Wake(thread, KERNEL_TIMEOUT);
+        if(mutex != NULL)
+        {
+            Kernel_UpdatePriority(mutex->owner);
+        }
+        Kernel_Schedule();
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Return address of every thread entry function
+  * @param  None
+  * @note   Mutexes still held stay locked
+  * @retval None
+  */
+static void Kernel_ThreadExit(void)
+{
+    __disable_irq();
+    Kernel_ReadyRemove(kernel_current);
+    kernel_current->state = KERNEL_EXITED;
+    Kernel_Schedule();
+    __enable_irq();
+
+    while(1)
+    {
+    }
+}
+
+/**
+  * @brief  Idle thread: deferred software timers, then sleep
+  * @param  arg: Unused
+  * @retval None
+  */
+static void Kernel_IdleThread(void *arg)
+{
+    (void)arg;
+
+    while(1)
+    {
+        SwTimer_Process();
+        Delay_Idle();
+    }
+}
@@ -30,6 +30,7 @@
 #include "gpio.h"
 #include "uart.h"
 #include "delay.h"
+#include "fault.h"
 
 /* Private function prototypes */
 static void RCC_Config(void);
@@ -44,8 +45,8 @@ int main(void)
 {
     uint32_t counter = 0;
     
-    /* Initialize system */
-    SystemInit();
+    /* Enable MemManage/BusFault/UsageFault (crash record in fault.c) */
+    Fault_Init();
     
     /* Configure peripherals */
     RCC_Config();
@@ -64,6 +65,12 @@ int main(void)
     UART_SendString(USART1, "========================================\r\n");
     UART_SendString(USART1, "System initialized successfully!\r\n\r\n");
     
+    /* Dump the fault that caused the last reset (once) */
+    if(Fault_Pending())
+    {
+        Fault_Print(USART1);
+    }
+    
     /* Main loop */
     while(1)
     {
@@ -114,20 +121,3 @@ static void GPIO_Config(void)
     /* Turn off LED initially (PC13 is active low) */
     GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET);
 }
-
-/**
-  * @brief  This function handles Hard Fault exception.
-  * @param  None
-  * @retval None
-  */
-void HardFault_Handler(void)
-{
-    /* Infinite loop for debugging */
-    while(1)
-    {
-        /* Toggle LED rapidly to indicate fault */
-        GPIO_TogglePin(GPIOC, GPIO_PIN_13);
-        for(volatile uint32_t i = 0; i < 100000; i++);
-    }
-}
-
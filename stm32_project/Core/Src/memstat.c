@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * @file    memstat.c
+  * @brief   Stack and heap usage: painting, high-water marks, guard words
+  ******************************************************************************
+  */
+
+#include "memstat.h"
+#include "kernel.h"
+#include "uart.h"
+#include "ramfunc.h"
+#include <stddef.h>
+#include <errno.h>
+
+/* Linker script symbols (addresses only) */
+extern uint8_t _end;                /* End of .bss, start of the heap */
+extern uint8_t _estack;             /* Top of the main stack */
+extern uint8_t _Min_Stack_Size;     /* Main stack reservation (value = address) */
+
+#define MEMSTAT_GUARD_BYTES     (MEMSTAT_GUARD_WORDS * 4)
+
+/* Heap break, NULL until the first _sbrk() */
+static uint8_t *memstat_brk = NULL;
+static uint8_t *memstat_brk_peak = NULL;
+static uint32_t memstat_heap_failures = 0;
+
+static volatile uint32_t memstat_overflows = 0;
+
+/* Private function prototypes */
+static uint32_t *MemStat_MainLimit(void);
+static uint8_t MemStat_GuardOk(const uint32_t *guard);
+static void MemStat_PrintStack(USART_TypeDef *USARTx, const char *name, const MemStat_Stack_t *stack);
+
+/**
+  * @brief  Grow the heap (newlib malloc back end)
+  * @param  incr: Bytes to add to the break
+  * @note   Stops below the guard words of the reserved main stack
+  * @retval Previous break, or (void *)-1 with errno = ENOMEM
+  */
+void *_sbrk(ptrdiff_t incr)
+{
+    uint8_t *limit = (uint8_t *)MemStat_MainLimit() - MEMSTAT_GUARD_BYTES;
+    uint8_t *prev;
+
+    if(memstat_brk == NULL)
+    {
+        memstat_brk = &_end;
+        memstat_brk_peak = &_end;
+    }
+
+    if(memstat_brk + incr > limit)
+    {
+        memstat_heap_failures++;
+        errno = ENOMEM;
+        return (void *)-1;
+    }
+
+    prev = memstat_brk;
+    memstat_brk += incr;
+    if(memstat_brk > memstat_brk_peak)
+    {
+        memstat_brk_peak = memstat_brk;
+    }
+
+    return prev;
+}
+
+/**
+  * @brief  High-water mark of the main stack (MSP)
+  * @param  stack: Destination; size is the _Min_Stack_Size reservation
+  * @note   Scans from the peak heap break up to _estack, so it takes a few
+  *         hundred microseconds; used may exceed size if the stack grew
+  *         past its reservation into free RAM
+  * @retval None
+  */
+void MemStat_GetMainStack(MemStat_Stack_t *stack)
+{
+    const uint32_t *p;
+    const uint32_t *top = (const uint32_t *)&_estack;
+
+    p = (memstat_brk_peak != NULL) ? (const uint32_t *)(((uint32_t)memstat_brk_peak + 3) & ~3UL)
+                                   : (const uint32_t *)&_end;
+    while(p < top && *p == MEMSTAT_PAINT)
+    {
+        p++;
+    }
+
+    stack->size = (uint32_t)&_Min_Stack_Size;
+    stack->used = (uint32_t)top - (uint32_t)p;
+    stack->guard_ok = MemStat_GuardOk(MemStat_MainLimit() - MEMSTAT_GUARD_WORDS);
+}
+
+/**
+  * @brief  High-water mark of a painted stack
+  * @param  bottom: Lowest address of the stack
+  * @param  size: Stack size in bytes
+  * @param  stack: Destination
+  * @note   The stack must have been painted with MemStat_Paint() (kernel
+  *         threads are); the guard words are its lowest words
+  * @retval None
+  */
+void MemStat_GetStack(const uint32_t *bottom, uint32_t size, MemStat_Stack_t *stack)
+{
+    const uint32_t *p = bottom;
+    const uint32_t *top = bottom + size / 4;
+
+    while(p < top && *p == MEMSTAT_PAINT)
+    {
+        p++;
+    }
+
+    stack->size = size;
+    stack->used = (uint32_t)top - (uint32_t)p;
+    stack->guard_ok = (size >= MEMSTAT_GUARD_BYTES) ? MemStat_GuardOk(bottom) : 0;
+}
+
+/**
+  * @brief  Heap break statistics
+  * @param  heap: Destination
+  * @note   Memory freed back to malloc stays below the break, so this is
+  *         the RAM the heap has claimed, not the bytes currently allocated
+  * @retval None
+  */
+void MemStat_GetHeap(MemStat_Heap_t *heap)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    heap->used = (memstat_brk != NULL) ? (uint32_t)(memstat_brk - &_end) : 0;
+    heap->peak = (memstat_brk_peak != NULL) ? (uint32_t)(memstat_brk_peak - &_end) : 0;
+    heap->limit = (uint32_t)((uint8_t *)MemStat_MainLimit() - MEMSTAT_GUARD_BYTES - &_end);
+    heap->failures = memstat_heap_failures;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Number of overwritten guards found by MemStat_Check()
+  * @param  None
+  * @retval Overflow count since reset
+  */
+uint32_t MemStat_GetOverflows(void)
+{
+    return memstat_overflows;
+}
+
+/**
+  * @brief  Fill a stack with the paint pattern
+  * @param  bottom: Lowest address of the stack
+  * @param  size: Stack size in bytes
+  * @note   Only for a stack that is not in use
+  * @retval None
+  */
+void MemStat_Paint(uint32_t *bottom, uint32_t size)
+{
+    uint32_t i;
+
+    for(i = 0; i < size / 4; i++)
+    {
+        bottom[i] = MEMSTAT_PAINT;
+    }
+}
+
+/**
+  * @brief  Check the guard words of the main stack and all kernel threads
+  * @param  None
+  * @note   Called from SysTick_Handler when MEMSTAT_GUARD_CHECK is 1. An
+  *         overwritten guard is counted, reported and repainted, so the
+  *         next overflow of the same stack is seen again.
+  * @retval None
+  */
+RAMFUNC void MemStat_Check(void)
+{
+    uint32_t *guard;
+    Kernel_Thread_t *thread;
+    uint8_t i;
+
+    guard = MemStat_MainLimit() - MEMSTAT_GUARD_WORDS;
+    if(!MemStat_GuardOk(guard))
+    {
+        memstat_overflows++;
+        for(i = 0; i < MEMSTAT_GUARD_WORDS; i++)
+        {
+            guard[i] = MEMSTAT_PAINT;
+        }
+        MemStat_OverflowHook("main");
+    }
+
+    for(thread = Kernel_GetThreads(); thread != NULL; thread = thread->link)
+    {
+        if(thread->stack_size >= MEMSTAT_GUARD_BYTES && !MemStat_GuardOk(thread->stack))
+        {
+            memstat_overflows++;
+            for(i = 0; i < MEMSTAT_GUARD_WORDS; i++)
+            {
+                thread->stack[i] = MEMSTAT_PAINT;
+            }
+            MemStat_OverflowHook(thread->name);
+        }
+    }
+}
+
+/**
+  * @brief  Print main stack, heap and kernel thread stack usage
+  * @param  USARTx: USART peripheral
+  * @retval None
+  */
+void MemStat_Print(USART_TypeDef *USARTx)
+{
+    MemStat_Stack_t stack;
+    MemStat_Heap_t heap;
+    Kernel_Thread_t *thread;
+
+    MemStat_GetMainStack(&stack);
+    MemStat_PrintStack(USARTx, "main (MSP)", &stack);
+
+    for(thread = Kernel_GetThreads(); thread != NULL; thread = thread->link)
+    {
+        MemStat_GetStack(thread->stack, thread->stack_size, &stack);
+        MemStat_PrintStack(USARTx, thread->name, &stack);
+    }
+
+    MemStat_GetHeap(&heap);
+    UART_Printf(USARTx, "heap         %5lu / %5lu B (peak %lu, failed %lu)\r\n",
+                heap.used, heap.limit, heap.peak, heap.failures);
+    UART_Printf(USARTx, "overflows    %lu\r\n", memstat_overflows);
+}
+
+/**
+  * @brief  Called by MemStat_Check() for every overwritten guard
+  * @param  name: "main" or the kernel thread name
+  * @note   Runs in SysTick_Handler. Weak: override to log, stop or reset.
+  * @retval None
+  */
+__attribute__((weak)) void MemStat_OverflowHook(const char *name)
+{
+    (void)name;
+}
+
+/**
+  * @brief  Lowest address of the reserved main stack
+  * @param  None
+  * @retval _estack - _Min_Stack_Size
+  */
+RAMFUNC static uint32_t *MemStat_MainLimit(void)
+{
+    return (uint32_t *)((uint32_t)&_estack - (uint32_t)&_Min_Stack_Size);
+}
+
+/**
+  * @brief  Check that the guard words still hold the paint pattern
+  * @param  guard: First guard word
+  * @retval 1 = intact, 0 = overwritten
+  */
+RAMFUNC static uint8_t MemStat_GuardOk(const uint32_t *guard)
+{
+    uint8_t i;
+
+    for(i = 0; i < MEMSTAT_GUARD_WORDS; i++)
+    {
+        if(guard[i] != MEMSTAT_PAINT)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+  * @brief  Print one stack line
+  * @param  USARTx: USART peripheral
+  * @param  name: Stack name
+  * @param  stack: Usage
+  * @retval None
+  */
+static void MemStat_PrintStack(USART_TypeDef *USARTx, const char *name, const MemStat_Stack_t *stack)
+{
+    UART_Printf(USARTx, "%-12s %5lu / %5lu B (%3lu%%)%s\r\n",
+                name, stack->used, stack->size,
+                (stack->size != 0) ? stack->used * 100 / stack->size : 0,
+                stack->guard_ok ? "" : "  GUARD OVERWRITTEN");
+}
@@ -0,0 +1,403 @@
+/**
+  ******************************************************************************
+  * @file    monitor.c
+  * @brief   Runtime monitor: CPU load, interrupt latency/jitter, loop WCET
+  ******************************************************************************
+  */
+
+#include "monitor.h"
+
+#if MONITOR_ENABLE
+
+#include "system_stm32f1xx.h"
+#include "delay.h"
+#include "uart.h"
+#include "clock.h"
+#include "ramfunc.h"
+#include <stddef.h>
+
+/* Values below this land in bin 0 */
+#define MONITOR_BIN0_LIMIT      16
+
+static Monitor_Stats_t monitor_stats;
+static Monitor_IsrStats_t monitor_isr[MONITOR_SOURCES] =
+{
+    [MONITOR_SRC_SYSTICK] = { "systick" },
+    [MONITOR_SRC_LCD] = { "tim4 lcd" },
+    [MONITOR_SRC_BUTTON] = { "tim1 button" },
+};
+
+/* Current load window */
+static uint64_t monitor_window_start = 0;
+static uint64_t monitor_window_sleep = 0;
+
+/* Main loop: start of the current iteration */
+static uint64_t monitor_loop_start = 0;
+static uint64_t monitor_loop_sleep = 0;
+static uint8_t monitor_loop_valid = 0;
+
+static Clock_Notifier_t monitor_clock_notifier;
+
+/* Private function prototypes */
+static uint8_t Monitor_Bin(uint32_t cycles);
+static uint32_t Monitor_BinStart(uint8_t bin);
+static void Monitor_PrintHist(USART_TypeDef *USARTx, const char *label, const uint32_t *hist);
+static void Monitor_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg);
+
+/**
+  * @brief  Start the first load window and clear all statistics
+  * @param  None
+  * @note   Call after Delay_Init()
+  * @retval None
+  */
+void Monitor_Init(void)
+{
+    Monitor_Reset();
+
+    if(monitor_clock_notifier.callback == NULL)
+    {
+        Clock_Register(&monitor_clock_notifier, Monitor_ClockChanged, NULL);
+    }
+}
+
+/**
+  * @brief  Record the latency of an interrupt entry
+  * @param  source: Source number (0 .. MONITOR_SOURCES - 1)
+  * @param  latency: Cycles from the hardware event to the handler
+  * @note   Use MONITOR_ISR_ENTRY() so the call compiles out when disabled
+  * @retval None
+  */
+RAMFUNC void Monitor_IsrEntry(uint8_t source, uint32_t latency)
+{
+    Monitor_IsrStats_t *s;
+    uint32_t jitter;
+    uint32_t primask;
+
+    if(source >= MONITOR_SOURCES)
+    {
+        return;
+    }
+    s = &monitor_isr[source];
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if(s->count != 0)
+    {
+        jitter = (latency > s->last) ? latency - s->last : s->last - latency;
+        s->jitter_hist[Monitor_Bin(jitter)]++;
+        if(jitter > s->jitter_max)
+        {
+            s->jitter_max = jitter;
+        }
+    }
+    s->last = latency;
+    s->count++;
+    s->total += latency;
+    if(latency < s->min)
+    {
+        s->min = latency;
+    }
+    if(latency > s->max)
+    {
+        s->max = latency;
+    }
+    s->latency_hist[Monitor_Bin(latency)]++;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Close the load window once it is MONITOR_WINDOW_MS long
+  * @param  now: Delay_GetTimestamp() value
+  * @note   Called from SysTick_Handler. A tickless sleep may stretch a
+  *         window; the load is computed over its real length.
+  * @retval None
+  */
+RAMFUNC void Monitor_Tick(uint64_t now)
+{
+    Delay_IdleStats_t idle;
+    uint64_t elapsed;
+    uint64_t sleep;
+    uint32_t load;
+
+    elapsed = now - monitor_window_start;
+    if(elapsed < (uint64_t)(SystemCoreClock / 1000) * MONITOR_WINDOW_MS)
+    {
+        return;
+    }
+
+    Delay_GetIdleStats(&idle);
+    sleep = idle.sleep_cycles - monitor_window_sleep;
+    if(idle.sleep_cycles < monitor_window_sleep || sleep > elapsed)
+    {
+        /* Idle statistics were reset during the window */
+        sleep = 0;
+    }
+
+    load = (uint32_t)((elapsed - sleep) * 1000 / elapsed);
+    monitor_stats.load = (uint16_t)load;
+    if(load > monitor_stats.load_peak)
+    {
+        monitor_stats.load_peak = (uint16_t)load;
+    }
+    monitor_stats.windows++;
+
+    monitor_window_start = now;
+    monitor_window_sleep = idle.sleep_cycles;
+}
+
+/**
+  * @brief  Mark the start of a main loop iteration
+  * @param  None
+  * @note   The time since the previous mark minus the time slept in
+  *         between is the busy time of the previous iteration
+  * @retval None
+  */
+void Monitor_LoopMark(void)
+{
+    Delay_IdleStats_t idle;
+    uint64_t now;
+    uint64_t busy;
+    uint64_t sleep;
+
+    now = Delay_GetTimestamp();
+    Delay_GetIdleStats(&idle);
+
+    if(monitor_loop_valid && idle.sleep_cycles >= monitor_loop_sleep)
+    {
+        busy = now - monitor_loop_start;
+        sleep = idle.sleep_cycles - monitor_loop_sleep;
+        busy = (sleep < busy) ? busy - sleep : 0;
+        if(busy > 0xFFFFFFFFUL)
+        {
+            busy = 0xFFFFFFFFUL;
+        }
+
+        monitor_stats.loop_count++;
+        monitor_stats.loop_total += busy;
+        if(busy > monitor_stats.loop_max)
+        {
+            monitor_stats.loop_max = (uint32_t)busy;
+        }
+    }
+
+    monitor_loop_start = now;
+    monitor_loop_sleep = idle.sleep_cycles;
+    monitor_loop_valid = 1;
+}
+
+/**
+  * @brief  Name a user source for Monitor_Print()
+  * @param  source: Source number
+  * @param  name: Static string
+  * @retval None
+  */
+void Monitor_SetName(uint8_t source, const char *name)
+{
+    if(source < MONITOR_SOURCES)
+    {
+        monitor_isr[source].name = name;
+    }
+}
+
+/**
+  * @brief  Copy the load and main loop statistics
+  * @param  stats: Destination
+  * @retval None
+  */
+void Monitor_GetStats(Monitor_Stats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *stats = monitor_stats;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Copy the statistics of an interrupt source
+  * @param  source: Source number
+  * @param  stats: Destination (count 0 = never recorded)
+  * @retval None
+  */
+void Monitor_GetIsrStats(uint8_t source, Monitor_IsrStats_t *stats)
+{
+    uint32_t primask;
+
+    if(source >= MONITOR_SOURCES)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = monitor_isr[source];
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear all statistics and start a new load window
+  * @param  None
+  * @note   Source names are kept
+  * @retval None
+  */
+void Monitor_Reset(void)
+{
+    Delay_IdleStats_t idle;
+    uint32_t primask = __get_PRIMASK();
+    uint8_t i;
+    uint8_t b;
+
+    __disable_irq();
+    Delay_GetIdleStats(&idle);
+    monitor_window_start = Delay_GetTimestamp();
+    monitor_window_sleep = idle.sleep_cycles;
+    monitor_loop_valid = 0;
+
+    monitor_stats.load = 0;
+    monitor_stats.load_peak = 0;
+    monitor_stats.windows = 0;
+    monitor_stats.loop_count = 0;
+    monitor_stats.loop_max = 0;
+    monitor_stats.loop_total = 0;
+
+    for(i = 0; i < MONITOR_SOURCES; i++)
+    {
+        monitor_isr[i].count = 0;
+        monitor_isr[i].min = 0xFFFFFFFFUL;
+        monitor_isr[i].max = 0;
+        monitor_isr[i].total = 0;
+        monitor_isr[i].jitter_max = 0;
+        monitor_isr[i].last = 0;
+        for(b = 0; b < MONITOR_HIST_BINS; b++)
+        {
+            monitor_isr[i].latency_hist[b] = 0;
+            monitor_isr[i].jitter_hist[b] = 0;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Print load, main loop and interrupt statistics
+  * @param  USARTx: USART peripheral
+  * @note   Times in cycles, with microseconds where they are large
+  * @retval None
+  */
+void Monitor_Print(USART_TypeDef *USARTx)
+{
+    Monitor_Stats_t stats;
+    Monitor_IsrStats_t isr;
+    uint32_t avg = 0;
+    uint8_t i;
+
+    Monitor_GetStats(&stats);
+    if(stats.loop_count != 0)
+    {
+        avg = (uint32_t)(stats.loop_total / stats.loop_count);
+    }
+
+    UART_Printf(USARTx, "CPU load %u.%u%% (peak %u.%u%%)\r\n",
+                stats.load / 10, stats.load % 10, stats.load_peak / 10, stats.load_peak % 10);
+    UART_Printf(USARTx, "main loop n=%lu avg %lu max %lu cycles (max %lu us)\r\n",
+                stats.loop_count, avg, stats.loop_max, Delay_CyclesToUs(stats.loop_max));
+
+    for(i = 0; i < MONITOR_SOURCES; i++)
+    {
+        Monitor_GetIsrStats(i, &isr);
+        if(isr.count == 0)
+        {
+            continue;
+        }
+
+        if(isr.name != NULL)
+        {
+            UART_Printf(USARTx, "%s", isr.name);
+        }
+        else
+        {
+            UART_Printf(USARTx, "source %u", i);
+        }
+        UART_Printf(USARTx, ": n=%lu latency min %lu avg %lu max %lu, jitter max %lu cycles\r\n",
+                    isr.count, isr.min, (uint32_t)(isr.total / isr.count), isr.max, isr.jitter_max);
+        Monitor_PrintHist(USARTx, "  latency", isr.latency_hist);
+        Monitor_PrintHist(USARTx, "  jitter ", isr.jitter_hist);
+    }
+}
+
+/**
+  * @brief  Histogram bin of a cycle count
+  * @param  cycles: Latency or jitter
+  * @retval Bin number
+  */
+RAMFUNC static uint8_t Monitor_Bin(uint32_t cycles)
+{
+    uint32_t bin;
+
+    if(cycles < MONITOR_BIN0_LIMIT)
+    {
+        return 0;
+    }
+
+    /* 16..31 -> 1, 32..63 -> 2, ... */
+    bin = 32 - __builtin_clz(cycles) - 4;
+
+    return (bin < MONITOR_HIST_BINS) ? (uint8_t)bin : MONITOR_HIST_BINS - 1;
+}
+
+/**
+  * @brief  Lowest cycle count of a histogram bin
+  * @param  bin: Bin number
+  * @retval Cycles
+  */
+static uint32_t Monitor_BinStart(uint8_t bin)
+{
+    return (bin == 0) ? 0 : (1UL << (bin + 3));
+}
+
+/**
+  * @brief  Print the non-empty bins of a histogram as "from:count"
+  * @param  USARTx: USART peripheral
+  * @param  label: Line prefix
+  * @param  hist: MONITOR_HIST_BINS counters
+  * @retval None
+  */
+static void Monitor_PrintHist(USART_TypeDef *USARTx, const char *label, const uint32_t *hist)
+{
+    uint8_t b;
+
+    UART_Printf(USARTx, "%s", label);
+    for(b = 0; b < MONITOR_HIST_BINS; b++)
+    {
+        if(hist[b] != 0)
+        {
+            UART_Printf(USARTx, " %lu:%lu", Monitor_BinStart(b), hist[b]);
+        }
+    }
+    UART_Printf(USARTx, "\r\n");
+}
+
+/**
+  * @brief  Restart the load window and the main loop measurement
+  * @param  event: CLOCK_EVENT_PRE or CLOCK_EVENT_POST
+  * @param  freq: Clock tree
+  * @param  arg: Unused
+  * @note   Runs after the delay clock was rescaled. Recorded statistics
+  *         stay in cycles of the clock they were taken at.
+  * @retval None
+  */
+static void Monitor_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg)
+{
+    Delay_IdleStats_t idle;
+
+    if(event != CLOCK_EVENT_POST)
+    {
+        return;
+    }
+
+    Delay_GetIdleStats(&idle);
+    monitor_window_start = Delay_GetTimestamp();
+    monitor_window_sleep = idle.sleep_cycles;
+    monitor_loop_valid = 0;
+}
+
+#endif /* MONITOR_ENABLE */
@@ -0,0 +1,189 @@
+/**
+  ******************************************************************************
+  * @file    profile.c
+  * @brief   Cycle-accurate profiling zones based on the DWT cycle counter
+  ******************************************************************************
+  */
+
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+#include "uart.h"
+#include "delay.h"
+#include <stddef.h>
+
+/* Zone table, indexed by zone number */
+static Profile_Stats_t profile_zones[PROFILE_MAX_ZONES] =
+{
+    [PROFILE_ZONE_UART_PRINTF] = { "UART_Printf" },
+    [PROFILE_ZONE_ADC_READ]    = { "ADC_Read" },
+    [PROFILE_ZONE_LCD_PRINTF]  = { "LCD1602_Printf" },
+    [PROFILE_ZONE_PWM_DUTY]    = { "PWM_SetDutyCycle" },
+};
+
+/* Cycles an empty PROFILE_SCOPE() measures, subtracted from every run */
+static uint32_t profile_overhead = 0;
+
+/**
+  * @brief  Start the cycle counter and calibrate the measurement overhead
+  * @param  None
+  * @note   Call once after SystemInit() and before the first zone runs;
+  *         clears all zones
+  * @retval None
+  */
+void Profile_Init(void)
+{
+    uint32_t best = 0xFFFFFFFFUL;
+    uint8_t i;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Shortest of several runs, an interrupt may hit any one of them */
+    profile_overhead = 0;
+    Profile_Reset();
+    for(i = 0; i < 8; i++)
+    {
+        {
+            PROFILE_SCOPE(PROFILE_ZONE_USER - 1);
+        }
+        if(profile_zones[PROFILE_ZONE_USER - 1].min < best)
+        {
+            best = profile_zones[PROFILE_ZONE_USER - 1].min;
+        }
+    }
+    profile_overhead = best;
+
+    Profile_Reset();
+}
+
+/**
+  * @brief  Add one run to a zone
+  * @param  zone: Zone number (0 .. PROFILE_MAX_ZONES - 1)
+  * @param  cycles: Measured cycles, including the scope overhead
+  * @note   Safe from interrupts
+  * @retval None
+  */
+void Profile_Record(uint8_t zone, uint32_t cycles)
+{
+    Profile_Stats_t *z;
+    uint32_t primask;
+
+    if(zone >= PROFILE_MAX_ZONES)
+    {
+        return;
+    }
+    z = &profile_zones[zone];
+
+    cycles = (cycles > profile_overhead) ? cycles - profile_overhead : 0;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    z->count++;
+    z->total += cycles;
+    if(cycles < z->min)
+    {
+        z->min = cycles;
+    }
+    if(cycles > z->max)
+    {
+        z->max = cycles;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Name a user zone for Profile_Dump()
+  * @param  zone: Zone number
+  * @param  name: Static string
+  * @retval None
+  */
+void Profile_SetName(uint8_t zone, const char *name)
+{
+    if(zone < PROFILE_MAX_ZONES)
+    {
+        profile_zones[zone].name = name;
+    }
+}
+
+/**
+  * @brief  Copy the statistics of a zone
+  * @param  zone: Zone number
+  * @param  stats: Destination (count 0 = never run)
+  * @retval None
+  */
+void Profile_GetStats(uint8_t zone, Profile_Stats_t *stats)
+{
+    uint32_t primask;
+
+    if(zone >= PROFILE_MAX_ZONES)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = profile_zones[zone];
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear all zones (names are kept)
+  * @param  None
+  * @retval None
+  */
+void Profile_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint8_t i;
+
+    __disable_irq();
+    for(i = 0; i < PROFILE_MAX_ZONES; i++)
+    {
+        profile_zones[i].count = 0;
+        profile_zones[i].min = 0xFFFFFFFFUL;
+        profile_zones[i].max = 0;
+        profile_zones[i].total = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Print every zone that has run
+  * @param  USARTx: USART peripheral
+  * @note   Each zone is copied before printing, so the output itself only
+  *         shows up in the UART_Printf zone of the next dump
+  * @retval None
+  */
+void Profile_Dump(USART_TypeDef *USARTx)
+{
+    Profile_Stats_t z;
+    uint32_t avg;
+    uint8_t i;
+
+    UART_Printf(USARTx, "zone                count      min      avg      max  avg us\r\n");
+
+    for(i = 0; i < PROFILE_MAX_ZONES; i++)
+    {
+        Profile_GetStats(i, &z);
+        if(z.count == 0)
+        {
+            continue;
+        }
+
+        avg = (uint32_t)(z.total / z.count);
+        if(z.name != NULL)
+        {
+            UART_Printf(USARTx, "%-16s", z.name);
+        }
+        else
+        {
+            UART_Printf(USARTx, "zone %-11u", i);
+        }
+        UART_Printf(USARTx, " %8lu %8lu %8lu %8lu %7lu\r\n",
+                    z.count, z.min, avg, z.max, Delay_CyclesToUs(avg));
+    }
+}
+
+#endif /* PROFILE_ENABLE */
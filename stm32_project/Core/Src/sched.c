@@ -0,0 +1,364 @@
+/**
+  ******************************************************************************
+  * @file    sched.c
+  * @brief   Cooperative run-to-completion scheduler with priorities
+  ******************************************************************************
+  */
+
+#include "sched.h"
+#include "system_stm32f1xx.h"
+#include "delay.h"
+#include "monitor.h"
+#include "boot.h"
+#include <stddef.h>
+
+#define SCHED_MASK              (SCHED_QUEUE_LEN - 1)
+
+/* Registered tasks, highest priority first */
+static Sched_Task_t *sched_list = NULL;
+
+/* Private function prototypes */
+static uint32_t Sched_Now(void);
+static void Sched_AtomicInc(volatile uint32_t *value);
+static void Sched_Rotate(Sched_Task_t *prev, Sched_Task_t *task);
+static void Sched_TimerCallback(void *arg);
+static uint8_t Sched_IsReady(void);
+
+/**
+  * @brief  Initialize a task and add it to the run list
+  * @param  task: Caller-owned task (static or long-lived), not yet registered
+  * @param  name: Name for statistics output
+  * @param  handler: Called once per event from the main loop
+  * @param  arg: Argument passed to the handler
+  * @param  priority: 0 (highest) .. SCHED_PRIORITIES - 1
+  * @retval None
+  */
+void Sched_TaskInit(Sched_Task_t *task, const char *name, Sched_Handler_t handler,
+                    void *arg, uint8_t priority)
+{
+    Sched_Task_t **link;
+    uint8_t i;
+
+    if(priority >= SCHED_PRIORITIES)
+    {
+        priority = SCHED_PRIORITIES - 1;
+    }
+
+    task->name = name;
+    task->handler = handler;
+    task->arg = arg;
+    task->priority = priority;
+    task->deadline = 0;
+    task->head = 0;
+    task->tail = 0;
+    for(i = 0; i < SCHED_QUEUE_LEN; i++)
+    {
+        task->valid[i] = 0;
+    }
+    task->timer_event = 0;
+    SwTimer_Init(&task->timer, Sched_TimerCallback, task, SWTIMER_ISR);
+    Sched_ResetStats(task);
+
+    /* Behind the tasks of the same priority */
+    link = &sched_list;
+    while(*link != NULL && (*link)->priority <= priority)
+    {
+        link = &(*link)->next;
+    }
+    task->next = *link;
+    *link = task;
+}
+
+/**
+  * @brief  Set the post-to-completion deadline of a task
+  * @param  task: Initialized task
+  * @param  deadline_us: Deadline in microseconds, 0 = none
+  * @note   Completions after the deadline are counted in deadline_misses
+  * @retval None
+  */
+void Sched_SetDeadline(Sched_Task_t *task, uint32_t deadline_us)
+{
+    task->deadline = deadline_us * (SystemCoreClock / 1000000);
+}
+
+/**
+  * @brief  Queue an event for a task
+  * @param  task: Initialized task
+  * @param  event: Value passed to the handler
+  * @note   Lock-free queue; safe from any interrupt priority and from tasks.
+  *         The time stamp masks interrupts for a few cycles.
+  * @retval SUCCESS, or ERROR if the queue is full (counted in dropped)
+  */
+ErrorStatus Sched_Post(Sched_Task_t *task, uint32_t event)
+{
+    uint32_t head;
+    uint32_t slot;
+
+    /* Reserve a slot; an interrupting post simply takes the next one */
+    do
+    {
+        head = __LDREXW(&task->head);
+        if(head - task->tail >= SCHED_QUEUE_LEN)
+        {
+            __CLREX();
+            Sched_AtomicInc(&task->stats.dropped);
+            return ERROR;
+        }
+    } while(__STREXW(head + 1, &task->head) != 0);
+
+    slot = head & SCHED_MASK;
+    task->event[slot] = event;
+    task->stamp[slot] = Sched_Now();
+    task->valid[slot] = 1;
+
+    return SUCCESS;
+}
+
+/**
+  * @brief  Post an event to a task periodically
+  * @param  task: Initialized task
+  * @param  delay_ms: Time to the first post
+  * @param  period_ms: Post period, 0 = once
+  * @param  event: Value posted
+  * @retval None
+  */
+void Sched_StartPeriodic(Sched_Task_t *task, uint32_t delay_ms, uint32_t period_ms, uint32_t event)
+{
+    task->timer_event = event;
+    SwTimer_Start(&task->timer, delay_ms, period_ms);
+}
+
+/**
+  * @brief  Stop the periodic posts of a task
+  * @param  task: Initialized task
+  * @note   Events already queued still run
+  * @retval None
+  */
+void Sched_StopPeriodic(Sched_Task_t *task)
+{
+    SwTimer_Stop(&task->timer);
+}
+
+/**
+  * @brief  Run one event of the highest-priority ready task
+  * @param  None
+  * @retval 1 = a handler ran, 0 = nothing was ready
+  */
+uint8_t Sched_RunOne(void)
+{
+    Sched_Task_t *task;
+    Sched_Task_t *prev = NULL;
+    uint32_t slot;
+    uint32_t event;
+    uint32_t stamp;
+    uint32_t start;
+    uint32_t end;
+    uint32_t exec;
+    uint32_t latency;
+
+    for(task = sched_list; task != NULL; prev = task, task = task->next)
+    {
+        if(task->tail != task->head)
+        {
+            break;
+        }
+    }
+    if(task == NULL)
+    {
+        return 0;
+    }
+
+    /* A reserved slot is always filled before its producer returns */
+    slot = task->tail & SCHED_MASK;
+    if(!task->valid[slot])
+    {
+        return 0;
+    }
+    event = task->event[slot];
+    stamp = task->stamp[slot];
+    task->valid[slot] = 0;
+    task->tail++;
+
+    Sched_Rotate(prev, task);
+
+    start = Sched_Now();
+    task->handler(event, task->arg);
+    end = Sched_Now();
+
+    exec = end - start;
+    latency = end - stamp;
+
+    task->stats.runs++;
+    task->stats.exec_total += exec;
+    if(exec > task->stats.exec_max)
+    {
+        task->stats.exec_max = exec;
+    }
+    if(latency > task->stats.latency_max)
+    {
+        task->stats.latency_max = latency;
+    }
+    if(task->deadline != 0 && latency > task->deadline)
+    {
+        task->stats.deadline_misses++;
+    }
+
+    return 1;
+}
+
+/**
+  * @brief  Scheduler main loop
+  * @param  None
+  * @note   Runs deferred software timers and task events; sleeps in
+  *         Delay_Idle() when there is nothing to do. Each iteration is one
+  *         main loop pass for Monitor_LoopMark(). Marks the "sched_run"
+  *         boot checkpoint on entry. Never returns.
+  * @retval None
+  */
+void Sched_Run(void)
+{
+    BOOT_CHECKPOINT("sched_run");
+
+    while(1)
+    {
+        Monitor_LoopMark();
+        SwTimer_Process();
+
+        if(Sched_RunOne())
+        {
+            continue;
+        }
+
+        /* A post between the check and WFI still ends the sleep */
+        __disable_irq();
+        if(!Sched_IsReady())
+        {
+            Delay_Idle();
+        }
+        __enable_irq();
+    }
+}
+
+/**
+  * @brief  Copy the statistics of a task
+  * @param  task: Initialized task
+  * @param  stats: Destination
+  * @retval None
+  */
+void Sched_GetStats(Sched_Task_t *task, Sched_Stats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *stats = task->stats;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear the statistics of a task
+  * @param  task: Initialized task
+  * @retval None
+  */
+void Sched_ResetStats(Sched_Task_t *task)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    task->stats.runs = 0;
+    task->stats.dropped = 0;
+    task->stats.deadline_misses = 0;
+    task->stats.exec_max = 0;
+    task->stats.latency_max = 0;
+    task->stats.exec_total = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Time stamp for statistics
+  * @param  None
+  * @note   Low half of the 64-bit clock: keeps counting in sleep, wraps
+  *         after about 60 s at 72 MHz, differences stay correct
+  * @retval Core clock cycles
+  */
+static uint32_t Sched_Now(void)
+{
+    return (uint32_t)Delay_GetTimestamp();
+}
+
+/**
+  * @brief  Atomically increment a counter shared with interrupts
+  * @param  value: Counter
+  * @retval None
+  */
+static void Sched_AtomicInc(volatile uint32_t *value)
+{
+    uint32_t old;
+
+    do
+    {
+        old = __LDREXW(value);
+    } while(__STREXW(old + 1, value) != 0);
+}
+
+/**
+  * @brief  Move a task behind the other tasks of its priority
+  * @param  prev: Task before it in the run list, NULL if first
+  * @param  task: Task that is about to run
+  * @retval None
+  */
+static void Sched_Rotate(Sched_Task_t *prev, Sched_Task_t *task)
+{
+    Sched_Task_t *last = task;
+
+    while(last->next != NULL && last->next->priority == task->priority)
+    {
+        last = last->next;
+    }
+    if(last == task)
+    {
+        return;
+    }
+
+    if(prev != NULL)
+    {
+        prev->next = task->next;
+    }
+    else
+    {
+        sched_list = task->next;
+    }
+    task->next = last->next;
+    last->next = task;
+}
+
+/**
+  * @brief  Software timer callback of Sched_StartPeriodic()
+  * @param  arg: Task
+  * @retval None
+  */
+static void Sched_TimerCallback(void *arg)
+{
+    Sched_Task_t *task = (Sched_Task_t *)arg;
+
+    Sched_Post(task, task->timer_event);
+}
+
+/**
+  * @brief  Check whether any task has an event queued
+  * @param  None
+  * @retval 1 = ready, 0 = idle
+  */
+static uint8_t Sched_IsReady(void)
+{
+    Sched_Task_t *task;
+
+    for(task = sched_list; task != NULL; task = task->next)
+    {
+        if(task->tail != task->head)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
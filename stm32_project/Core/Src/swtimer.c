@@ -0,0 +1,415 @@
+/**
+  ******************************************************************************
+  * @file    swtimer.c
+  * @brief   Software timers on a hierarchical timer wheel driven by SysTick
+  ******************************************************************************
+  */
+
+#include "swtimer.h"
+#include "ramfunc.h"
+#include <stddef.h>
+
+#define SWTIMER_MASK            (SWTIMER_SLOTS - 1)
+
+/* Ticks covered by levels 0..level */
+#define SWTIMER_RANGE(level)    (1UL << (SWTIMER_SLOT_BITS * ((level) + 1)))
+
+#if SWTIMER_SLOT_BITS * SWTIMER_LEVELS > 30
+#error "SWTIMER_SLOT_BITS * SWTIMER_LEVELS must not exceed 30"
+#endif
+
+/* Slot list heads */
+static SwTimer_t *swtimer_wheel[SWTIMER_LEVELS][SWTIMER_SLOTS];
+
+/* Expired SWTIMER_DEFERRED timers waiting for SwTimer_Process() */
+static SwTimer_t *swtimer_pending = NULL;
+
+/* Next tick to be processed */
+static volatile uint32_t swtimer_now = 0;
+
+/* Private function prototypes */
+static void SwTimer_Insert(SwTimer_t *timer);
+static void SwTimer_Unlink(SwTimer_t *timer);
+static void SwTimer_PendLink(SwTimer_t *timer);
+static void SwTimer_PendUnlink(SwTimer_t *timer);
+static void SwTimer_Cascade(uint8_t level, uint32_t slot);
+
+/**
+  * @brief  Initialize a timer object
+  * @param  timer: Caller-owned timer (static or long-lived)
+  * @param  callback: Function called on expiry
+  * @param  arg: Argument passed to the callback
+  * @param  mode: SWTIMER_ISR or SWTIMER_DEFERRED
+  * @retval None
+  */
+void SwTimer_Init(SwTimer_t *timer, SwTimer_Callback_t callback, void *arg, SwTimer_Mode_t mode)
+{
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->pend_next = NULL;
+    timer->pend_pprev = NULL;
+    timer->expires = 0;
+    timer->period = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->mode = mode;
+    timer->missed = 0;
+}
+
+/**
+  * @brief  Start or restart a timer
+  * @param  timer: Initialized timer
+  * @param  delay_ms: Time to first expiry (at least this many ms)
+  * @param  period_ms: Reload period, 0 = one-shot
+  * @note   O(1); may be called from interrupts and from callbacks
+  * @retval None
+  */
+void SwTimer_Start(SwTimer_t *timer, uint32_t delay_ms, uint32_t period_ms)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    if(timer->pprev != NULL)
+    {
+        SwTimer_Unlink(timer);
+    }
+    if(timer->pend_pprev != NULL)
+    {
+        SwTimer_PendUnlink(timer);
+    }
+
+    timer->expires = swtimer_now + delay_ms;
+    timer->period = period_ms;
+    timer->missed = 0;
+    SwTimer_Insert(timer);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Stop a timer and drop a pending deferred callback
+  * @param  timer: Initialized timer
+  * @note   O(1); may be called from interrupts and from callbacks
+  * @retval None
+  */
+void SwTimer_Stop(SwTimer_t *timer)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    if(timer->pprev != NULL)
+    {
+        SwTimer_Unlink(timer);
+    }
+    if(timer->pend_pprev != NULL)
+    {
+        SwTimer_PendUnlink(timer);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Check whether a timer is running or has a callback pending
+  * @param  timer: Initialized timer
+  * @retval 1 = active, 0 = stopped or one-shot already run
+  */
+uint8_t SwTimer_IsActive(const SwTimer_t *timer)
+{
+    return (timer->pprev != NULL || timer->pend_pprev != NULL);
+}
+
+/**
+  * @brief  Run expired SWTIMER_DEFERRED callbacks
+  * @param  None
+  * @note   Call from the main loop. A timer that expires again before its
+  *         callback has run is reported once and counted in timer->missed.
+  * @retval None
+  */
+void SwTimer_Process(void)
+{
+    SwTimer_t *timer;
+    SwTimer_Callback_t callback;
+    void *arg;
+
+    while(1)
+    {
+        __disable_irq();
+
+        timer = swtimer_pending;
+        if(timer == NULL)
+        {
+            __enable_irq();
+            break;
+        }
+
+        SwTimer_PendUnlink(timer);
+        callback = timer->callback;
+        arg = timer->arg;
+
+        __enable_irq();
+
+        callback(arg);
+    }
+}
+
+/**
+  * @brief  Advance the wheel by one tick
+  * @param  None
+  * @note   Called from SysTick_Handler every millisecond
+  * @retval None
+  */
+RAMFUNC void SwTimer_Tick(void)
+{
+    SwTimer_t *list;
+    SwTimer_t *timer;
+    SwTimer_Callback_t callback;
+    void *arg;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+    uint8_t level;
+
+    __disable_irq();
+
+    now = swtimer_now;
+
+    /* At the start of each level-N block, move its timers one level down */
+    for(level = 1; level < SWTIMER_LEVELS; level++)
+    {
+        if((now & (SWTIMER_RANGE(level - 1) - 1)) != 0)
+        {
+            break;
+        }
+        SwTimer_Cascade(level, (now >> (SWTIMER_SLOT_BITS * level)) & SWTIMER_MASK);
+    }
+
+    /* Detach this tick's slot; timers started by callbacks land in later slots */
+    list = swtimer_wheel[0][now & SWTIMER_MASK];
+    swtimer_wheel[0][now & SWTIMER_MASK] = NULL;
+    if(list != NULL)
+    {
+        list->pprev = &list;
+    }
+    swtimer_now = now + 1;
+
+    while(list != NULL)
+    {
+        timer = list;
+        SwTimer_Unlink(timer);
+
+        if(timer->period != 0)
+        {
+            timer->expires += timer->period;
+            SwTimer_Insert(timer);
+        }
+
+        callback = NULL;
+        arg = timer->arg;
+        if(timer->mode == SWTIMER_ISR)
+        {
+            callback = timer->callback;
+        }
+        else if(timer->pend_pprev != NULL)
+        {
+            timer->missed++;
+        }
+        else
+        {
+            SwTimer_PendLink(timer);
+        }
+
+        /* Callbacks may start or stop any timer, including ones still in list */
+        if(callback != NULL)
+        {
+            __set_PRIMASK(primask);
+            callback(arg);
+            __disable_irq();
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Count the upcoming ticks in which no timer expires
+  * @param  None
+  * @note   Call with interrupts disabled. Timers above level 0 are assumed
+  *         to expire at the start of their slot, so the result may be early
+  *         but never late.
+  * @retval Ticks after the next one that can be skipped (0 = a timer may
+  *         expire on the next tick), SWTIMER_NO_EXPIRY if the wheel is empty
+  */
+uint32_t SwTimer_NextExpiry(void)
+{
+    uint32_t now = swtimer_now;
+    uint32_t best = SWTIMER_NO_EXPIRY;
+    uint32_t range;
+    uint32_t start;
+    uint32_t first;
+    uint32_t i;
+    uint8_t level;
+
+    for(i = 0; i < SWTIMER_SLOTS; i++)
+    {
+        if(swtimer_wheel[0][(now + i) & SWTIMER_MASK] != NULL)
+        {
+            best = i;
+            break;
+        }
+    }
+
+    /* Level n slots hold blocks of SWTIMER_RANGE(n - 1) ticks, cascaded when
+     * now reaches the block start; scan forward from the next block */
+    for(level = 1; level < SWTIMER_LEVELS; level++)
+    {
+        range = SWTIMER_RANGE(level - 1);
+        start = (now + range - 1) & ~(range - 1);
+        first = (start >> (SWTIMER_SLOT_BITS * level)) & SWTIMER_MASK;
+
+        for(i = 0; i < SWTIMER_SLOTS; i++)
+        {
+            if(swtimer_wheel[level][(first + i) & SWTIMER_MASK] != NULL)
+            {
+                if(start - now + i * range < best)
+                {
+                    best = start - now + i * range;
+                }
+                break;
+            }
+        }
+    }
+
+    return best;
+}
+
+/**
+  * @brief  Check for SWTIMER_DEFERRED callbacks waiting for SwTimer_Process()
+  * @param  None
+  * @retval 1 = pending, 0 = none
+  */
+uint8_t SwTimer_IsPending(void)
+{
+    return (swtimer_pending != NULL);
+}
+
+/**
+  * @brief  Link a timer into the wheel slot for its expiry time
+  * @param  timer: Timer not currently in the wheel
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void SwTimer_Insert(SwTimer_t *timer)
+{
+    uint32_t expires = timer->expires;
+    uint32_t delta = expires - swtimer_now;
+    SwTimer_t **head;
+    uint8_t level;
+
+    if((int32_t)delta < 0)
+    {
+        /* Already due: run on the next tick */
+        expires = swtimer_now;
+        delta = 0;
+    }
+    else if(delta >= SWTIMER_RANGE(SWTIMER_LEVELS - 1))
+    {
+        /* Beyond the wheel: park in the farthest slot, re-cascaded later */
+        delta = SWTIMER_RANGE(SWTIMER_LEVELS - 1) - 1;
+        expires = swtimer_now + delta;
+    }
+
+    for(level = 0; level < SWTIMER_LEVELS - 1; level++)
+    {
+        if(delta < SWTIMER_RANGE(level))
+        {
+            break;
+        }
+    }
+
+    head = &swtimer_wheel[level][(expires >> (SWTIMER_SLOT_BITS * level)) & SWTIMER_MASK];
+
+    timer->next = *head;
+    if(timer->next != NULL)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+/**
+  * @brief  Remove a timer from its wheel slot
+  * @param  timer: Timer in the wheel
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void SwTimer_Unlink(SwTimer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if(timer->next != NULL)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/**
+  * @brief  Add a deferred timer to the pending list
+  * @param  timer: Timer not currently pending
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void SwTimer_PendLink(SwTimer_t *timer)
+{
+    timer->pend_next = swtimer_pending;
+    if(timer->pend_next != NULL)
+    {
+        timer->pend_next->pend_pprev = &timer->pend_next;
+    }
+    swtimer_pending = timer;
+    timer->pend_pprev = &swtimer_pending;
+}
+
+/**
+  * @brief  Remove a timer from the pending list
+  * @param  timer: Pending timer
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void SwTimer_PendUnlink(SwTimer_t *timer)
+{
+    *timer->pend_pprev = timer->pend_next;
+    if(timer->pend_next != NULL)
+    {
+        timer->pend_next->pend_pprev = timer->pend_pprev;
+    }
+    timer->pend_next = NULL;
+    timer->pend_pprev = NULL;
+}
+
+/**
+  * @brief  Re-insert all timers of a higher-level slot
+  * @param  level: Wheel level (1 .. SWTIMER_LEVELS - 1)
+  * @param  slot: Slot index
+  * @note   Call with interrupts disabled
+  * @retval None
+  */
+static void SwTimer_Cascade(uint8_t level, uint32_t slot)
+{
+    SwTimer_t *timer = swtimer_wheel[level][slot];
+    SwTimer_t *next;
+
+    swtimer_wheel[level][slot] = NULL;
+
+    while(timer != NULL)
+    {
+        next = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        SwTimer_Insert(timer);
+        timer = next;
+    }
+}
@@ -7,10 +7,18 @@
   */
 
 #include "stm32f1xx.h"
+#include "system_stm32f1xx.h"
 
 /* System Clock Frequency */
 uint32_t SystemCoreClock = 72000000; /* 72 MHz */
 
+/* Oscillator frequencies */
+#define HSI_VALUE    8000000U
+#define HSE_VALUE    8000000U
+
+/* AHB prescaler shift for each HPRE code */
+static const uint8_t AHBPrescTable[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
+
 /**
   * @brief  Setup the microcontroller system
   *         Initialize the Embedded Flash Interface, the PLL and update the 
@@ -27,10 +35,11 @@ void SystemInit(void)
   /* Reset SW, HPRE, PPRE1, PPRE2, ADCPRE and MCO bits */
   RCC->CFGR &= (uint32_t)0xF0FF0000;
   
-  /* Reset HSEON, CSSON and PLLON bits */
-  RCC->CR &= (uint32_t)0xFEF6FFFF;
+  /* Reset CSSON and PLLON bits; HSEON stays set if Reset_Handler already
+     started the crystal, so its start-up overlaps the RAM initialization */
+  RCC->CR &= (uint32_t)0xFEF7FFFF;
 
-  /* Reset HSEBYP bit */
+  /* Reset HSEBYP bit (ignored while HSE is on; 0 after reset anyway) */
   RCC->CR &= (uint32_t)0xFFFBFFFF;
 
   /* Reset PLLSRC, PLLXTPRE, PLLMUL and USBPRE/OTGFSPRE bits */
@@ -39,6 +48,9 @@ void SystemInit(void)
   /* Configure the System clock source, PLL Multiplier and Divider factors, 
      AHB/APBx prescalers and Flash settings */
   SetSysClock();
+
+  /* Report the clock actually running (HSI fallback if HSE failed) */
+  SystemCoreClockUpdate();
 }
 
 /**
@@ -112,19 +124,81 @@ static void SetSysClock(void)
   }
   else
   { 
-    /* If HSE fails to start-up, the application will have wrong clock 
-       configuration. User can add here some code to deal with this error */
+    /* HSE failed to start: PLLCLK = HSI/2 * 16 = 64 MHz */
+    RCC->CR &= (uint32_t)~0x00010000;
+
+    /* Enable Prefetch Buffer, Flash 2 wait state */
+    *(volatile uint32_t*)0x40022000 |= 0x00000010;
+    *(volatile uint32_t*)0x40022000 &= (uint32_t)((uint32_t)~0x03);
+    *(volatile uint32_t*)0x40022000 |= (uint32_t)0x02;
+
+    /* PCLK1 = HCLK/2 */
+    RCC->CFGR |= (uint32_t)0x00000400;
+
+    /* PLLSRC = HSI/2, PLLMUL = 16 */
+    RCC->CFGR &= (uint32_t)0xFFC0FFFF;
+    RCC->CFGR |= (uint32_t)0x00380000;
+
+    /* Enable PLL and wait till it is ready */
+    RCC->CR |= 0x01000000;
+    while((RCC->CR & 0x02000000) == 0)
+    {
+    }
+
+    /* Select PLL as system clock source */
+    RCC->CFGR &= (uint32_t)((uint32_t)~0x00000003);
+    RCC->CFGR |= (uint32_t)0x00000002;
+    while ((RCC->CFGR & (uint32_t)0x0000000C) != (uint32_t)0x08)
+    {
+    }
   }
 }
 
 /**
   * @brief  Update SystemCoreClock variable according to Clock Register Values.
+  * @note   Called by SystemInit() and Clock_SetSysclk() (clock.c)
   * @param  None
   * @retval None
   */
 void SystemCoreClockUpdate(void)
 {
-  /* This function updates the SystemCoreClock variable */
-  SystemCoreClock = 72000000;
+  uint32_t tmp, pllmull;
+
+  /* Get SYSCLK source */
+  tmp = RCC->CFGR & 0x0000000C;
+
+  switch (tmp)
+  {
+    case 0x04:  /* HSE used as system clock */
+      SystemCoreClock = HSE_VALUE;
+      break;
+    case 0x08:  /* PLL used as system clock */
+      pllmull = ((RCC->CFGR & 0x003C0000) >> 18) + 2;
+      if (pllmull > 16)
+      {
+        pllmull = 16;
+      }
+      if ((RCC->CFGR & 0x00010000) == 0)
+      {
+        /* HSI oscillator clock divided by 2 selected as PLL clock entry */
+        SystemCoreClock = (HSI_VALUE >> 1) * pllmull;
+      }
+      else if ((RCC->CFGR & 0x00020000) != 0)
+      {
+        /* HSE oscillator clock divided by 2 selected as PLL clock entry */
+        SystemCoreClock = (HSE_VALUE >> 1) * pllmull;
+      }
+      else
+      {
+        SystemCoreClock = HSE_VALUE * pllmull;
+      }
+      break;
+    default:    /* HSI used as system clock */
+      SystemCoreClock = HSI_VALUE;
+      break;
+  }
+
+  /* HCLK = SYSCLK >> AHB prescaler */
+  SystemCoreClock >>= AHBPrescTable[(RCC->CFGR & 0x000000F0) >> 4];
 }
 
@@ -7,37 +7,44 @@
 
 #include "uart.h"
 #include "system_stm32f1xx.h"
+#include "profile.h"
+#include "clock.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <stddef.h>
+
+/* Baud rates set by UART_Init (USART1, USART2), 0 = not in use */
+static uint32_t uart_baudrate[2] = { 0, 0 };
+static Clock_Notifier_t uart_clock_notifier;
+
+/* Private function prototypes */
+static uint32_t *UART_Baudrate(USART_TypeDef *USARTx);
+static void UART_SetBrr(USART_TypeDef *USARTx, uint32_t baudrate, const Clock_Freq_t *freq);
+static void UART_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg);
 
 /**
   * @brief  Initialize UART
   * @param  USARTx: USART peripheral (USART1, USART2)
   * @param  baudrate: Baud rate (e.g., 9600, 115200)
+  * @note   The baud rate is kept across Clock_SetSysclk()
   * @retval None
   */
 void UART_Init(USART_TypeDef *USARTx, uint32_t baudrate)
 {
-    uint32_t apbclock;
-    uint32_t mantissa;
-    uint32_t fraction;
+    Clock_Freq_t freq;
+    uint32_t *saved = UART_Baudrate(USARTx);
     
-    /* Determine APB clock frequency */
-    if(USARTx == USART1)
+    if(saved != NULL)
     {
-        apbclock = SystemCoreClock; /* APB2 = 72MHz */
+        *saved = baudrate;
     }
-    else
+    if(uart_clock_notifier.callback == NULL)
     {
-        apbclock = SystemCoreClock / 2; /* APB1 = 36MHz */
+        Clock_Register(&uart_clock_notifier, UART_ClockChanged, NULL);
     }
     
-    /* Calculate baud rate register value */
-    uint32_t divider = (apbclock * 25) / (4 * baudrate);
-    mantissa = divider / 100;
-    fraction = ((divider - (mantissa * 100)) * 16 + 50) / 100;
-    
-    USARTx->BRR = (mantissa << 4) | (fraction & 0x0F);
+    Clock_GetFreq(&freq);
+    UART_SetBrr(USARTx, baudrate, &freq);
     
     /* Enable USART, Transmitter and Receiver */
     USARTx->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
@@ -99,6 +106,7 @@ void UART_Printf(USART_TypeDef *USARTx, const char *format, ...)
 {
     char buffer[128];
     va_list args;
+    PROFILE_SCOPE(PROFILE_ZONE_UART_PRINTF);
     
     va_start(args, format);
     vsnprintf(buffer, sizeof(buffer), format, args);
@@ -107,3 +115,74 @@ void UART_Printf(USART_TypeDef *USARTx, const char *format, ...)
     UART_SendString(USARTx, buffer);
 }
 
+/**
+  * @brief  Saved baud rate of a USART
+  * @param  USARTx: USART peripheral
+  * @retval Pointer into uart_baudrate, NULL for an unknown peripheral
+  */
+static uint32_t *UART_Baudrate(USART_TypeDef *USARTx)
+{
+    if(USARTx == USART1)
+    {
+        return &uart_baudrate[0];
+    }
+    if(USARTx == USART2)
+    {
+        return &uart_baudrate[1];
+    }
+
+    return NULL;
+}
+
+/**
+  * @brief  Program the baud rate register
+  * @param  USARTx: USART peripheral
+  * @param  baudrate: Baud rate
+  * @param  freq: Clock tree (USART1 on APB2, USART2 on APB1)
+  * @retval None
+  */
+static void UART_SetBrr(USART_TypeDef *USARTx, uint32_t baudrate, const Clock_Freq_t *freq)
+{
+    uint32_t apbclock = (USARTx == USART1) ? freq->pclk2 : freq->pclk1;
+    uint32_t divider;
+    uint32_t mantissa;
+    uint32_t fraction;
+    
+    /* Calculate baud rate register value */
+    divider = (apbclock * 25) / (4 * baudrate);
+    mantissa = divider / 100;
+    fraction = ((divider - (mantissa * 100)) * 16 + 50) / 100;
+    
+    /* A fraction that rounds up to 16 carries into the mantissa */
+    USARTx->BRR = (mantissa << 4) + fraction;
+}
+
+/**
+  * @brief  Finish the current frame, then follow the new bus clock
+  * @param  event: CLOCK_EVENT_PRE or CLOCK_EVENT_POST
+  * @param  freq: Clock tree
+  * @param  arg: Unused
+  * @note   A frame being received during the switch is lost
+  * @retval None
+  */
+static void UART_ClockChanged(Clock_Event_t event, const Clock_Freq_t *freq, void *arg)
+{
+    static USART_TypeDef * const ports[2] = { USART1, USART2 };
+    uint8_t i;
+
+    for(i = 0; i < 2; i++)
+    {
+        if(uart_baudrate[i] == 0)
+        {
+            continue;
+        }
+        if(event == CLOCK_EVENT_PRE)
+        {
+            while(!(ports[i]->SR & USART_SR_TC));
+        }
+        else
+        {
+            UART_SetBrr(ports[i], uart_baudrate[i], freq);
+        }
+    }
+}
@@ -24,6 +24,12 @@
 .word _sbss
 /* end address for the .bss section */
 .word _ebss
+/* start address for the initialization values of the .ramfunc section */
+.word _siramfunc
+/* start address for the .ramfunc section */
+.word _sramfunc
+/* end address for the .ramfunc section */
+.word _eramfunc
 
 .section .text.Reset_Handler
   .weak Reset_Handler
@@ -32,39 +38,59 @@ Reset_Handler:
   ldr   r0, =_estack
   mov   sp, r0          /* set stack pointer */
 
+/* Count cycles from reset for the boot checkpoints (boot.h). CYCCNT is
+   only cleared by a power-on reset, so clear it here. */
+  ldr r0, =0xE000EDFC   /* CoreDebug->DEMCR */
+  ldr r1, [r0]
+  orr r1, r1, #0x01000000 /* TRCENA */
+  str r1, [r0]
+  ldr r0, =0xE0001000   /* DWT->CTRL */
+  movs r1, #0
+  str r1, [r0, #4]      /* DWT->CYCCNT */
+  ldr r1, [r0]
+  orr r1, r1, #1        /* CYCCNTENA */
+  str r1, [r0]
+
+/* Start the HSE crystal now so it settles while RAM is initialized;
+   SystemInit leaves HSEON set */
+  ldr r0, =0x40021000   /* RCC->CR */
+  ldr r1, [r0]
+  orr r1, r1, #0x00010000 /* HSEON */
+  str r1, [r0]
+
+/* Copy the RAM functions from flash to SRAM */
+  ldr r0, =_sramfunc
+  ldr r1, =_eramfunc
+  ldr r2, =_siramfunc
+  bl CopyWords
+
 /* Copy the data segment initializers from flash to SRAM */
   ldr r0, =_sdata
   ldr r1, =_edata
   ldr r2, =_sidata
-  movs r3, #0
-  b LoopCopyDataInit
-
-CopyDataInit:
-  ldr r4, [r2, r3]
-  str r4, [r0, r3]
-  adds r3, r3, #4
-
-LoopCopyDataInit:
-  adds r4, r0, r3
-  cmp r4, r1
-  bcc CopyDataInit
-  
-/* Zero fill the bss segment. */
-  ldr r2, =_sbss
-  ldr r4, =_ebss
-  movs r3, #0
-  b LoopFillZerobss
-
-FillZerobss:
-  str  r3, [r2]
-  adds r2, r2, #4
+  bl CopyWords
 
-LoopFillZerobss:
-  cmp r2, r4
-  bcc FillZerobss
+/* Zero fill the bss segment. */
+  ldr r0, =_sbss
+  ldr r1, =_ebss
+  movs r2, #0
+  bl FillWords
 
 /* Call the clock system initialization function.*/
   bl  SystemInit
+/* Record when the core clock was up: cycles before this ran on the HSI */
+  ldr r0, =0xE0001004   /* DWT->CYCCNT */
+  ldr r0, [r0]
+  ldr r1, =boot_clock_cycles
+  str r0, [r1]
+
+/* Paint the heap and main stack area for high-water marks (memstat.h),
+   now at full clock speed */
+  ldr r0, =_end
+  ldr r1, =_estack
+  ldr r2, =0xA5A5A5A5
+  bl FillWords
+
 /* Call static constructors */
   bl __libc_init_array
 /* Call the application's entry point.*/
@@ -75,6 +101,66 @@ LoopForever:
 
 .size Reset_Handler, .-Reset_Handler
 
+/**
+ * @brief  Copy words from flash to SRAM, 32 bytes per iteration
+ * @param  r0: Destination start, r1: destination end, r2: source
+ * @note   Word-aligned sections; clobbers r0, r2-r11
+*/
+  .section .text.CopyWords,"ax",%progbits
+  .type CopyWords, %function
+CopyWords:
+  subs r3, r1, r0
+  cmp r3, #32
+  blo CopyWordsTail
+  ldmia r2!, {r4-r11}
+  stmia r0!, {r4-r11}
+  b CopyWords
+
+CopyWordsTail:
+  cmp r0, r1
+  bhs CopyWordsDone
+  ldr r3, [r2], #4
+  str r3, [r0], #4
+  b CopyWordsTail
+
+CopyWordsDone:
+  bx lr
+  .size CopyWords, .-CopyWords
+
+/**
+ * @brief  Fill words with a value, 32 bytes per iteration
+ * @param  r0: Start, r1: end, r2: fill value
+ * @note   Word-aligned area; clobbers r0, r3-r10. Uses no stack, so it
+ *         may fill the stack area itself.
+*/
+  .section .text.FillWords,"ax",%progbits
+  .type FillWords, %function
+FillWords:
+  mov r3, r2
+  mov r4, r2
+  mov r5, r2
+  mov r6, r2
+  mov r7, r2
+  mov r8, r2
+  mov r9, r2
+
+FillWordsBlock:
+  subs r10, r1, r0
+  cmp r10, #32
+  blo FillWordsTail
+  stmia r0!, {r2-r9}
+  b FillWordsBlock
+
+FillWordsTail:
+  cmp r0, r1
+  bhs FillWordsDone
+  str r2, [r0], #4
+  b FillWordsTail
+
+FillWordsDone:
+  bx lr
+  .size FillWords, .-FillWords
+
 /**
  * @brief  This is the code that gets called when the processor receives an
  *         unexpected interrupt.
@@ -22,9 +22,6 @@
 
 int main(void)
 {
-    /* 系统初始化 */
-    SystemInit();
-    
     /* 使能 GPIOC 时钟 */
     RCC->APB2ENR |= RCC_APB2ENR_IOPCEN;
     
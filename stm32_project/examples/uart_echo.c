@@ -30,9 +30,6 @@ int main(void)
 {
     char received_char;
     
-    /* 系统初始化 */
-    SystemInit();
-    
     /* 使能时钟 */
     RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;   // GPIOA
     RCC->APB2ENR |= RCC_APB2ENR_IOPCEN;   // GPIOC (LED)
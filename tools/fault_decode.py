@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Decode a crash record printed by Fault_Print() against the firmware ELF.
+
+The firmware (stm32_project/Core/Src/fault.c) prints the record between
+"*** FAULT ***" and "*** END ***" on the first boot after a fault; anything
+else on the port or in the log is ignored. Addresses are resolved with
+arm-none-eabi-addr2line (set ADDR2LINE to use another one), and the fault
+status registers are explained bit by bit.
+
+Usage: python3 tools/fault_decode.py build/stm32f103_project.elf /dev/ttyUSB0|log.txt [baudrate]
+Reading from a port requires pyserial (pip install pyserial).
+"""
+
+import os
+import stat
+import subprocess
+import sys
+
+CFSR_BITS = [
+    (0, "IACCVIOL", "instruction fetch from an execute-never region"),
+    (1, "DACCVIOL", "data access violation (MMFAR)"),
+    (3, "MUNSTKERR", "MemManage fault on exception return unstacking"),
+    (4, "MSTKERR", "MemManage fault on exception entry stacking"),
+    (8, "IBUSERR", "bus error on instruction fetch"),
+    (9, "PRECISERR", "precise data bus error (BFAR)"),
+    (10, "IMPRECISERR", "imprecise data bus error, pc is after the access"),
+    (11, "UNSTKERR", "bus fault on exception return unstacking"),
+    (12, "STKERR", "bus fault on exception entry stacking (stack overflow?)"),
+    (16, "UNDEFINSTR", "undefined instruction"),
+    (17, "INVSTATE", "invalid EPSR state (call to an even address?)"),
+    (18, "INVPC", "invalid EXC_RETURN on exception return"),
+    (19, "NOCP", "coprocessor instruction"),
+    (24, "UNALIGNED", "unaligned access"),
+    (25, "DIVBYZERO", "integer division by zero"),
+]
+
+HFSR_BITS = [
+    (1, "VECTTBL", "bus fault on vector table read"),
+    (30, "FORCED", "escalated configurable fault (see CFSR)"),
+    (31, "DEBUGEVT", "debug event"),
+]
+
+
+def read_record(lines):
+    """Return the key/value pairs of the first complete record."""
+    record = None
+    for line in lines:
+        line = line.strip()
+        if line == "*** FAULT ***":
+            record = {}
+        elif record is None:
+            continue
+        elif line == "*** END ***":
+            return record
+        elif line:
+            key, _, value = line.partition(" ")
+            record[key] = value.split()
+    return None
+
+
+def serial_lines(port, baud):
+    import serial
+
+    with serial.Serial(port, baud, timeout=None) as ser:
+        print("waiting for a fault record on %s ..." % port)
+        while True:
+            yield ser.readline().decode("ascii", "replace")
+
+
+def symbolize(elf, addrs):
+    """Map addresses to "function at file:line" with addr2line."""
+    tool = os.environ.get("ADDR2LINE", "arm-none-eabi-addr2line")
+    args = [tool, "-e", elf, "-f", "-p", "-C"] + ["0x%08x" % a for a in addrs]
+    try:
+        out = subprocess.run(args, capture_output=True, text=True, check=True).stdout
+    except (OSError, subprocess.CalledProcessError) as err:
+        print("addr2line failed: %s" % err)
+        return ["?"] * len(addrs)
+    names = out.strip().splitlines()
+    return names + ["?"] * (len(addrs) - len(names))
+
+
+def explain(value, bits):
+    return ["  %-12s %s" % (name, text) for bit, name, text in bits if value & (1 << bit)]
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__.strip().splitlines()[-2])
+        return 1
+
+    elf, source = sys.argv[1], sys.argv[2]
+    baud = int(sys.argv[3]) if len(sys.argv) > 3 else 115200
+
+    if os.path.exists(source) and not stat.S_ISCHR(os.stat(source).st_mode):
+        with open(source, errors="replace") as f:
+            record = read_record(f)
+    else:
+        record = read_record(serial_lines(source, baud))
+
+    if record is None:
+        print("no complete fault record found")
+        return 1
+
+    def word(key, index=0):
+        return int(record[key][index], 16)
+
+    print("%s (fault #%s since power-on)" % (" ".join(record["exception"][1:]), record["count"][0]))
+    if "bad_sp" in record["flags"]:
+        print("stack pointer 0x%08x was outside RAM, no registers saved" % word("sp"))
+
+    cfsr, hfsr = word("cfsr"), word("hfsr")
+    print("cfsr 0x%08x" % cfsr)
+    print("\n".join(explain(cfsr, CFSR_BITS)))
+    if hfsr:
+        print("hfsr 0x%08x" % hfsr)
+        print("\n".join(explain(hfsr, HFSR_BITS)))
+    if "(invalid)" not in record["mmfar"]:
+        print("mmfar 0x%08x (faulting address)" % word("mmfar"))
+    if "(invalid)" not in record["bfar"]:
+        print("bfar  0x%08x (faulting address)" % word("bfar"))
+    print("sp 0x%08x on %s" % (word("sp"), "psp (thread)" if "psp" in record["flags"] else "msp"))
+
+    # pc is the faulting instruction; lr and stack words are return
+    # addresses (Thumb bit set), step back into the call instruction
+    calls = [int(v, 16) for v in record.get("stack", [])]
+    addrs = [word("pc"), (word("lr") & ~1) - 1] + [(a & ~1) - 1 for a in calls]
+    names = symbolize(elf, addrs)
+
+    print()
+    print("pc   0x%08x  %s" % (word("pc"), names[0]))
+    print("lr   0x%08x  %s" % (word("lr"), names[1]))
+    for a, name in zip(calls, names[2:]):
+        print("     0x%08x  %s" % (a, name))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+"""Save a logic analyzer capture from the UART as a .vcd file.
+
+The firmware (Logic_ExportVCD in Core/Src/logic.c) prints the VCD text
+between "$version ..." and "$comment end $end"; anything else on the port
+is ignored, so the capture can be mixed with normal log output.
+
+Usage: python3 tools/logic_vcd.py /dev/ttyUSB0 capture.vcd [baudrate]
+Requires pyserial (pip install pyserial).
+"""
+
+import sys
+
+import serial
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__.strip().splitlines()[-2])
+        return 1
+
+    port, path = sys.argv[1], sys.argv[2]
+    baud = int(sys.argv[3]) if len(sys.argv) > 3 else 115200
+
+    lines = []
+    with serial.Serial(port, baud, timeout=None) as ser:
+        print("waiting for capture on %s ..." % port)
+        while True:
+            line = ser.readline().decode("ascii", "replace").strip()
+            if not lines and not line.startswith("$version"):
+                continue
+            lines.append(line)
+            if line == "$comment end $end":
+                break
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+    print("%s: %d lines" % (path, len(lines)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())